@@ -0,0 +1,157 @@
+// arena.c
+//
+// Arenas: memory for a job's buffers that is reused by the next job
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// A worker that runs job after job (see server.c) would otherwise ask
+// malloc() for the same vectors, read buffers and output buffer every
+// time, and large buffers come straight from the kernel and go straight
+// back. An arena hands out pieces of a block instead and takes them all
+// back at once when the job is done. If a job needs more than the block
+// holds, further blocks are chained on; ResetArena() then replaces the
+// chain with one block big enough for all of it, so after the first few
+// jobs a worker's arena is a single block that is never returned. An
+// arena past ARENA_KEEP_MAX is freed instead, so one outsized request
+// doesn't leave a worker holding that much for good.
+//
+
+
+#include <stdlib.h>
+
+#include "arena.h"
+
+
+// Function name: InitializeArena()
+// Purpose: Prepares an empty arena. No memory is allocated until the
+//          first piece is asked for.
+//
+void InitializeArena(Arena *arena)
+{
+    arena->block = NULL;
+    arena->totalSize = 0;
+}
+
+
+// Function name: AddArenaBlock()
+// Purpose: Chains on a new block of at least "size" bytes. Returns
+//          EXIT_FAILURE if it can't be allocated.
+//
+static int AddArenaBlock(Arena *arena, size_t size)
+{
+    ArenaBlock *block;
+
+    if (size < ARENA_BLOCK_SIZE)
+    {
+        size = ARENA_BLOCK_SIZE;
+    }
+    block = (ArenaBlock *)malloc(sizeof(ArenaBlock) + ARENA_ALIGNMENT + size);
+    if (block == NULL)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    block->next = arena->block;
+    block->size = size;
+    block->used = 0;
+    arena->block = block;
+    arena->totalSize += size;
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: AllocateFromArena()
+// Purpose: Returns "size" bytes from the arena, or NULL if no more memory
+//          can be had. The memory is not cleared, and stays valid until
+//          the arena is reset.
+//
+void *AllocateFromArena(Arena *arena, size_t size)
+{
+    ArenaBlock *block;
+    char *start;
+
+    // Keep every piece aligned
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+    if (arena->block == NULL || arena->block->size - arena->block->used < size)
+    {
+        if (AddArenaBlock(arena, size) != EXIT_SUCCESS)
+        {
+            return(NULL);
+        }
+    }
+
+    block = arena->block;
+    start = (char *)(((size_t)(block + 1) + ARENA_ALIGNMENT - 1) &
+                     ~(size_t)(ARENA_ALIGNMENT - 1));
+    start += block->used;
+    block->used += size;
+
+    return(start);
+}
+
+
+// Function name: ResetArena()
+// Purpose: Takes back everything handed out. An arena that had to grow is
+//          left as a single block of its whole size, so the same job again
+//          fits without allocating, unless that is more than ARENA_KEEP_MAX.
+//
+void ResetArena(Arena *arena)
+{
+    size_t totalSize = arena->totalSize;
+
+    if (totalSize > ARENA_KEEP_MAX)
+    {
+        FreeArena(arena);
+    }
+    else if (arena->block != NULL && arena->block->next != NULL)
+    {
+        FreeArena(arena);
+        // If that much can't be had, the next job will chain blocks again
+        AddArenaBlock(arena, totalSize);
+    }
+    else if (arena->block != NULL)
+    {
+        arena->block->used = 0;
+    }
+}
+
+
+// Function name: FreeArena()
+// Purpose: Returns all of the arena's blocks to the operating system.
+//
+void FreeArena(Arena *arena)
+{
+    ArenaBlock *block;
+
+    while (arena->block != NULL)
+    {
+        block = arena->block;
+        arena->block = block->next;
+        free(block);
+    }
+    arena->totalSize = 0;
+}
+
+
+// --- End of arena.c
@@ -0,0 +1,68 @@
+// arena.h
+//
+// Arenas: memory handed out a piece at a time and taken back all at once,
+// for jobs run one after another by the same worker (see arena.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef ARENA_H         // Don't define everything more than once
+#define ARENA_H         //
+
+#include <stddef.h>
+
+
+// Size of an arena's first block, and the least it grows by
+#define ARENA_BLOCK_SIZE (4 * 1024 * 1024)
+
+// Most an arena keeps between jobs; a job that needed more gives it back
+#define ARENA_KEEP_MAX (64 * 1024 * 1024)
+
+// Every piece starts on a multiple of this, which suits any type
+#define ARENA_ALIGNMENT 16
+
+
+// One block of an arena. Its memory follows the header.
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *next;    // The block filled before this one
+    size_t size;                // Bytes of memory after the header
+    size_t used;                // Bytes handed out so far
+} ArenaBlock;
+
+// An arena. Not thread-safe: each worker keeps its own.
+typedef struct
+{
+    ArenaBlock *block;          // The block being filled (NULL = none yet)
+    size_t totalSize;           // Bytes in all the blocks together
+} Arena;
+
+
+// Function prototypes
+void InitializeArena(Arena *arena);
+void *AllocateFromArena(Arena *arena, size_t size);
+void ResetArena(Arena *arena);
+void FreeArena(Arena *arena);
+
+
+#endif
+// --- End of arena.h
@@ -0,0 +1,313 @@
+// batch.c
+//
+// Batch mode: finds every job listed in a manifest or found under a
+// directory tree, and runs them all at once on a thread pool
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// A job is a folder holding the eight input files (or a section file, see
+// section.c). Its output file is
+// written into that same folder. A manifest is a text file naming one job
+// folder per line; relative folders are taken from the current working
+// directory. A failing job is reported and counted, but never stops the
+// other jobs.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "gcode.h"
+#include "batch.h"
+#include "pool.h"
+#include "section.h"
+
+
+// A growable list of job folders
+typedef struct
+{
+    char **directory;
+    int totalJobs;
+    int capacity;
+} JobList;
+
+// What every pool task needs to run its job
+typedef struct
+{
+    Job *job;
+    int *result;
+} Batch;
+
+
+// Function name: AddJob()
+// Purpose: Appends a copy of a job folder to the list. Returns EXIT_FAILURE
+//          if memory runs out.
+//
+static int AddJob(JobList *list, const char *directory)
+{
+    char **grown;
+
+    if (list->totalJobs == list->capacity)
+    {
+        list->capacity = (list->capacity == 0) ? 64 : list->capacity * 2;
+        grown = (char **)realloc(list->directory, list->capacity * sizeof(char *));
+        if (grown == NULL)
+        {
+            return(EXIT_FAILURE);
+        }
+        list->directory = grown;
+    }
+
+    list->directory[list->totalJobs] = (char *)malloc(strlen(directory) + 1);
+    if (list->directory[list->totalJobs] == NULL)
+    {
+        return(EXIT_FAILURE);
+    }
+    strcpy(list->directory[list->totalJobs++], directory);
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: IsJobDirectory()
+// Purpose: A folder is a job if it holds a section file or the first of the
+//          eight input files.
+//
+static int IsJobDirectory(const char *directory)
+{
+    Job folder;
+    char filename[MAX_PATH_LENGTH];
+    struct stat status;
+
+    InitializeJob(&folder, directory, NULL);
+    FindVectorFile(&folder, Root, Upper, X, filename);
+
+    return(HasSection(&folder) || (stat(filename, &status) == 0 && S_ISREG(status.st_mode)));
+}
+
+
+// Function name: FindJobs()
+// Purpose: Walks a directory tree and adds every job folder in it, including
+//          the top folder itself. Symbolic links are not followed.
+//
+static int FindJobs(JobList *list, const char *directory)
+{
+    DIR *folder;
+    struct dirent *entry;
+    struct stat status;
+    char path[MAX_PATH_LENGTH];
+    int result = EXIT_SUCCESS;
+
+    if (IsJobDirectory(directory))
+    {
+        result = AddJob(list, directory);
+    }
+
+    folder = opendir(directory);
+    if (folder == NULL)
+    {
+        return(result);
+    }
+    while (result == EXIT_SUCCESS && (entry = readdir(folder)) != NULL)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s" PATH_SEPARATOR "%s", directory, entry->d_name);
+        if (lstat(path, &status) == 0 && S_ISDIR(status.st_mode))
+        {
+            result = FindJobs(list, path);
+        }
+    }
+    closedir(folder);
+
+    return(result);
+}
+
+
+// Function name: ReadManifest()
+// Purpose: Adds every job folder named in a manifest file. Blank lines and
+//          lines starting with MANIFEST_COMMENT are skipped.
+//
+static int ReadManifest(JobList *list, FILE *manifest)
+{
+    char line[MAX_PATH_LENGTH];
+    char *start;
+    char *end;
+
+    while (fgets(line, sizeof(line), manifest) != NULL)
+    {
+        // Trim leading and trailing whitespace, including CR/LF
+        start = line;
+        while (*start == ' ' || *start == '\t')
+        {
+            start++;
+        }
+        end = start + strlen(start);
+        while (end > start && (end[-1] == '\n' || end[-1] == '\r' ||
+                               end[-1] == ' ' || end[-1] == '\t'))
+        {
+            *--end = '\0';
+        }
+
+        if (*start == '\0' || *start == MANIFEST_COMMENT)
+        {
+            continue;
+        }
+        if (AddJob(list, start) != EXIT_SUCCESS)
+        {
+            return(EXIT_FAILURE);
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: CompareDirectories()
+// Purpose: qsort() callback that puts job folders in alphabetical order, so
+//          batch reports don't depend on the order the filesystem lists them.
+//
+static int CompareDirectories(const void *first, const void *second)
+{
+    return(strcmp(*(char * const *)first, *(char * const *)second));
+}
+
+
+// Function name: RunBatchJob()
+// Purpose: Pool task that runs one job of the batch.
+//
+static void RunBatchJob(void *context, int index)
+{
+    Batch *batch = (Batch *)context;
+
+    batch->result[index] = RunJob(&batch->job[index]);
+}
+
+
+// Function name: RunBatch()
+// Purpose: Runs every job named by a manifest file, or found under a
+//          directory, on settings->totalThreads threads (0 = one per
+//          processor), with the given settings.
+//          Prints the folder of every failed job and a summary. Returns
+//          EXIT_FAILURE if any job failed.
+//
+int RunBatch(const char *path, const Settings *settings)
+{
+    JobList list = { NULL, 0, 0 };
+    Batch batch;
+    Job noJob;
+    FILE *manifest;
+    struct stat status;
+    int thisJob;
+    int completed = 0;
+    int result;
+
+    InitializeJob(&noJob, NULL, settings);
+
+    // Collect the job folders
+    if (stat(path, &status) == 0 && S_ISDIR(status.st_mode))
+    {
+        result = FindJobs(&list, path);
+        qsort(list.directory, list.totalJobs, sizeof(char *), CompareDirectories);
+    }
+    else
+    {
+        manifest = fopen(path, READONLY);
+        if (manifest == NULL)
+        {
+            ReportMessage(&noJob, MESSAGE_ERROR, MESSAGE_BATCH_OPENERROR, path);
+            return(EXIT_FAILURE);
+        }
+        result = ReadManifest(&list, manifest);
+        fclose(manifest);
+    }
+
+    // Prepare one independent job per folder
+    batch.job = NULL;
+    batch.result = NULL;
+    if (result == EXIT_SUCCESS && list.totalJobs == 0)
+    {
+        ReportMessage(&noJob, MESSAGE_ERROR, MESSAGE_BATCH_EMPTY, path);
+        result = EXIT_FAILURE;
+    }
+    else if (result == EXIT_SUCCESS)
+    {
+        batch.job = (Job *)malloc(list.totalJobs * sizeof(Job));
+        batch.result = (int *)malloc(list.totalJobs * sizeof(int));
+        if (batch.job == NULL || batch.result == NULL)
+        {
+            ReportMessage(&noJob, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+            result = EXIT_FAILURE;
+        }
+    }
+    else
+    {
+        ReportMessage(&noJob, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+    }
+
+    // Run them all, then report
+    if (result == EXIT_SUCCESS)
+    {
+        for (thisJob = 0; thisJob < list.totalJobs; thisJob++)
+        {
+            InitializeJob(&batch.job[thisJob], list.directory[thisJob], settings);
+        }
+
+        PoolRun(RunBatchJob, &batch, list.totalJobs, settings->totalThreads);
+
+        for (thisJob = 0; thisJob < list.totalJobs; thisJob++)
+        {
+            if (batch.result[thisJob] == EXIT_SUCCESS)
+            {
+                completed++;
+            }
+            else
+            {
+                fprintf(stderr, MESSAGE_BATCH_FAILED, list.directory[thisJob]);
+            }
+        }
+        printf(MESSAGE_BATCH_SUMMARY, completed, list.totalJobs);
+
+        if (completed != list.totalJobs)
+        {
+            result = EXIT_FAILURE;
+        }
+    }
+
+    for (thisJob = 0; thisJob < list.totalJobs; thisJob++)
+    {
+        free(list.directory[thisJob]);
+    }
+    free(list.directory);
+    free(batch.job);
+    free(batch.result);
+
+    return(result);
+}
+
+
+// --- End of batch.c
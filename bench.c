@@ -0,0 +1,1145 @@
+// bench.c
+//
+// Benchmark for the input and output stages of the GCode project. Writes
+// synthetic NACA 4- and 5-digit airfoils in the eight-file layout, times
+// each stage of a job on them, and checks the output against golden
+// digests so that a faster stage can't quietly change the G-code.
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// Each size is one job of "points" data points per half, with a unit
+// chord like the example. Points are cosine spaced from the leading edge
+// to the trailing edge. The stages are the ones RunJob() goes through for
+// the eight input files:
+//
+//   open         OpenDataFiles(): open the files, read each header
+//   allocate     AllocateMemory()
+//   read         ReadVectorData()
+//   fscanf       the same values read again one fscanf("%f") at a time, as
+//                ReadVectorData() used to; "read" is measured against it
+//   consistency  CheckVectorConsistency()
+//   emit         OutputGCode() with the built-in profile
+//
+// Every stage is run "repeat" times and the fastest run is reported, so the
+// input files are in the page cache for all but the first. Values are
+// written like OUTPUT.txt's coordinates, or with "--digits" significant
+// digits for parsers to be measured on long mantissas. A golden file
+// holds one line per airfoil and size, "root tip points bytes digest",
+// where the digest is the 64-bit FNV-1a hash of OUTPUT.txt.
+//
+// With "--stream" each size is also run once in streaming mode, in a child
+// process, and the child's peak resident set is read back with wait4().
+// Streaming is meant to run in the same few megabytes at any size, so the
+// run fails if the largest size peaks more than BENCH_STREAM_GROWTH above
+// the smallest.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gcode.h"
+#include "emit.h"
+#include "parse.h"
+
+
+#define BENCH_USAGE "Usage: %s [--points <n>[K|M]]... [--root <naca>] [--tip <naca>]\n" \
+                    "       [--repeat <n>] [--directory <folder>] [--keep] [--json]\n" \
+                    "       [--digits <n>] [--min-speedup <ratio>] [--stream]\n" \
+                    "       [--golden <file> [--update-golden]]\n"
+#define BENCH_DEFAULT_DIRECTORY "gcode_bench_data"
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_GOLDEN 256
+#define BENCH_LINE_MAX 32           // Longest generated value line, plus one
+#define BENCH_DIGITS_MAX 17         // Most significant digits --digits writes
+#define BENCH_WRITE_BUFFER (1 << 20)
+// Kilobytes the streaming peak may grow by: a small size's files don't
+// reach the ends of the eight parse blocks and the output block, so it can
+// peak up to their total below a large one
+#define BENCH_STREAM_GROWTH ((8 * PARSE_BUFFER_SIZE + OUTPUT_BUFFER_SIZE) / 1024 + 1024)
+#define PI 3.14159265358979323846
+
+// The stages that are timed, in the order they run
+enum Stage
+{
+    OpenStage,
+    AllocateStage,
+    ReadStage,
+    FscanfStage,
+    ConsistencyStage,
+    EmitStage
+};
+#define TOTAL_STAGES 6
+
+static const char *StageName[] = { "open", "allocate", "read", "fscanf", "consistency", "emit" };
+
+
+// The mean line of a NACA section, and its thickness
+typedef struct
+{
+    char name[8];           // The digits, e.g. "2412" or "23012"
+    double thickness;       // Greatest thickness, as a fraction of the chord
+    int fiveDigit;          // Nonzero for a 5-digit section
+    double camber;          // 4-digit: greatest camber
+    double position;        // 4-digit: where it is. 5-digit: the "m" where
+                            //   the two parts of the mean line meet
+    double k1;              // 5-digit mean line constants, scaled to the
+    double k21;             //   design lift (k21 is k2/k1; 0 if not reflexed)
+} NacaSection;
+
+// What one size measured
+typedef struct
+{
+    int totalPoints;
+    double best[TOTAL_STAGES];      // Fastest run of each stage, in seconds
+    double mean[TOTAL_STAGES];      // Average run
+    long long inputBytes;           // All eight input files
+    long long outputBytes;          // OUTPUT.txt
+    unsigned long long digest;      // FNV-1a of OUTPUT.txt
+    const char *golden;             // "pass", "fail" or "none"
+    double speedup;                 // How many times faster "read" is than
+                                    //   "fscanf"
+    long streamPeak;                // Peak RSS of a streamed run, in kilobytes
+                                    //   (-1 = not run or failed)
+} Measurement;
+
+// One line of a golden file
+typedef struct
+{
+    char root[8];
+    char tip[8];
+    int totalPoints;
+    long long bytes;
+    unsigned long long digest;
+} GoldenEntry;
+
+
+// Function name: ParseNaca()
+// Purpose: Reads a 4-digit ("MPTT") or 5-digit ("LPQTT") designation.
+//          Returns EXIT_FAILURE if it isn't one this generator knows.
+//
+static int ParseNaca(const char *name, NacaSection *section)
+{
+    // 5-digit mean lines by P, for a design lift of 0.3 (L = 2). The
+    // reflexed ones (Q = 1) start at P = 2.
+    static const double StandardM[] = { 0.0580, 0.1260, 0.2025, 0.2900, 0.3910 };
+    static const double StandardK1[] = { 361.4, 51.64, 15.957, 6.643, 3.230 };
+    static const double ReflexM[] = { 0.0, 0.1300, 0.2170, 0.3180, 0.4410 };
+    static const double ReflexK1[] = { 0.0, 51.990, 15.793, 6.520, 3.191 };
+    static const double ReflexK21[] = { 0.0, 0.000764, 0.00677, 0.0303, 0.1355 };
+    size_t length = strlen(name);
+    int digit[5];
+    size_t thisChar;
+
+    if (length != 4 && length != 5)
+    {
+        return(EXIT_FAILURE);
+    }
+    for (thisChar = 0; thisChar < length; thisChar++)
+    {
+        if (name[thisChar] < '0' || name[thisChar] > '9')
+        {
+            return(EXIT_FAILURE);
+        }
+        digit[thisChar] = name[thisChar] - '0';
+    }
+
+    memset(section, 0, sizeof(NacaSection));
+    strcpy(section->name, name);
+    section->thickness = (digit[length - 2] * 10 + digit[length - 1]) / 100.0;
+    if (section->thickness <= 0.0)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    if (length == 4)
+    {
+        section->camber = digit[0] / 100.0;
+        section->position = digit[1] / 10.0;
+        // Camber needs somewhere to be
+        if (section->camber > 0.0 && section->position == 0.0)
+        {
+            return(EXIT_FAILURE);
+        }
+        return(EXIT_SUCCESS);
+    }
+
+    section->fiveDigit = 1;
+    if (digit[1] < 1 || digit[1] > 5 || digit[2] > 1 || (digit[2] == 1 && digit[1] < 2))
+    {
+        return(EXIT_FAILURE);
+    }
+    if (digit[2] == 0)
+    {
+        section->position = StandardM[digit[1] - 1];
+        section->k1 = StandardK1[digit[1] - 1];
+    }
+    else
+    {
+        section->position = ReflexM[digit[1] - 1];
+        section->k1 = ReflexK1[digit[1] - 1];
+        section->k21 = ReflexK21[digit[1] - 1];
+    }
+    // The mean line scales with the design lift, 0.15 * L
+    section->k1 *= digit[0] / 2.0;
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: MeanLine()
+// Purpose: Height and slope of the section's mean line at "x" (0 to 1).
+//
+static void MeanLine(const NacaSection *section, double x, double *height, double *slope)
+{
+    double m = section->position;
+    double m3 = m * m * m;
+    double k = section->k1 / 6.0;
+    double tail;
+
+    if (!section->fiveDigit)
+    {
+        if (section->camber == 0.0)
+        {
+            *height = 0.0;
+            *slope = 0.0;
+        }
+        else if (x < m)
+        {
+            *height = section->camber / (m * m) * (2.0 * m * x - x * x);
+            *slope = 2.0 * section->camber / (m * m) * (m - x);
+        }
+        else
+        {
+            *height = section->camber / ((1.0 - m) * (1.0 - m)) *
+                      ((1.0 - 2.0 * m) + 2.0 * m * x - x * x);
+            *slope = 2.0 * section->camber / ((1.0 - m) * (1.0 - m)) * (m - x);
+        }
+        return;
+    }
+
+    if (section->k21 == 0.0)
+    {
+        if (x < m)
+        {
+            *height = k * (x * x * x - 3.0 * m * x * x + m * m * (3.0 - m) * x);
+            *slope = k * (3.0 * x * x - 6.0 * m * x + m * m * (3.0 - m));
+        }
+        else
+        {
+            *height = k * m3 * (1.0 - x);
+            *slope = -k * m3;
+        }
+        return;
+    }
+
+    // Reflexed: the same cubic on both sides, but weaker behind m
+    tail = section->k21 * (1.0 - m) * (1.0 - m) * (1.0 - m);
+    if (x < m)
+    {
+        *height = k * ((x - m) * (x - m) * (x - m) - tail * x - m3 * x + m3);
+        *slope = k * (3.0 * (x - m) * (x - m) - tail - m3);
+    }
+    else
+    {
+        *height = k * (section->k21 * (x - m) * (x - m) * (x - m) - tail * x - m3 * x + m3);
+        *slope = k * (3.0 * section->k21 * (x - m) * (x - m) - tail - m3);
+    }
+}
+
+
+// Function name: SectionPoint()
+// Purpose: Point "thisPoint" of "totalPoints" along the upper and lower
+//          surfaces, cosine spaced from the leading edge.
+//
+static void SectionPoint(const NacaSection *section, int thisPoint, int totalPoints,
+                         double *upperX, double *upperY, double *lowerX, double *lowerY)
+{
+    double x = 0.5 * (1.0 - cos(PI * thisPoint / (totalPoints - 1)));
+    double thickness;
+    double height;
+    double slope;
+    double angle;
+
+    thickness = 5.0 * section->thickness *
+                (0.2969 * sqrt(x) - 0.1260 * x - 0.3516 * x * x +
+                 0.2843 * x * x * x - 0.1015 * x * x * x * x);
+    MeanLine(section, x, &height, &slope);
+    angle = atan(slope);
+
+    *upperX = x - thickness * sin(angle);
+    *upperY = height + thickness * cos(angle);
+    *lowerX = x + thickness * sin(angle);
+    *lowerY = height - thickness * cos(angle);
+}
+
+
+// Function name: WriteValue()
+// Purpose: Adds one value line to a vector input file: formatted like
+//          OUTPUT.txt's coordinates, or given "digits", with that many
+//          significant digits (17 is what "%.17g" and Python's repr() give).
+//
+static void WriteValue(FILE *file, double value, int digits)
+{
+    char line[BENCH_LINE_MAX];
+    char *cursor;
+
+    if (digits > 0)
+    {
+        fprintf(file, "%.*g\n", digits, value);
+        return;
+    }
+    cursor = FormatFixed(line, (float)value);
+    *cursor++ = '\n';
+    fwrite(line, 1, cursor - line, file);
+}
+
+
+// Function name: GenerateSide()
+// Purpose: Writes the four input files of one side of the job. Returns
+//          EXIT_FAILURE if one can't be written.
+//
+static int GenerateSide(const Job *job, enum Side thisSide, const NacaSection *section,
+                        int totalPoints, int digits)
+{
+    FILE *file[TOTAL_HALVES][TOTAL_DIMENSIONS_PER_HALF];
+    char *buffer[TOTAL_HALVES][TOTAL_DIMENSIONS_PER_HALF];
+    char filename[MAX_PATH_LENGTH];
+    double value[TOTAL_HALVES][TOTAL_DIMENSIONS_PER_HALF];
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+    int thisPoint;
+    int result = EXIT_SUCCESS;
+
+    memset(file, 0, sizeof(file));
+    memset(buffer, 0, sizeof(buffer));
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        for (thisDimension = X; thisDimension <= Y; thisDimension++)
+        {
+            BuildVectorFilename(job, thisSide, thisHalf, thisDimension, filename);
+            file[thisHalf][thisDimension] = fopen(filename, "w");
+            buffer[thisHalf][thisDimension] = (char *)malloc(BENCH_WRITE_BUFFER);
+            if (file[thisHalf][thisDimension] == NULL || buffer[thisHalf][thisDimension] == NULL)
+            {
+                fprintf(stderr, "Can't write %s\n", filename);
+                result = EXIT_FAILURE;
+            }
+            else
+            {
+                setvbuf(file[thisHalf][thisDimension], buffer[thisHalf][thisDimension],
+                        _IOFBF, BENCH_WRITE_BUFFER);
+                fprintf(file[thisHalf][thisDimension], "%d\n", totalPoints);
+            }
+        }
+    }
+
+    for (thisPoint = 0; thisPoint < totalPoints && result == EXIT_SUCCESS; thisPoint++)
+    {
+        SectionPoint(section, thisPoint, totalPoints, &value[Upper][X], &value[Upper][Y],
+                     &value[Lower][X], &value[Lower][Y]);
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                WriteValue(file[thisHalf][thisDimension], value[thisHalf][thisDimension],
+                           digits);
+            }
+        }
+    }
+
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        for (thisDimension = X; thisDimension <= Y; thisDimension++)
+        {
+            if (file[thisHalf][thisDimension] != NULL &&
+                (ferror(file[thisHalf][thisDimension]) || fclose(file[thisHalf][thisDimension]) != 0))
+            {
+                result = EXIT_FAILURE;
+            }
+            free(buffer[thisHalf][thisDimension]);
+        }
+    }
+
+    return(result);
+}
+
+
+// Function name: FileSize()
+// Purpose: Size of a file in bytes, or 0 if it isn't there.
+//
+static long long FileSize(const char *filename)
+{
+    struct stat status;
+
+    if (stat(filename, &status) != 0)
+    {
+        return(0);
+    }
+
+    return((long long)status.st_size);
+}
+
+
+// Function name: DigestFile()
+// Purpose: 64-bit FNV-1a hash of a whole file (of an empty one if it can't
+//          be read).
+//
+static unsigned long long DigestFile(const char *filename)
+{
+    unsigned long long digest = 0xcbf29ce484222325ULL;
+    unsigned char *block;
+    size_t length;
+    size_t thisByte;
+    FILE *file;
+
+    file = fopen(filename, "rb");
+    block = (unsigned char *)malloc(BENCH_WRITE_BUFFER);
+    if (file != NULL && block != NULL)
+    {
+        while ((length = fread(block, 1, BENCH_WRITE_BUFFER, file)) > 0)
+        {
+            for (thisByte = 0; thisByte < length; thisByte++)
+            {
+                digest = (digest ^ block[thisByte]) * 0x100000001b3ULL;
+            }
+        }
+    }
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    free(block);
+
+    return(digest);
+}
+
+
+// Function name: Now()
+// Purpose: Seconds on the monotonic clock.
+//
+static double Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return(now.tv_sec + now.tv_nsec * 1e-9);
+}
+
+
+// Function name: ReadWithFscanf()
+// Purpose: Reads the eight input files into the job's vectors again, one
+//          fscanf("%f") per value, the way ReadVectorData() did before it had
+//          a parser of its own. Returns EXIT_FAILURE if a file can't be read.
+//
+static int ReadWithFscanf(Job *job)
+{
+    char filename[MAX_PATH_LENGTH];
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+    Vector *thisVector;
+    FILE *file;
+    int totalValues;
+    int thisValue;
+    int result = EXIT_SUCCESS;
+
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                thisVector = &job->thisVector[thisSide][thisHalf][thisDimension];
+                BuildVectorFilename(job, thisSide, thisHalf, thisDimension, filename);
+                file = fopen(filename, "r");
+                if (file == NULL)
+                {
+                    return(EXIT_FAILURE);
+                }
+                if (fscanf(file, "%d", &totalValues) != 1)
+                {
+                    result = EXIT_FAILURE;
+                }
+                for (thisValue = 0; thisValue < thisVector->totalValues && result == EXIT_SUCCESS;
+                     thisValue++)
+                {
+                    if (fscanf(file, "%f", &thisVector->value[thisValue]) != 1)
+                    {
+                        result = EXIT_FAILURE;
+                    }
+                }
+                fclose(file);
+                if (result != EXIT_SUCCESS)
+                {
+                    return(result);
+                }
+            }
+        }
+    }
+
+    return(result);
+}
+
+
+// Function name: TimeJob()
+// Purpose: Runs the stages of one job once, adding each stage's time to
+//          "mean" and keeping the fastest in "best". Returns EXIT_FAILURE if
+//          a stage fails.
+//
+static int TimeJob(Job *job, double *best, double *mean)
+{
+    double elapsed[TOTAL_STAGES];
+    double start;
+    int result;
+    int thisStage;
+
+    start = Now();
+    result = OpenDataFiles(job);
+    elapsed[OpenStage] = Now() - start;
+
+    start = Now();
+    if (result == EXIT_SUCCESS)
+    {
+        result = AllocateMemory(job);
+    }
+    elapsed[AllocateStage] = Now() - start;
+
+    start = Now();
+    if (result == EXIT_SUCCESS)
+    {
+        result = ReadVectorData(job);
+    }
+    elapsed[ReadStage] = Now() - start;
+
+    start = Now();
+    if (result == EXIT_SUCCESS)
+    {
+        result = ReadWithFscanf(job);
+    }
+    elapsed[FscanfStage] = Now() - start;
+
+    start = Now();
+    if (result == EXIT_SUCCESS)
+    {
+        CheckVectorConsistency(job);
+    }
+    elapsed[ConsistencyStage] = Now() - start;
+
+    start = Now();
+    if (result == EXIT_SUCCESS)
+    {
+        result = OutputGCode(job);
+    }
+    elapsed[EmitStage] = Now() - start;
+
+    FreeMemory(job);
+    CloseDataFiles(job);
+
+    for (thisStage = 0; thisStage < TOTAL_STAGES; thisStage++)
+    {
+        mean[thisStage] += elapsed[thisStage];
+        if (best[thisStage] < 0.0 || elapsed[thisStage] < best[thisStage])
+        {
+            best[thisStage] = elapsed[thisStage];
+        }
+    }
+
+    return(result);
+}
+
+
+// Function name: StageBytes()
+// Purpose: The bytes a stage moves, for its MB/s: the input files for
+//          reading, OUTPUT.txt for emitting, and none for the others.
+//
+static long long StageBytes(const Measurement *measurement, int thisStage)
+{
+    if (thisStage == ReadStage || thisStage == FscanfStage)
+    {
+        return(measurement->inputBytes);
+    }
+    if (thisStage == EmitStage)
+    {
+        return(measurement->outputBytes);
+    }
+
+    return(0);
+}
+
+
+// Function name: MeasureStreamingPeak()
+// Purpose: Runs the job once in streaming mode in a child process and
+//          returns the child's peak resident set in kilobytes, or -1 if
+//          it failed. The child starts with this process's pages, so this
+//          is called before the timed stages have allocated anything.
+//
+static long MeasureStreamingPeak(const Job *job)
+{
+    Settings settings = *job->settings;
+    Job child;
+    struct rusage usage;
+    pid_t pid;
+    int status;
+
+    settings.streaming = 1;
+    fflush(stdout);
+    fflush(stderr);
+    pid = fork();
+    if (pid < 0)
+    {
+        return(-1);
+    }
+    if (pid == 0)
+    {
+        InitializeJob(&child, job->directory, &settings);
+        _exit((RunJob(&child) == EXIT_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    while (wait4(pid, &status, 0, &usage) < 0)
+    {
+        if (errno != EINTR)
+        {
+            return(-1);
+        }
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+    {
+        return(-1);
+    }
+    return(usage.ru_maxrss);
+}
+
+
+// Function name: ReportMeasurement()
+// Purpose: Prints what one size measured, as a table or as one line of
+//          JSON.
+//
+static void ReportMeasurement(const Measurement *measurement, const NacaSection *root,
+                              const NacaSection *tip, int totalRepeats, int json)
+{
+    // Each point is one line of X, Y, U, V; there are two halves
+    double totalPoints = 2.0 * measurement->totalPoints;
+    double seconds;
+    long long bytes;
+    int thisStage;
+
+    if (json)
+    {
+        printf("{\"root\":\"%s\",\"tip\":\"%s\",\"points\":%d,\"repeat\":%d,"
+               "\"input_bytes\":%lld,\"output_bytes\":%lld,\"digest\":\"%016llx\","
+               "\"golden\":\"%s\",\"read_speedup\":%.2f,",
+               root->name, tip->name, measurement->totalPoints, totalRepeats,
+               measurement->inputBytes, measurement->outputBytes, measurement->digest,
+               measurement->golden, measurement->speedup);
+        if (measurement->streamPeak >= 0)
+        {
+            printf("\"stream_peak_kb\":%ld,", measurement->streamPeak);
+        }
+        printf("\"stages\":[");
+        for (thisStage = 0; thisStage < TOTAL_STAGES; thisStage++)
+        {
+            seconds = (measurement->best[thisStage] > 0.0) ? measurement->best[thisStage] : 1e-9;
+            bytes = StageBytes(measurement, thisStage);
+            printf("%s{\"stage\":\"%s\",\"seconds\":%.9f,\"mean_seconds\":%.9f,"
+                   "\"points_per_second\":%.0f,",
+                   (thisStage > 0) ? "," : "", StageName[thisStage],
+                   measurement->best[thisStage], measurement->mean[thisStage],
+                   totalPoints / seconds);
+            if (bytes > 0)
+            {
+                printf("\"mb_per_second\":%.3f}", bytes / seconds / 1e6);
+            }
+            else
+            {
+                printf("\"mb_per_second\":null}");
+            }
+        }
+        printf("]}\n");
+        return;
+    }
+
+    printf("NACA %s root, NACA %s tip, %d points per half, best of %d\n",
+           root->name, tip->name, measurement->totalPoints, totalRepeats);
+    printf("  input %lld bytes, output %lld bytes, digest %016llx, golden %s\n",
+           measurement->inputBytes, measurement->outputBytes, measurement->digest,
+           measurement->golden);
+    printf("  %-12s %12s %12s %14s %10s\n", "stage", "seconds", "mean", "points/s", "MB/s");
+    for (thisStage = 0; thisStage < TOTAL_STAGES; thisStage++)
+    {
+        seconds = (measurement->best[thisStage] > 0.0) ? measurement->best[thisStage] : 1e-9;
+        bytes = StageBytes(measurement, thisStage);
+        printf("  %-12s %12.6f %12.6f %14.0f ", StageName[thisStage],
+               measurement->best[thisStage], measurement->mean[thisStage], totalPoints / seconds);
+        if (bytes > 0)
+        {
+            printf("%10.1f\n", bytes / seconds / 1e6);
+        }
+        else
+        {
+            printf("%10s\n", "-");
+        }
+    }
+    printf("  read is %.1fx as fast as fscanf\n", measurement->speedup);
+    if (measurement->streamPeak >= 0)
+    {
+        printf("  streamed in a peak of %ld KB\n", measurement->streamPeak);
+    }
+    printf("\n");
+}
+
+
+// Function name: ReadGolden()
+// Purpose: Reads the entries of a golden file. A missing file has none.
+//          Returns the number of entries.
+//
+static int ReadGolden(const char *filename, GoldenEntry *entry)
+{
+    char line[256];
+    int totalEntries = 0;
+    FILE *file;
+
+    file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        return(0);
+    }
+    while (fgets(line, sizeof(line), file) != NULL && totalEntries < BENCH_MAX_GOLDEN)
+    {
+        if (line[0] != '#' &&
+            sscanf(line, "%7s %7s %d %lld %llx", entry[totalEntries].root, entry[totalEntries].tip,
+                   &entry[totalEntries].totalPoints, &entry[totalEntries].bytes,
+                   &entry[totalEntries].digest) == 5)
+        {
+            totalEntries++;
+        }
+    }
+    fclose(file);
+
+    return(totalEntries);
+}
+
+
+// Function name: FindGolden()
+// Purpose: The entry for an airfoil and size, or NULL if there isn't one.
+//
+static GoldenEntry *FindGolden(GoldenEntry *entry, int totalEntries, const char *root,
+                               const char *tip, int totalPoints)
+{
+    int thisEntry;
+
+    for (thisEntry = 0; thisEntry < totalEntries; thisEntry++)
+    {
+        if (strcmp(entry[thisEntry].root, root) == 0 && strcmp(entry[thisEntry].tip, tip) == 0 &&
+            entry[thisEntry].totalPoints == totalPoints)
+        {
+            return(&entry[thisEntry]);
+        }
+    }
+
+    return(NULL);
+}
+
+
+// Function name: WriteGolden()
+// Purpose: Writes every entry to a golden file. Returns EXIT_FAILURE if it
+//          can't be written.
+//
+static int WriteGolden(const char *filename, const GoldenEntry *entry, int totalEntries)
+{
+    FILE *file;
+    int thisEntry;
+
+    file = fopen(filename, "w");
+    if (file == NULL)
+    {
+        return(EXIT_FAILURE);
+    }
+    fprintf(file, "# gcode_bench golden output: root tip points bytes fnv1a64\n");
+    for (thisEntry = 0; thisEntry < totalEntries; thisEntry++)
+    {
+        fprintf(file, "%s %s %d %lld %016llx\n", entry[thisEntry].root, entry[thisEntry].tip,
+                entry[thisEntry].totalPoints, entry[thisEntry].bytes, entry[thisEntry].digest);
+    }
+
+    return((fclose(file) == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+// Function name: ParseSize()
+// Purpose: Reads a number of points such as "5000", "1K" or "100M".
+//          Returns 0 if it isn't one (or is fewer than two points).
+//
+static int ParseSize(const char *text)
+{
+    char *end;
+    double size;
+
+    size = strtod(text, &end);
+    if (*end == 'K' || *end == 'k')
+    {
+        size *= 1e3;
+        end++;
+    }
+    else if (*end == 'M' || *end == 'm')
+    {
+        size *= 1e6;
+        end++;
+    }
+    if (end == text || *end != '\0' || size < 2.0 || size > INT_MAX)
+    {
+        return(0);
+    }
+
+    return((int)size);
+}
+
+
+// Function name: RemoveJobFiles()
+// Purpose: Deletes the generated input files and the output file.
+//
+static void RemoveJobFiles(const Job *job)
+{
+    char filename[MAX_PATH_LENGTH];
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                BuildVectorFilename(job, thisSide, thisHalf, thisDimension, filename);
+                remove(filename);
+            }
+        }
+    }
+    BuildFilename(job, OUTPUT_FILENAME, filename);
+    remove(filename);
+}
+
+
+// Function name: MeasureSize()
+// Purpose: Generates the job for one size, times its stages and checks
+//          its output against the golden entries, measuring a streamed run
+//          first if "streaming" is nonzero. Returns EXIT_FAILURE if the job
+//          can't be generated or run.
+//
+static int MeasureSize(Job *job, const NacaSection *root, const NacaSection *tip,
+                       int totalRepeats, int digits, int streaming, Measurement *measurement)
+{
+    char filename[MAX_PATH_LENGTH];
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+    int thisStage;
+    int thisRepeat;
+
+    if (GenerateSide(job, Root, root, measurement->totalPoints, digits) != EXIT_SUCCESS ||
+        GenerateSide(job, Tip, tip, measurement->totalPoints, digits) != EXIT_SUCCESS)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    measurement->inputBytes = 0;
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                BuildVectorFilename(job, thisSide, thisHalf, thisDimension, filename);
+                measurement->inputBytes += FileSize(filename);
+            }
+        }
+    }
+
+    measurement->streamPeak = -1;
+    if (streaming && (measurement->streamPeak = MeasureStreamingPeak(job)) < 0)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    for (thisStage = 0; thisStage < TOTAL_STAGES; thisStage++)
+    {
+        measurement->best[thisStage] = -1.0;
+        measurement->mean[thisStage] = 0.0;
+    }
+    for (thisRepeat = 0; thisRepeat < totalRepeats; thisRepeat++)
+    {
+        if (TimeJob(job, measurement->best, measurement->mean) != EXIT_SUCCESS)
+        {
+            return(EXIT_FAILURE);
+        }
+    }
+    for (thisStage = 0; thisStage < TOTAL_STAGES; thisStage++)
+    {
+        measurement->mean[thisStage] /= totalRepeats;
+    }
+    measurement->speedup = measurement->best[FscanfStage] /
+                           ((measurement->best[ReadStage] > 0.0) ? measurement->best[ReadStage] : 1e-9);
+
+    BuildFilename(job, OUTPUT_FILENAME, filename);
+    measurement->outputBytes = FileSize(filename);
+    measurement->digest = DigestFile(filename);
+
+    return(EXIT_SUCCESS);
+}
+
+
+////////// MAIN PROGRAM BLOCK //////////
+int main (int argc, const char *argv[])
+{
+    Settings settings;
+    Job job;
+    NacaSection root;
+    NacaSection tip;
+    Measurement measurement;
+    GoldenEntry golden[BENCH_MAX_GOLDEN];
+    GoldenEntry *entry;
+    const char *directory = BENCH_DEFAULT_DIRECTORY;
+    const char *rootName = "2412";
+    const char *tipName = "0012";
+    const char *goldenPath = NULL;
+    char error[DIALECT_ERROR_MAX];
+    double minSpeedup = 0.0;
+    int size[BENCH_MAX_SIZES];
+    int totalSizes = 0;
+    int totalGolden = 0;
+    int totalRepeats = 3;
+    int digits = 0;
+    int streaming = 0;
+    long smallestPeak = -1;     // Streaming peaks of the smallest and largest
+    long largestPeak = -1;      //   sizes measured
+    int smallestSize = 0;
+    int largestSize = 0;
+    int keep = 0;
+    int json = 0;
+    int updating = 0;
+    int failed = 0;
+    int thisArgument;
+    int thisSize;
+
+    for (thisArgument = 1; thisArgument < argc; thisArgument++)
+    {
+        if (strcmp(argv[thisArgument], "--points") == 0 && thisArgument + 1 < argc &&
+            totalSizes < BENCH_MAX_SIZES && (size[totalSizes] = ParseSize(argv[thisArgument + 1])) > 0)
+        {
+            totalSizes++;
+            thisArgument++;
+        }
+        else if (strcmp(argv[thisArgument], "--root") == 0 && thisArgument + 1 < argc)
+        {
+            rootName = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--tip") == 0 && thisArgument + 1 < argc)
+        {
+            tipName = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--repeat") == 0 && thisArgument + 1 < argc &&
+                 atoi(argv[thisArgument + 1]) > 0)
+        {
+            totalRepeats = atoi(argv[++thisArgument]);
+        }
+        else if (strcmp(argv[thisArgument], "--digits") == 0 && thisArgument + 1 < argc &&
+                 atoi(argv[thisArgument + 1]) > 0 &&
+                 atoi(argv[thisArgument + 1]) <= BENCH_DIGITS_MAX)
+        {
+            digits = atoi(argv[++thisArgument]);
+        }
+        else if (strcmp(argv[thisArgument], "--min-speedup") == 0 && thisArgument + 1 < argc &&
+                 atof(argv[thisArgument + 1]) > 0.0)
+        {
+            minSpeedup = atof(argv[++thisArgument]);
+        }
+        else if (strcmp(argv[thisArgument], "--directory") == 0 && thisArgument + 1 < argc)
+        {
+            directory = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--golden") == 0 && thisArgument + 1 < argc)
+        {
+            goldenPath = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--update-golden") == 0)
+        {
+            updating = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--stream") == 0)
+        {
+            streaming = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--keep") == 0)
+        {
+            keep = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--json") == 0)
+        {
+            json = 1;
+        }
+        else
+        {
+            fprintf(stderr, BENCH_USAGE, argv[0]);
+            return(EXIT_FAILURE);
+        }
+    }
+    // Golden entries are for values written like OUTPUT.txt's
+    if ((updating && (goldenPath == NULL || digits > 0)) ||
+        ParseNaca(rootName, &root) != EXIT_SUCCESS || ParseNaca(tipName, &tip) != EXIT_SUCCESS)
+    {
+        fprintf(stderr, BENCH_USAGE, argv[0]);
+        return(EXIT_FAILURE);
+    }
+    if (totalSizes == 0)
+    {
+        size[totalSizes++] = 1000;
+        size[totalSizes++] = 10000;
+        size[totalSizes++] = 100000;
+        size[totalSizes++] = 1000000;
+    }
+
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Can't create %s\n", directory);
+        return(EXIT_FAILURE);
+    }
+    if (goldenPath != NULL)
+    {
+        totalGolden = ReadGolden(goldenPath, golden);
+    }
+
+    // Jobs run with the built-in profile and nothing else
+    InitializeSettings(&settings);
+    if (CompileDialect(&settings.dialect, NULL, error) != EXIT_SUCCESS)
+    {
+        fprintf(stderr, "%s\n", error);
+        return(EXIT_FAILURE);
+    }
+
+    for (thisSize = 0; thisSize < totalSizes; thisSize++)
+    {
+        InitializeJob(&job, directory, &settings);
+        measurement.totalPoints = size[thisSize];
+        if (MeasureSize(&job, &root, &tip, totalRepeats, digits, streaming, &measurement) != EXIT_SUCCESS)
+        {
+            fprintf(stderr, "NACA %s/%s with %d points failed\n", root.name, tip.name, size[thisSize]);
+            failed = 1;
+            if (!keep)
+            {
+                RemoveJobFiles(&job);
+            }
+            continue;
+        }
+
+        entry = (digits > 0) ? NULL :
+                FindGolden(golden, totalGolden, root.name, tip.name, size[thisSize]);
+        if (updating)
+        {
+            if (entry == NULL && totalGolden < BENCH_MAX_GOLDEN)
+            {
+                entry = &golden[totalGolden++];
+                strcpy(entry->root, root.name);
+                strcpy(entry->tip, tip.name);
+                entry->totalPoints = size[thisSize];
+            }
+            if (entry != NULL)
+            {
+                entry->bytes = measurement.outputBytes;
+                entry->digest = measurement.digest;
+            }
+            measurement.golden = "updated";
+        }
+        else if (entry == NULL)
+        {
+            measurement.golden = "none";
+        }
+        else if (entry->bytes == measurement.outputBytes && entry->digest == measurement.digest)
+        {
+            measurement.golden = "pass";
+        }
+        else
+        {
+            measurement.golden = "fail";
+            failed = 1;
+        }
+
+        ReportMeasurement(&measurement, &root, &tip, totalRepeats, json);
+        fflush(stdout);
+        if (measurement.speedup < minSpeedup)
+        {
+            fprintf(stderr, "NACA %s/%s with %d points: reading was %.1fx as fast as fscanf, "
+                    "not %.1fx\n", root.name, tip.name, size[thisSize], measurement.speedup,
+                    minSpeedup);
+            failed = 1;
+        }
+        if (streaming && (smallestPeak < 0 || size[thisSize] < smallestSize))
+        {
+            smallestPeak = measurement.streamPeak;
+            smallestSize = size[thisSize];
+        }
+        if (streaming && (largestPeak < 0 || size[thisSize] > largestSize))
+        {
+            largestPeak = measurement.streamPeak;
+            largestSize = size[thisSize];
+        }
+        if (!keep)
+        {
+            RemoveJobFiles(&job);
+        }
+    }
+    if (!keep)
+    {
+        remove(directory);
+    }
+
+    if (streaming && largestPeak > smallestPeak + BENCH_STREAM_GROWTH)
+    {
+        fprintf(stderr, "Streaming %d points peaked at %ld KB, but %d points at %ld KB\n",
+                largestSize, largestPeak, smallestSize, smallestPeak);
+        failed = 1;
+    }
+
+    if (updating && WriteGolden(goldenPath, golden, totalGolden) != EXIT_SUCCESS)
+    {
+        fprintf(stderr, "Can't write %s\n", goldenPath);
+        failed = 1;
+    }
+
+    FreeDialect(&settings.dialect);
+
+    return(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+////////////////////////////////////////
+
+
+// --- End of bench.c
@@ -0,0 +1,783 @@
+// cache.c
+//
+// The output cache: a folder of finished output files, each named by a
+// hash of the inputs and settings that made it
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// An entry's content key is the XXH64 hash (see hash.c) of the input
+// files' contents, every setting that changes the output (placements,
+// resampling, reduction, wire speed and the whole compiled machine
+// profile) and the program version. A job whose key is already there
+// gets the entry hard-linked into place as its OUTPUT.txt, without a
+// single value being parsed.
+//
+// Hashing the inputs still means reading them, so the cache also keeps an
+// index from the inputs' identities (device, inode, size and change times,
+// like make or ccache's direct mode) to content keys. A job whose input
+// files haven't been touched since the last time is found with a few
+// stat() calls, however large the section.
+//
+// The STATS file holds the hit, miss and eviction counts and the bytes
+// held, and is locked while it is updated, so any number of jobs and
+// processes can share a cache. Every hit refreshes the modification time
+// of what it used; when a store takes the cache past its limit, the least
+// recently used files are removed until it is back under CACHE_EVICT_TO of
+// the limit.
+//
+// Entries are shared with the OUTPUT.txt files linked to them, so the
+// output is always replaced rather than rewritten (see OutputGCode()).
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "cache.h"
+#include "hash.h"
+#include "section.h"
+
+
+// The counters kept in the STATS file
+typedef struct
+{
+    long long hits;
+    long long misses;
+    long long evictions;
+    long long bytes;        // Bytes of entries and index files held
+} CacheCounters;
+
+// One file considered for eviction
+typedef struct
+{
+    char name[32];
+    long long size;
+    time_t usedSeconds;     // Modification time: when it was last used
+    long usedNanoseconds;   //
+} CacheFile;
+
+
+
+// Function name: PrepareCache()
+// Purpose: Creates the cache folder if it isn't there yet. Returns
+//          EXIT_FAILURE, with the problem reported, if it can't be used.
+//
+int PrepareCache(const char *directory)
+{
+    struct stat status;
+
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_CACHE_OPENERROR, directory);
+        return(EXIT_FAILURE);
+    }
+    if (stat(directory, &status) != 0 || !S_ISDIR(status.st_mode) ||
+        access(directory, W_OK) != 0)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_CACHE_OPENERROR, directory);
+        return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: BuildCacheFilename()
+// Purpose: Fills in the path of a cache file named by a key.
+//
+static void BuildCacheFilename(const Job *job, unsigned long long key, const char *suffix,
+                               char *filename)
+{
+    snprintf(filename, MAX_PATH_LENGTH, "%s" PATH_SEPARATOR "%016llx%s",
+             job->settings->cacheDirectory, key, suffix);
+}
+
+
+// Function name: BuildTemporaryFilename()
+// Purpose: Fills in a name to write "filename" under until it is complete.
+//          The process ID keeps two runs sharing a cache apart.
+//
+static void BuildTemporaryFilename(const char *filename, char *temporary)
+{
+    snprintf(temporary, MAX_PATH_LENGTH, "%.*s.%ld" CACHE_TEMP_SUFFIX,
+             MAX_PATH_LENGTH - 32, filename, (long)getpid());
+}
+
+
+// Function name: ListInputFiles()
+// Purpose: Fills in the files the job reads: its section file if it has
+//          a current one, or else its eight vector files (as in
+//          LoadVectorData()). Returns how many there are.
+//
+static int ListInputFiles(const Job *job, char filename[][MAX_PATH_LENGTH])
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    int totalFiles = 0;
+
+    if (HasSection(job) && IsSectionCurrent(job, NULL))
+    {
+        BuildFilename(job, SECTION_FILENAME, filename[0]);
+        return(1);
+    }
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                FindVectorFile(job, thisSide, thisHalf, thisDimension,
+                               filename[totalFiles++]);
+            }
+        }
+    }
+
+    return(totalFiles);
+}
+
+
+// Function name: HashText()
+// Purpose: Adds a string, and its end, to a hash.
+//
+static void HashText(HashState *state, const char *text)
+{
+    AddToHash(state, text, strlen(text) + 1);
+}
+
+
+// Function name: HashSettings()
+// Purpose: Adds every setting that changes the output to a hash, one
+//          field at a time (struct padding is never hashed). Threads
+//          don't change the output, so they are left out. Streaming does:
+//          a streamed job can't resample vectors whose numbers of points
+//          disagree (see LoadVectorData()).
+//
+static void HashSettings(HashState *state, const Settings *settings)
+{
+    const Dialect *dialect = &settings->dialect;
+    const SideTransform *transform;
+    int format = CACHE_FORMAT;
+    int thisSide;
+    int thisBlock;
+
+    HashText(state, GCODE_VERSION);
+    AddToHash(state, &format, sizeof(format));
+
+    for (thisSide = 0; thisSide < TOTAL_SIDES; thisSide++)
+    {
+        transform = &settings->transform[thisSide];
+        AddToHash(state, &transform->scale, sizeof(double));
+        AddToHash(state, &transform->twist, sizeof(double));
+        AddToHash(state, &transform->pivotX, sizeof(double));
+        AddToHash(state, &transform->pivotY, sizeof(double));
+        AddToHash(state, &transform->sweep, sizeof(double));
+        AddToHash(state, &transform->dihedral, sizeof(double));
+        AddToHash(state, &transform->mirror, sizeof(int));
+    }
+    AddToHash(state, &settings->streaming, sizeof(int));
+    AddToHash(state, &settings->resampleTotal, sizeof(int));
+    AddToHash(state, &settings->clustering, sizeof(int));
+    AddToHash(state, &settings->reducing, sizeof(int));
+    AddToHash(state, &settings->tolerance, sizeof(double));
+    AddToHash(state, &settings->fitArcs, sizeof(int));
+    AddToHash(state, &settings->maxWireSpeed, sizeof(double));
+    AddToHash(state, &settings->compression, sizeof(settings->compression));
+    AddToHash(state, &settings->compressionLevel, sizeof(int));
+
+    // The machine profile, as compiled
+    AddToHash(state, &dialect->xMin, sizeof(double));
+    AddToHash(state, &dialect->yMin, sizeof(double));
+    AddToHash(state, &dialect->xMax, sizeof(double));
+    AddToHash(state, &dialect->yMax, sizeof(double));
+    AddToHash(state, &dialect->scale, sizeof(double));
+    AddToHash(state, &dialect->feed, sizeof(double));
+    AddToHash(state, dialect->axis, sizeof(dialect->axis));
+    HashText(state, dialect->units);
+    HashText(state, dialect->moveCommand);
+    HashText(state, dialect->arcClockwise);
+    HashText(state, dialect->arcCounterclockwise);
+    AddToHash(state, &dialect->compactDecimals, sizeof(int));
+    HashText(state, dialect->feedWord);
+    HashText(state, dialect->pointPrefix);
+    AddToHash(state, dialect->separator, sizeof(dialect->separator));
+    for (thisBlock = 0; thisBlock < TOTAL_BLOCKS; thisBlock++)
+    {
+        AddToHash(state, &dialect->blockLength[thisBlock], sizeof(size_t));
+        AddToHash(state, dialect->block[thisBlock], dialect->blockLength[thisBlock]);
+    }
+}
+
+
+// Function name: ComputeIdentityKey()
+// Purpose: Hashes the settings and the identities of the input files.
+//          Returns EXIT_FAILURE if a file can't be found.
+//
+static int ComputeIdentityKey(const Job *job, char filename[][MAX_PATH_LENGTH],
+                              int totalFiles, unsigned long long *key)
+{
+    struct stat status;
+    HashState state;
+    long long identity[7];
+    int thisFile;
+
+    BeginHash(&state, 0);
+    HashSettings(&state, job->settings);
+    for (thisFile = 0; thisFile < totalFiles; thisFile++)
+    {
+        if (stat(filename[thisFile], &status) != 0)
+        {
+            return(EXIT_FAILURE);
+        }
+        identity[0] = (long long)status.st_dev;
+        identity[1] = (long long)status.st_ino;
+        identity[2] = (long long)status.st_size;
+        identity[3] = (long long)status.st_mtim.tv_sec;
+        identity[4] = (long long)status.st_mtim.tv_nsec;
+        identity[5] = (long long)status.st_ctim.tv_sec;
+        identity[6] = (long long)status.st_ctim.tv_nsec;
+        AddToHash(&state, identity, sizeof(identity));
+    }
+    *key = EndHash(&state);
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ComputeContentKey()
+// Purpose: Hashes the settings and the contents of the input files.
+//          Returns EXIT_FAILURE if a file can't be read.
+//
+static int ComputeContentKey(const Job *job, char filename[][MAX_PATH_LENGTH],
+                             int totalFiles, unsigned long long *key)
+{
+    char buffer[CACHE_READ_SIZE];
+    HashState state;
+    long long length;
+    ssize_t received;
+    int thisFile;
+    int file;
+
+    BeginHash(&state, 0);
+    HashSettings(&state, job->settings);
+    for (thisFile = 0; thisFile < totalFiles; thisFile++)
+    {
+        file = open(filename[thisFile], O_RDONLY);
+        if (file < 0)
+        {
+            return(EXIT_FAILURE);
+        }
+        length = 0;
+        while ((received = read(file, buffer, sizeof(buffer))) > 0)
+        {
+            AddToHash(&state, buffer, received);
+            length += received;
+        }
+        close(file);
+        if (received < 0)
+        {
+            return(EXIT_FAILURE);
+        }
+        // Keeps the files apart: "1 2" + "3" isn't "1" + "2 3"
+        AddToHash(&state, &length, sizeof(length));
+    }
+    *key = EndHash(&state);
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: CopyFile()
+// Purpose: Copies a file, for when a hard link can't be made. Returns
+//          EXIT_FAILURE if it can't be copied.
+//
+static int CopyFile(const char *source, const char *destination)
+{
+    char buffer[CACHE_READ_SIZE];
+    ssize_t received;
+    int input;
+    int output;
+    int result = EXIT_SUCCESS;
+
+    input = open(source, O_RDONLY);
+    if (input < 0)
+    {
+        return(EXIT_FAILURE);
+    }
+    output = open(destination, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (output < 0)
+    {
+        close(input);
+        return(EXIT_FAILURE);
+    }
+    while ((received = read(input, buffer, sizeof(buffer))) > 0)
+    {
+        if (write(output, buffer, received) != received)
+        {
+            result = EXIT_FAILURE;
+            break;
+        }
+    }
+    if (received < 0 || close(output) != 0)
+    {
+        result = EXIT_FAILURE;
+    }
+    close(input);
+
+    return(result);
+}
+
+
+// Function name: PlaceFile()
+// Purpose: Makes "destination" the same file as "source", by a hard link
+//          or else a copy, replacing whatever was there in one step.
+//          Returns EXIT_FAILURE if "source" is gone or it can't be done.
+//
+static int PlaceFile(const char *source, const char *destination)
+{
+    char temporary[MAX_PATH_LENGTH];
+
+    BuildTemporaryFilename(destination, temporary);
+    unlink(temporary);
+    if (link(source, temporary) != 0)
+    {
+        // Another file system, or no hard links there
+        if (errno == ENOENT || CopyFile(source, temporary) != EXIT_SUCCESS)
+        {
+            unlink(temporary);
+            return(EXIT_FAILURE);
+        }
+    }
+    if (rename(temporary, destination) != 0)
+    {
+        unlink(temporary);
+        return(EXIT_FAILURE);
+    }
+
+    // rename() does nothing when both names are already links to the same
+    // file, so the temporary one may still be there
+    unlink(temporary);
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ReadCounters()
+// Purpose: Reads the counters from the open STATS file (all zero if it is
+//          new or damaged).
+//
+static void ReadCounters(int file, CacheCounters *counters)
+{
+    char text[128];
+    ssize_t length;
+
+    memset(counters, 0, sizeof(CacheCounters));
+    length = pread(file, text, sizeof(text) - 1, 0);
+    if (length > 0)
+    {
+        text[length] = '\0';
+        if (sscanf(text, "hits %lld misses %lld evictions %lld bytes %lld",
+                   &counters->hits, &counters->misses, &counters->evictions,
+                   &counters->bytes) != 4)
+        {
+            memset(counters, 0, sizeof(CacheCounters));
+        }
+    }
+}
+
+
+// Function name: CompareUse()
+// Purpose: Orders cache files for qsort(), least recently used first.
+//
+static int CompareUse(const void *first, const void *second)
+{
+    const CacheFile *one = (const CacheFile *)first;
+    const CacheFile *other = (const CacheFile *)second;
+
+    if (one->usedSeconds != other->usedSeconds)
+    {
+        return((one->usedSeconds < other->usedSeconds) ? -1 : 1);
+    }
+
+    return((one->usedNanoseconds > other->usedNanoseconds) -
+           (one->usedNanoseconds < other->usedNanoseconds));
+}
+
+
+// Function name: ScanCache()
+// Purpose: Lists the entry and index files in the cache, and sets "bytes"
+//          to their total size and "totalEntries" to the number of
+//          entries. Returns the list (to be freed), which is NULL if
+//          there are no such files or the folder can't be read.
+//
+static CacheFile *ScanCache(const char *directory, int *totalFiles, int *totalEntries,
+                            long long *bytes)
+{
+    char filename[MAX_PATH_LENGTH];
+    struct dirent *entry;
+    struct stat status;
+    CacheFile *file = NULL;
+    CacheFile *grown;
+    size_t length;
+    int allocatedFiles = 0;
+    DIR *folder;
+
+    *totalFiles = 0;
+    *totalEntries = 0;
+    *bytes = 0;
+    folder = opendir(directory);
+    if (folder == NULL)
+    {
+        return(NULL);
+    }
+    while ((entry = readdir(folder)) != NULL)
+    {
+        length = strlen(entry->d_name);
+        if (length >= sizeof(file->name) ||
+            (!(length > strlen(CACHE_ENTRY_SUFFIX) &&
+               strcmp(entry->d_name + length - strlen(CACHE_ENTRY_SUFFIX), CACHE_ENTRY_SUFFIX) == 0) &&
+             !(length > strlen(CACHE_INDEX_SUFFIX) &&
+               strcmp(entry->d_name + length - strlen(CACHE_INDEX_SUFFIX), CACHE_INDEX_SUFFIX) == 0)))
+        {
+            continue;
+        }
+        snprintf(filename, sizeof(filename), "%s" PATH_SEPARATOR "%s", directory, entry->d_name);
+        if (stat(filename, &status) != 0)
+        {
+            continue;
+        }
+        if (*totalFiles == allocatedFiles)
+        {
+            allocatedFiles = (allocatedFiles > 0) ? allocatedFiles * 2 : 256;
+            grown = (CacheFile *)realloc(file, allocatedFiles * sizeof(CacheFile));
+            if (grown == NULL)
+            {
+                break;
+            }
+            file = grown;
+        }
+        strcpy(file[*totalFiles].name, entry->d_name);
+        file[*totalFiles].size = (long long)status.st_size;
+        file[*totalFiles].usedSeconds = status.st_mtim.tv_sec;
+        file[*totalFiles].usedNanoseconds = status.st_mtim.tv_nsec;
+        (*totalFiles)++;
+        *bytes += (long long)status.st_size;
+        if (strcmp(entry->d_name + length - strlen(CACHE_ENTRY_SUFFIX), CACHE_ENTRY_SUFFIX) == 0)
+        {
+            (*totalEntries)++;
+        }
+    }
+    closedir(folder);
+
+    return(file);
+}
+
+
+// Function name: EvictFiles()
+// Purpose: Removes the least recently used files until the cache holds
+//          no more than CACHE_EVICT_TO of its limit, and recounts its size.
+//
+static void EvictFiles(const char *directory, long long limit, CacheCounters *counters)
+{
+    char filename[MAX_PATH_LENGTH];
+    CacheFile *file;
+    int totalFiles;
+    int totalEntries;
+    int thisFile;
+
+    file = ScanCache(directory, &totalFiles, &totalEntries, &counters->bytes);
+    if (file == NULL)
+    {
+        return;
+    }
+    qsort(file, totalFiles, sizeof(CacheFile), CompareUse);
+    for (thisFile = 0; thisFile < totalFiles && counters->bytes > limit * CACHE_EVICT_TO;
+         thisFile++)
+    {
+        snprintf(filename, sizeof(filename), "%s" PATH_SEPARATOR "%s", directory,
+                 file[thisFile].name);
+        if (unlink(filename) == 0)
+        {
+            counters->bytes -= file[thisFile].size;
+            if (strstr(file[thisFile].name, CACHE_ENTRY_SUFFIX) != NULL)
+            {
+                counters->evictions++;
+            }
+        }
+    }
+    free(file);
+}
+
+
+// Function name: UpdateCounters()
+// Purpose: Adds to the counters in the STATS file, under its lock, and
+//          evicts files if the cache has gone past its limit. Returns
+//          EXIT_FAILURE if the counters couldn't be updated; they are
+//          only a guide, so nothing else depends on them.
+//
+static int UpdateCounters(const Settings *settings, const CacheCounters *change)
+{
+    char filename[MAX_PATH_LENGTH];
+    char text[128];
+    CacheCounters counters;
+    int length;
+    int file;
+    int result = EXIT_SUCCESS;
+
+    snprintf(filename, sizeof(filename), "%s" PATH_SEPARATOR CACHE_STATS_FILENAME,
+             settings->cacheDirectory);
+    file = open(filename, O_RDWR | O_CREAT, 0666);
+    if (file < 0)
+    {
+        return(EXIT_FAILURE);
+    }
+    if (flock(file, LOCK_EX) != 0)
+    {
+        close(file);
+        return(EXIT_FAILURE);
+    }
+
+    ReadCounters(file, &counters);
+    counters.hits += change->hits;
+    counters.misses += change->misses;
+    counters.bytes += change->bytes;
+    if (counters.bytes > settings->cacheLimit)
+    {
+        EvictFiles(settings->cacheDirectory, settings->cacheLimit, &counters);
+    }
+
+    length = snprintf(text, sizeof(text), "hits %lld misses %lld evictions %lld bytes %lld\n",
+                      counters.hits, counters.misses, counters.evictions, counters.bytes);
+    if (pwrite(file, text, length, 0) != length || ftruncate(file, length) != 0)
+    {
+        result = EXIT_FAILURE;
+    }
+    close(file);
+
+    return(result);
+}
+
+
+// Function name: UseEntry()
+// Purpose: Links the entry with the given content key into place as the
+//          job's output file, and marks it used. Returns EXIT_FAILURE if
+//          there is no such entry.
+//
+static int UseEntry(Job *job, unsigned long long contentKey)
+{
+    char entry[MAX_PATH_LENGTH];
+    char output[MAX_PATH_LENGTH];
+
+    BuildCacheFilename(job, contentKey, CACHE_ENTRY_SUFFIX, entry);
+    BuildOutputFilename(job, output);
+    if (PlaceFile(entry, output) != EXIT_SUCCESS)
+    {
+        return(EXIT_FAILURE);
+    }
+    utimensat(AT_FDCWD, entry, NULL, 0);
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: WriteIndex()
+// Purpose: Records the content key of the job's input files under their
+//          identity key.
+//
+static void WriteIndex(const Job *job)
+{
+    char filename[MAX_PATH_LENGTH];
+    char temporary[MAX_PATH_LENGTH];
+    char text[32];
+    FILE *file;
+
+    BuildCacheFilename(job, job->identityKey, CACHE_INDEX_SUFFIX, filename);
+    BuildTemporaryFilename(filename, temporary);
+    file = fopen(temporary, WRITEONLY);
+    if (file == NULL)
+    {
+        return;
+    }
+    snprintf(text, sizeof(text), "%016llx\n", job->contentKey);
+    if (fputs(text, file) < 0 || fclose(file) != 0 || rename(temporary, filename) != 0)
+    {
+        unlink(temporary);
+    }
+}
+
+
+// Function name: FetchCachedOutput()
+// Purpose: Looks the job up in the cache and, if it is there, links the
+//          stored output into place. Returns EXIT_SUCCESS on a hit. On a
+//          miss the job's keys are kept for StoreCachedOutput().
+//
+int FetchCachedOutput(Job *job)
+{
+    char filename[TOTAL_VECTORS][MAX_PATH_LENGTH];
+    char index[MAX_PATH_LENGTH];
+    char text[32];
+    CacheCounters change;
+    FILE *file;
+    int totalFiles;
+    int found = 0;
+
+    memset(&change, 0, sizeof(CacheCounters));
+    job->identityKey = 0;
+    job->contentKey = 0;
+    job->stats.cache = CacheMiss;
+
+    // Missing input files are the job's to report
+    totalFiles = ListInputFiles(job, filename);
+    if (ComputeIdentityKey(job, filename, totalFiles, &job->identityKey) != EXIT_SUCCESS)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    // Files seen before are found by their identity alone
+    BuildCacheFilename(job, job->identityKey, CACHE_INDEX_SUFFIX, index);
+    file = fopen(index, READONLY);
+    if (file != NULL)
+    {
+        if (fgets(text, sizeof(text), file) != NULL &&
+            sscanf(text, "%llx", &job->contentKey) == 1 &&
+            UseEntry(job, job->contentKey) == EXIT_SUCCESS)
+        {
+            utimensat(AT_FDCWD, index, NULL, 0);
+            found = 1;
+        }
+        fclose(file);
+    }
+
+    // Otherwise by what they hold
+    if (!found)
+    {
+        if (ComputeContentKey(job, filename, totalFiles, &job->contentKey) != EXIT_SUCCESS)
+        {
+            job->contentKey = 0;
+            return(EXIT_FAILURE);
+        }
+        if (UseEntry(job, job->contentKey) == EXIT_SUCCESS)
+        {
+            WriteIndex(job);
+            found = 1;
+        }
+    }
+
+    if (found)
+    {
+        job->stats.cache = CacheHit;
+        change.hits = 1;
+    }
+    else
+    {
+        change.misses = 1;
+    }
+    UpdateCounters(job->settings, &change);
+
+    return(found ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+
+// Function name: StoreCachedOutput()
+// Purpose: Adds the output file the job has just written to the cache,
+//          under the keys FetchCachedOutput() worked out.
+//
+void StoreCachedOutput(Job *job)
+{
+    char entry[MAX_PATH_LENGTH];
+    char output[MAX_PATH_LENGTH];
+    struct stat status;
+    CacheCounters change;
+
+    if (job->contentKey == 0)
+    {
+        return;
+    }
+
+    BuildCacheFilename(job, job->contentKey, CACHE_ENTRY_SUFFIX, entry);
+    BuildOutputFilename(job, output);
+    if (PlaceFile(output, entry) != EXIT_SUCCESS || stat(entry, &status) != 0)
+    {
+        return;
+    }
+    WriteIndex(job);
+
+    memset(&change, 0, sizeof(CacheCounters));
+    change.bytes = (long long)status.st_size + CACHE_INDEX_LENGTH;
+    UpdateCounters(job->settings, &change);
+}
+
+
+// Function name: ReportCache()
+// Purpose: Prints what the cache holds and how well it has done. Returns
+//          EXIT_FAILURE if the folder can't be read.
+//
+int ReportCache(const char *directory, long long limit)
+{
+    char filename[MAX_PATH_LENGTH];
+    CacheCounters counters;
+    CacheFile *file;
+    long long bytes;
+    int totalFiles;
+    int totalEntries;
+    int stats;
+
+    snprintf(filename, sizeof(filename), "%s" PATH_SEPARATOR CACHE_STATS_FILENAME, directory);
+    memset(&counters, 0, sizeof(CacheCounters));
+    stats = open(filename, O_RDONLY);
+    if (stats >= 0)
+    {
+        flock(stats, LOCK_SH);
+        ReadCounters(stats, &counters);
+        close(stats);
+    }
+
+    if (access(directory, R_OK) != 0)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_CACHE_OPENERROR, directory);
+        return(EXIT_FAILURE);
+    }
+    file = ScanCache(directory, &totalFiles, &totalEntries, &bytes);
+    free(file);
+
+    printf(MESSAGE_CACHE_SUMMARY, directory, totalEntries, bytes, limit, counters.hits,
+           counters.misses,
+           (counters.hits + counters.misses > 0) ?
+             100.0 * counters.hits / (counters.hits + counters.misses) : 0.0,
+           counters.evictions);
+
+    return(EXIT_SUCCESS);
+}
+
+
+// --- End of cache.c
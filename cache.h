@@ -0,0 +1,53 @@
+// cache.h
+//
+// The output cache: G-code kept on disk under a hash of everything that
+// went into it (see cache.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef CACHE_H         // Don't define everything more than once
+#define CACHE_H         //
+
+#include "gcode.h"
+
+
+#define CACHE_ENTRY_SUFFIX ".gcode"     // <content key>.gcode: an output file
+#define CACHE_INDEX_SUFFIX ".index"     // <identity key>.index: its content key
+#define CACHE_TEMP_SUFFIX ".tmp"        // Being written; renamed when complete
+#define CACHE_STATS_FILENAME "STATS"    // Counters shared by every run
+#define CACHE_DEFAULT_LIMIT 256         // Megabytes the cache may hold
+#define CACHE_EVICT_TO 0.9              // Eviction stops at this much of the limit
+#define CACHE_INDEX_LENGTH 17          // Bytes of an index file: the key and a newline
+#define CACHE_FORMAT 1                  // Bumped when keys or entries change meaning
+#define CACHE_READ_SIZE (64 * 1024)     // Bytes of an input file hashed at a time
+
+
+// Function prototypes
+int PrepareCache(const char *directory);
+int FetchCachedOutput(Job *job);
+void StoreCachedOutput(Job *job);
+int ReportCache(const char *directory, long long limit);
+
+
+#endif
+// --- End of cache.h
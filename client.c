@@ -0,0 +1,496 @@
+// client.c
+//
+// gcode_client: sends the job in the current folder to a server started
+// with "gcode --serve" and writes the G-code it gets back to stdout, or
+// times many such requests
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// The eight vector files are sent inline, or with "--path" only the
+// folder is sent and the server reads the files itself. Options the
+// gcode command would take for a job ("--reduce 0.001", ...) are passed
+// on with the request. With "--repeat" or "--connections" the output is
+// thrown away and the round trip of every request is timed instead.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "gcode.h"
+#include "server.h"
+
+
+#define CLIENT_USAGE "Usage: %s <socket> [--path] [--repeat <requests>] " \
+                     "[--connections <clients>] [job options]\n"
+#define CLIENT_CONNECTERROR "connect to %s. %s.\n"
+#define CLIENT_REPLYERROR "read the reply. The server hung up.\n"
+#define CLIENT_SUMMARY "%d requests in %.3f s (%.0f per second): latency p50 %.3f ms, " \
+                       "p99 %.3f ms, max %.3f ms\n"
+
+
+// A request, built once and sent as often as asked
+typedef struct
+{
+    char *text;
+    size_t length;
+    size_t capacity;
+} Request;
+
+// What each timing client is started with
+typedef struct
+{
+    const char *path;       // Socket of the server
+    const Request *request;
+    int totalRequests;      // Requests to send, one after another
+    double *latency;        // Seconds each took
+    int failed;             // Nonzero if any failed
+} Client;
+
+
+// Function name: Now()
+// Purpose: Returns a monotonic time in seconds.
+//
+static double Now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return(now.tv_sec + now.tv_nsec / 1e9);
+}
+
+
+// Function name: AppendRequest()
+// Purpose: Adds text to the request. Returns EXIT_FAILURE if memory runs
+//          out.
+//
+static int AppendRequest(Request *request, const char *text, size_t length)
+{
+    char *grown;
+    size_t capacity;
+
+    if (request->length + length + 1 > request->capacity)
+    {
+        capacity = (request->capacity > 0) ? request->capacity : 4096;
+        while (request->length + length + 1 > capacity)
+        {
+            capacity *= 2;
+        }
+        grown = (char *)realloc(request->text, capacity);
+        if (grown == NULL)
+        {
+            return(EXIT_FAILURE);
+        }
+        request->text = grown;
+        request->capacity = capacity;
+    }
+    memcpy(request->text + request->length, text, length);
+    request->length += length;
+    request->text[request->length] = '\0';
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: AppendVector()
+// Purpose: Adds one vector file to the request as a "vector" line. The
+//          file already starts with the total values, so its lines only
+//          have to be joined.
+//
+static int AppendVector(Request *request, enum Side thisSide, enum Half thisHalf,
+                        enum Dimension thisDimension)
+{
+    char filename[MAX_PATH_LENGTH];
+    char line[64];
+    char *cursor;
+    size_t start;
+    size_t length;
+    FILE *file;
+
+    snprintf(filename, sizeof(filename), "%s%s%s", SideToString[thisSide],
+             HalfToString[thisHalf], DimensionToString[thisDimension]);
+    file = fopen(filename, READONLY);
+    if (file == NULL)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_FILE_OPENERROR, filename);
+        return(EXIT_FAILURE);
+    }
+
+    snprintf(line, sizeof(line), "vector %s %s %s ", SideToString[thisSide],
+             HalfToString[thisHalf], DimensionToString[thisDimension]);
+    AppendRequest(request, line, strlen(line));
+    start = request->length;
+    while ((length = fread(line, 1, sizeof(line), file)) > 0)
+    {
+        if (AppendRequest(request, line, length) != EXIT_SUCCESS)
+        {
+            fclose(file);
+            fprintf(stderr, MESSAGE_ERROR);
+            fprintf(stderr, MESSAGE_MEMORY_ALLOCERROR);
+            return(EXIT_FAILURE);
+        }
+    }
+    fclose(file);
+
+    for (cursor = request->text + start; *cursor != '\0'; cursor++)
+    {
+        if (*cursor == '\n' || *cursor == '\r' || *cursor == '\t')
+        {
+            *cursor = ' ';
+        }
+    }
+
+    return(AppendRequest(request, "\n", 1));
+}
+
+
+// Function name: ConnectToServer()
+// Purpose: Connects to the server's socket. Returns EXIT_FAILURE, with
+//          the problem reported, if it can't.
+//
+static int ConnectToServer(const char *path, Connection *connection)
+{
+    struct sockaddr_un address;
+    int client;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    client = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client < 0 || connect(client, (struct sockaddr *)&address, sizeof(address)) != 0)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, CLIENT_CONNECTERROR, path, strerror(errno));
+        if (client >= 0)
+        {
+            close(client);
+        }
+        return(EXIT_FAILURE);
+    }
+    if (OpenConnection(connection, client) != EXIT_SUCCESS)
+    {
+        close(client);
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_MEMORY_ALLOCERROR);
+        return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: SendRequest()
+// Purpose: Sends the request and reads the reply, writing the G-code to
+//          "output" (unless it is NULL) and the server's messages to
+//          stderr. Returns EXIT_FAILURE if the job failed.
+//
+static int SendRequest(Connection *connection, const Request *request, FILE *output)
+{
+    unsigned long length;
+    const char *bytes;
+    char *line;
+    int failed;
+
+    if (SendToConnection(connection, request->text, request->length, NULL, 0) != EXIT_SUCCESS)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, CLIENT_REPLYERROR);
+        return(EXIT_FAILURE);
+    }
+
+    while ((line = ReadConnectionLine(connection)) != NULL)
+    {
+        if (sscanf(line, "data %lu", &length) == 1)
+        {
+            bytes = ReadConnectionBytes(connection, length);
+            if (bytes == NULL)
+            {
+                break;
+            }
+            if (output != NULL)
+            {
+                fwrite(bytes, 1, length, output);
+            }
+        }
+        else if (sscanf(line, "ok %lu", &length) == 1 || sscanf(line, "error %lu", &length) == 1)
+        {
+            failed = (line[0] == 'e');
+            bytes = ReadConnectionBytes(connection, length);
+            if (bytes == NULL)
+            {
+                break;
+            }
+            fwrite(bytes, 1, length, stderr);
+            return(failed ? EXIT_FAILURE : EXIT_SUCCESS);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    fprintf(stderr, MESSAGE_ERROR);
+    fprintf(stderr, CLIENT_REPLYERROR);
+    return(EXIT_FAILURE);
+}
+
+
+// Function name: RunClient()
+// Purpose: The body of every timing client: one connection, the request
+//          sent over and over.
+//
+static void *RunClient(void *argument)
+{
+    Client *client = (Client *)argument;
+    Connection connection;
+    double start;
+    int thisRequest;
+
+    if (ConnectToServer(client->path, &connection) != EXIT_SUCCESS)
+    {
+        client->failed = 1;
+        return(NULL);
+    }
+    for (thisRequest = 0; thisRequest < client->totalRequests; thisRequest++)
+    {
+        start = Now();
+        if (SendRequest(&connection, client->request, NULL) != EXIT_SUCCESS)
+        {
+            client->failed = 1;
+            break;
+        }
+        client->latency[thisRequest] = Now() - start;
+    }
+    CloseConnection(&connection);
+
+    return(NULL);
+}
+
+
+// Function name: CompareLatency()
+// Purpose: Orders latencies for qsort().
+//
+static int CompareLatency(const void *first, const void *second)
+{
+    double difference = *(const double *)first - *(const double *)second;
+
+    return((difference > 0) - (difference < 0));
+}
+
+
+////////// MAIN PROGRAM BLOCK //////////
+int main (int argc, const char *argv[])
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    Settings scratch;           // Only used to tell how many words an option takes
+    Request request = { NULL, 0, 0 };
+    Connection connection;
+    Client *client;
+    pthread_t *thread;
+    double *latency;
+    double start;
+    double elapsed;
+    char directory[MAX_PATH_LENGTH];
+    int sendPath = 0;
+    int totalRequests = 1;
+    int totalClients = 1;
+    int timing = 0;
+    int firstOption;
+    int thisArgument;
+    int thisClient;
+    int result = EXIT_SUCCESS;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, CLIENT_USAGE, argv[0]);
+        return(EXIT_FAILURE);
+    }
+
+    // Job options go into the request as they are
+    InitializeSettings(&scratch);
+    AppendRequest(&request, "option", 6);
+    for (thisArgument = 2; thisArgument < argc; thisArgument++)
+    {
+        if (strcmp(argv[thisArgument], "--path") == 0)
+        {
+            sendPath = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--repeat") == 0 && thisArgument + 1 < argc &&
+                 atoi(argv[thisArgument + 1]) > 0)
+        {
+            totalRequests = atoi(argv[++thisArgument]);
+            timing = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--connections") == 0 && thisArgument + 1 < argc &&
+                 atoi(argv[thisArgument + 1]) > 0)
+        {
+            totalClients = atoi(argv[++thisArgument]);
+            timing = 1;
+        }
+        else
+        {
+            firstOption = thisArgument;
+            if (ParseJobOption(&scratch, argc, argv, &thisArgument) <= 0)
+            {
+                fprintf(stderr, CLIENT_USAGE, argv[0]);
+                return(EXIT_FAILURE);
+            }
+            for (; firstOption <= thisArgument; firstOption++)
+            {
+                AppendRequest(&request, " ", 1);
+                AppendRequest(&request, argv[firstOption], strlen(argv[firstOption]));
+            }
+        }
+    }
+    if (request.length == 6)
+    {
+        request.length = 0;
+    }
+    else
+    {
+        AppendRequest(&request, "\n", 1);
+    }
+
+    // The job itself: the folder, or the eight vectors
+    if (sendPath)
+    {
+        if (getcwd(directory, sizeof(directory)) == NULL)
+        {
+            fprintf(stderr, MESSAGE_ERROR);
+            fprintf(stderr, MESSAGE_FILE_OPENERROR, ".");
+            return(EXIT_FAILURE);
+        }
+        AppendRequest(&request, "directory ", 10);
+        AppendRequest(&request, directory, strlen(directory));
+        AppendRequest(&request, "\n", 1);
+    }
+    else
+    {
+        for (thisSide = Root; thisSide <= Tip; thisSide++)
+        {
+            for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+            {
+                for (thisDimension = X; thisDimension <= Y; thisDimension++)
+                {
+                    if (AppendVector(&request, thisSide, thisHalf, thisDimension) != EXIT_SUCCESS)
+                    {
+                        free(request.text);
+                        return(EXIT_FAILURE);
+                    }
+                }
+            }
+        }
+    }
+    if (AppendRequest(&request, "run\n", 4) != EXIT_SUCCESS)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_MEMORY_ALLOCERROR);
+        free(request.text);
+        return(EXIT_FAILURE);
+    }
+
+    // A single request: the G-code goes to stdout
+    if (!timing)
+    {
+        result = ConnectToServer(argv[1], &connection);
+        if (result == EXIT_SUCCESS)
+        {
+            result = SendRequest(&connection, &request, stdout);
+            CloseConnection(&connection);
+        }
+        free(request.text);
+        return(result);
+    }
+
+    // Otherwise time every request of every client
+    client = (Client *)calloc(totalClients, sizeof(Client));
+    thread = (pthread_t *)malloc(totalClients * sizeof(pthread_t));
+    latency = (double *)calloc((size_t)totalClients * totalRequests, sizeof(double));
+    if (client == NULL || thread == NULL || latency == NULL)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_MEMORY_ALLOCERROR);
+        free(client);
+        free(thread);
+        free(latency);
+        free(request.text);
+        return(EXIT_FAILURE);
+    }
+    start = Now();
+    for (thisClient = 0; thisClient < totalClients; thisClient++)
+    {
+        client[thisClient].path = argv[1];
+        client[thisClient].request = &request;
+        client[thisClient].totalRequests = totalRequests;
+        client[thisClient].latency = latency + (size_t)thisClient * totalRequests;
+        if (pthread_create(&thread[thisClient], NULL, RunClient, &client[thisClient]) != 0)
+        {
+            RunClient(&client[thisClient]);
+            thread[thisClient] = pthread_self();
+        }
+    }
+    for (thisClient = 0; thisClient < totalClients; thisClient++)
+    {
+        if (!pthread_equal(thread[thisClient], pthread_self()))
+        {
+            pthread_join(thread[thisClient], NULL);
+        }
+        if (client[thisClient].failed)
+        {
+            result = EXIT_FAILURE;
+        }
+    }
+    elapsed = Now() - start;
+
+    if (result == EXIT_SUCCESS)
+    {
+        qsort(latency, (size_t)totalClients * totalRequests, sizeof(double), CompareLatency);
+        printf(CLIENT_SUMMARY, totalClients * totalRequests, elapsed,
+               totalClients * totalRequests / elapsed,
+               latency[(size_t)totalClients * totalRequests / 2] * 1000.0,
+               latency[(size_t)totalClients * totalRequests * 99 / 100] * 1000.0,
+               latency[(size_t)totalClients * totalRequests - 1] * 1000.0);
+    }
+
+    free(client);
+    free(thread);
+    free(latency);
+    free(request.text);
+    return(result);
+}
+////////////////////////////////////////
+
+
+// --- End of client.c
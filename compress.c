@@ -0,0 +1,536 @@
+// compress.c
+//
+// Compressed input and output files: gzip through zlib and, where it is
+// available, zstd (see compress.h)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// Compressed files are recognised by their first bytes, not their names,
+// so a gzip file can stand in for any input file. Nothing is ever
+// decompressed or compressed as a whole: the number parser asks for a
+// block of text at a time, and output text is compressed a block at a
+// time as it is written. Support for each format is compiled in if its
+// library was found (GCODE_ZLIB, GCODE_ZSTD); a file in a format this
+// build can't read is reported as such.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef GCODE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef GCODE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "compress.h"
+
+
+// Bits of the gzip window, plus 16 for a gzip header rather than zlib's
+#define GZIP_WINDOW_BITS (15 + 16)
+
+#if defined(GCODE_ZLIB) || defined(GCODE_ZSTD)
+#define HAVE_COMPRESSION
+#endif
+
+
+const char *CompressionName[] = { "none", "gzip", "zstd" };
+const char *CompressionSuffix[] = { "", ".gz", ".zst" };
+
+
+
+// Function name: DetectCompression()
+// Purpose: Tells from the first bytes of a file how it is compressed.
+//
+enum Compression DetectCompression(const char *bytes, size_t length)
+{
+    const unsigned char *magic = (const unsigned char *)bytes;
+
+    if (length >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+    {
+        return(CompressionGzip);
+    }
+    if (length >= 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F &&
+        magic[3] == 0xFD)
+    {
+        return(CompressionZstd);
+    }
+
+    return(CompressionNone);
+}
+
+
+// Function name: IsCompressionAvailable()
+// Purpose: Returns nonzero if this build can read and write the format.
+//
+int IsCompressionAvailable(enum Compression format)
+{
+    switch (format)
+    {
+        case CompressionNone:
+            return(1);
+#ifdef GCODE_ZLIB
+        case CompressionGzip:
+            return(1);
+#endif
+#ifdef GCODE_ZSTD
+        case CompressionZstd:
+            return(1);
+#endif
+        default:
+            return(0);
+    }
+}
+
+
+// Function name: ParseCompression()
+// Purpose: Reads an output compression given as "gzip" or "zstd",
+//          optionally followed by ":" and a level. Returns EXIT_FAILURE if
+//          it isn't one.
+//
+int ParseCompression(const char *text, enum Compression *format, int *level)
+{
+    const char *colon = strchr(text, ':');
+    size_t length = (colon != NULL) ? (size_t)(colon - text) : strlen(text);
+    int highest;
+    char *end;
+
+    if (length == strlen(CompressionName[CompressionGzip]) &&
+        strncmp(text, CompressionName[CompressionGzip], length) == 0)
+    {
+        *format = CompressionGzip;
+        *level = COMPRESS_GZIP_LEVEL;
+        highest = 9;
+    }
+    else if (length == strlen(CompressionName[CompressionZstd]) &&
+             strncmp(text, CompressionName[CompressionZstd], length) == 0)
+    {
+        *format = CompressionZstd;
+        *level = COMPRESS_ZSTD_LEVEL;
+        highest = 19;
+    }
+    else
+    {
+        return(EXIT_FAILURE);
+    }
+
+    if (colon != NULL)
+    {
+        *level = (int)strtol(colon + 1, &end, 10);
+        if (end == colon + 1 || *end != '\0' || *level < 1 || *level > highest)
+        {
+            return(EXIT_FAILURE);
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: OpenDecompressor()
+// Purpose: Starts decompressing a file whose first "length" bytes have
+//          already been read into "start" (at most DECOMPRESS_BUFFER_SIZE).
+//          Returns NULL if the format isn't available or there is no
+//          memory.
+//
+Decompressor *OpenDecompressor(FILE *file, enum Compression format,
+                               const char *start, size_t length)
+{
+    Decompressor *decompressor;
+
+    if (format == CompressionNone || !IsCompressionAvailable(format) ||
+        length > DECOMPRESS_BUFFER_SIZE)
+    {
+        return(NULL);
+    }
+    decompressor = (Decompressor *)calloc(1, sizeof(Decompressor));
+    if (decompressor == NULL)
+    {
+        return(NULL);
+    }
+    decompressor->file = file;
+    decompressor->format = format;
+    decompressor->input = (unsigned char *)malloc(DECOMPRESS_BUFFER_SIZE);
+
+#ifdef GCODE_ZLIB
+    if (format == CompressionGzip)
+    {
+        decompressor->stream = calloc(1, sizeof(z_stream));
+        if (decompressor->stream != NULL &&
+            inflateInit2((z_stream *)decompressor->stream, GZIP_WINDOW_BITS) != Z_OK)
+        {
+            free(decompressor->stream);
+            decompressor->stream = NULL;
+        }
+    }
+#endif
+#ifdef GCODE_ZSTD
+    if (format == CompressionZstd)
+    {
+        decompressor->stream = ZSTD_createDStream();
+    }
+#endif
+
+    if (decompressor->input == NULL || decompressor->stream == NULL)
+    {
+        CloseDecompressor(decompressor);
+        return(NULL);
+    }
+    memcpy(decompressor->input, start, length);
+    decompressor->length = length;
+    decompressor->totalRead = length;
+
+    return(decompressor);
+}
+
+
+// Function name: RefillDecompressor()
+// Purpose: Reads the next block of compressed bytes from the file.
+//
+static void RefillDecompressor(Decompressor *decompressor)
+{
+    size_t result;
+
+    result = fread(decompressor->input, 1, DECOMPRESS_BUFFER_SIZE, decompressor->file);
+    decompressor->position = 0;
+    decompressor->length = result;
+    decompressor->totalRead += result;
+    // fread() only comes up short at the end of the file (or on an error)
+    if (result < DECOMPRESS_BUFFER_SIZE)
+    {
+        decompressor->endOfInput = 1;
+    }
+}
+
+
+// Function name: Decompress()
+// Purpose: Fills "text" with up to "length" bytes of decompressed data.
+//          Returns how many there are, which is less than "length" only at
+//          the end of the data, or if it is damaged (see "damaged"). A file
+//          may hold several compressed streams one after another, as "cat"
+//          makes them.
+//
+size_t Decompress(Decompressor *decompressor, char *text, size_t length)
+{
+    size_t produced = 0;
+#ifdef GCODE_ZLIB
+    z_stream *inflater;
+    int result;
+#endif
+#ifdef GCODE_ZSTD
+    ZSTD_inBuffer input;
+    ZSTD_outBuffer output;
+    size_t remaining;
+#endif
+#ifndef HAVE_COMPRESSION
+    (void)text;             // Never opened without a library
+#endif
+
+    while (produced < length && !decompressor->damaged)
+    {
+        if (decompressor->position == decompressor->length)
+        {
+            if (!decompressor->endOfInput)
+            {
+                RefillDecompressor(decompressor);
+            }
+            if (decompressor->position == decompressor->length)
+            {
+                // A stream that stops part way was cut short
+                decompressor->damaged = decompressor->midStream;
+                break;
+            }
+        }
+
+#ifdef GCODE_ZLIB
+        if (decompressor->format == CompressionGzip)
+        {
+            inflater = (z_stream *)decompressor->stream;
+            inflater->next_in = decompressor->input + decompressor->position;
+            inflater->avail_in = (uInt)(decompressor->length - decompressor->position);
+            inflater->next_out = (Bytef *)text + produced;
+            inflater->avail_out = (uInt)(length - produced);
+            result = inflate(inflater, Z_NO_FLUSH);
+            decompressor->position = decompressor->length - inflater->avail_in;
+            produced = length - inflater->avail_out;
+            if (result == Z_STREAM_END)
+            {
+                // Ready for another stream, if there is one
+                decompressor->midStream = 0;
+                inflateReset(inflater);
+            }
+            else if (result == Z_OK)
+            {
+                decompressor->midStream = 1;
+            }
+            else
+            {
+                decompressor->damaged = 1;
+            }
+        }
+#endif
+#ifdef GCODE_ZSTD
+        if (decompressor->format == CompressionZstd)
+        {
+            input.src = decompressor->input;
+            input.size = decompressor->length;
+            input.pos = decompressor->position;
+            output.dst = text;
+            output.size = length;
+            output.pos = produced;
+            remaining = ZSTD_decompressStream((ZSTD_DStream *)decompressor->stream,
+                                              &output, &input);
+            decompressor->position = input.pos;
+            produced = output.pos;
+            if (ZSTD_isError(remaining))
+            {
+                decompressor->damaged = 1;
+            }
+            else
+            {
+                decompressor->midStream = (remaining != 0);
+            }
+        }
+#endif
+    }
+
+    return(produced);
+}
+
+
+// Function name: CloseDecompressor()
+// Purpose: Releases a decompressor. The file itself is left open.
+//
+void CloseDecompressor(Decompressor *decompressor)
+{
+    if (decompressor == NULL)
+    {
+        return;
+    }
+
+#ifdef GCODE_ZLIB
+    if (decompressor->format == CompressionGzip && decompressor->stream != NULL)
+    {
+        inflateEnd((z_stream *)decompressor->stream);
+        free(decompressor->stream);
+    }
+#endif
+#ifdef GCODE_ZSTD
+    if (decompressor->format == CompressionZstd)
+    {
+        ZSTD_freeDStream((ZSTD_DStream *)decompressor->stream);
+    }
+#endif
+    free(decompressor->input);
+    free(decompressor);
+}
+
+
+#ifdef HAVE_COMPRESSION
+// Function name: WriteCompressed()
+// Purpose: Writes the first "length" bytes of the compressed output.
+//
+static void WriteCompressed(Compressor *compressor, size_t length)
+{
+    if (length > 0 && fwrite(compressor->output, 1, length, compressor->file) != length)
+    {
+        compressor->error = 1;
+    }
+    compressor->totalWritten += length;
+}
+#endif
+
+
+// Function name: CompressBlock()
+// Purpose: Compresses a block of text and writes whatever compressed
+//          output is ready, or with "finishing" set, all that is left.
+//
+static void CompressBlock(Compressor *compressor, const char *text, size_t length,
+                          int finishing)
+{
+#ifdef GCODE_ZLIB
+    z_stream *deflater;
+#endif
+#ifdef GCODE_ZSTD
+    ZSTD_inBuffer input;
+    ZSTD_outBuffer output;
+    size_t remaining;
+#endif
+#ifndef HAVE_COMPRESSION
+    // Never opened without a library (see OpenCompressor())
+    (void)compressor;
+    (void)text;
+    (void)length;
+    (void)finishing;
+#endif
+
+#ifdef GCODE_ZLIB
+    if (compressor->format == CompressionGzip)
+    {
+        deflater = (z_stream *)compressor->stream;
+        deflater->next_in = (Bytef *)text;
+        deflater->avail_in = (uInt)length;
+        do
+        {
+            deflater->next_out = compressor->output;
+            deflater->avail_out = COMPRESS_BUFFER_SIZE;
+            if (deflate(deflater, finishing ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR)
+            {
+                compressor->error = 1;
+                return;
+            }
+            WriteCompressed(compressor, COMPRESS_BUFFER_SIZE - deflater->avail_out);
+        } while (deflater->avail_out == 0);
+    }
+#endif
+#ifdef GCODE_ZSTD
+    if (compressor->format == CompressionZstd)
+    {
+        input.src = text;
+        input.size = length;
+        input.pos = 0;
+        do
+        {
+            output.dst = compressor->output;
+            output.size = COMPRESS_BUFFER_SIZE;
+            output.pos = 0;
+            remaining = ZSTD_compressStream2((ZSTD_CStream *)compressor->stream, &output,
+                                             &input, finishing ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError(remaining))
+            {
+                compressor->error = 1;
+                return;
+            }
+            WriteCompressed(compressor, output.pos);
+        } while (finishing ? (remaining != 0) : (input.pos < input.size));
+    }
+#endif
+}
+
+
+// Function name: OpenCompressor()
+// Purpose: Prepares to compress text into a file that has just been
+//          opened. Returns EXIT_FAILURE if the format isn't available or
+//          there is no memory.
+//
+int OpenCompressor(Compressor *compressor, FILE *file, enum Compression format, int level)
+{
+    memset(compressor, 0, sizeof(Compressor));
+    compressor->file = file;
+    compressor->format = format;
+    if (format == CompressionNone || !IsCompressionAvailable(format))
+    {
+        return(EXIT_FAILURE);
+    }
+    compressor->output = (unsigned char *)malloc(COMPRESS_BUFFER_SIZE);
+
+#ifdef GCODE_ZLIB
+    if (format == CompressionGzip)
+    {
+        compressor->stream = calloc(1, sizeof(z_stream));
+        if (compressor->stream != NULL &&
+            deflateInit2((z_stream *)compressor->stream, level, Z_DEFLATED, GZIP_WINDOW_BITS,
+                         8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            free(compressor->stream);
+            compressor->stream = NULL;
+        }
+    }
+#endif
+#ifdef GCODE_ZSTD
+    if (format == CompressionZstd)
+    {
+        compressor->stream = ZSTD_createCStream();
+        if (compressor->stream != NULL)
+        {
+            ZSTD_CCtx_setParameter((ZSTD_CStream *)compressor->stream,
+                                   ZSTD_c_compressionLevel, level);
+        }
+    }
+#endif
+    (void)level;
+
+    if (compressor->output == NULL || compressor->stream == NULL)
+    {
+        compressor->error = 1;
+        CloseCompressor(compressor);
+        return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: CompressText()
+// Purpose: The output sink of a compressed output file (see emit.h).
+//          Returns EXIT_FAILURE once compressing or writing has failed.
+//
+int CompressText(void *sinkData, const char *text, size_t length)
+{
+    Compressor *compressor = (Compressor *)sinkData;
+
+    if (!compressor->error)
+    {
+        CompressBlock(compressor, text, length, 0);
+    }
+
+    return(compressor->error ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+// Function name: CloseCompressor()
+// Purpose: Writes the rest of the compressed output and releases the
+//          compressor. The file itself is left open. Returns EXIT_FAILURE
+//          if compressing or writing failed at any point.
+//
+int CloseCompressor(Compressor *compressor)
+{
+    if (!compressor->error && compressor->stream != NULL)
+    {
+        CompressBlock(compressor, NULL, 0, 1);
+    }
+
+#ifdef GCODE_ZLIB
+    if (compressor->format == CompressionGzip && compressor->stream != NULL)
+    {
+        deflateEnd((z_stream *)compressor->stream);
+        free(compressor->stream);
+    }
+#endif
+#ifdef GCODE_ZSTD
+    if (compressor->format == CompressionZstd)
+    {
+        ZSTD_freeCStream((ZSTD_CStream *)compressor->stream);
+    }
+#endif
+    free(compressor->output);
+    compressor->output = NULL;
+    compressor->stream = NULL;
+
+    return(compressor->error ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+// --- End of compress.c
@@ -0,0 +1,99 @@
+// compress.h
+//
+// Compressed input and output files: gzip through zlib and, where it is
+// available, zstd (see compress.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef COMPRESS_H      // Don't define everything more than once
+#define COMPRESS_H      //
+
+#include <stdio.h>
+
+
+// Compressed bytes read from an input file at a time. This is the size of
+// the parser's block (see parse.h), whose first block is handed over.
+#define DECOMPRESS_BUFFER_SIZE (256 * 1024)
+
+// Compressed output collected before it is written
+#define COMPRESS_BUFFER_SIZE (1024 * 1024)
+
+// Levels used if none is given: fast, since the archive is read more often
+// than it is written
+#define COMPRESS_GZIP_LEVEL 3
+#define COMPRESS_ZSTD_LEVEL 3
+
+// Ways a file may be compressed
+enum Compression
+{
+    CompressionNone,
+    CompressionGzip,
+    CompressionZstd
+};
+#define TOTAL_COMPRESSIONS 3
+extern const char *CompressionName[];   // "none", "gzip", "zstd"
+extern const char *CompressionSuffix[]; // "", ".gz", ".zst"
+
+
+// Decompresses a file as it is read (see parse.c)
+typedef struct
+{
+    FILE *file;             // The compressed file
+    enum Compression format;
+    void *stream;           // The library's decompression state
+    unsigned char *input;   // Compressed bytes read but not yet used,
+    size_t position;        //   from this one
+    size_t length;          //   up to this one
+    int endOfInput;         // Nonzero once the whole file has been read
+    int midStream;          // Nonzero while a compressed stream is unfinished
+    int damaged;            // Nonzero if the data can't be decompressed
+    long long totalRead;    // Compressed bytes read so far
+} Decompressor;
+
+// Compresses output text on its way to a file (an OutputSink; see emit.h)
+typedef struct
+{
+    FILE *file;             // The compressed file
+    enum Compression format;
+    void *stream;           // The library's compression state
+    unsigned char *output;  // Compressed bytes not yet written
+    int error;              // Nonzero once compressing or writing has failed
+    long long totalWritten; // Compressed bytes written so far
+} Compressor;
+
+
+// Function prototypes
+enum Compression DetectCompression(const char *bytes, size_t length);
+int IsCompressionAvailable(enum Compression format);
+int ParseCompression(const char *text, enum Compression *format, int *level);
+Decompressor *OpenDecompressor(FILE *file, enum Compression format,
+                               const char *start, size_t length);
+size_t Decompress(Decompressor *decompressor, char *text, size_t length);
+void CloseDecompressor(Decompressor *decompressor);
+int OpenCompressor(Compressor *compressor, FILE *file, enum Compression format, int level);
+int CompressText(void *sinkData, const char *text, size_t length);
+int CloseCompressor(Compressor *compressor);
+
+
+#endif
+// --- End of compress.h
@@ -0,0 +1,681 @@
+// dialect.c
+//
+// Reads machine profiles, which describe the G-code dialect and limits of
+// a cutter, and compiles them into pre-rendered text for the output file
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// A profile is a text file of "name = value" settings, followed by the
+// [header], [transition] and [footer] blocks of G-code written around the
+// two airfoil halves, and the [next_bay] block written between bays when a
+// loft is written as one program. Blank lines and lines starting with '#'
+// are skipped among the settings. Each block is written exactly as it appears, up to
+// the next block or the end of the file, and may use these placeholders:
+//
+//   {x_min} {x_max} {y_min} {y_max}   Cutter limits, as "%f"
+//   {X} {Y} {U} {V}                   Axis letters
+//   {units}                           G20 or G21
+//   {move}                            Straight cutting move command
+//   {feed}                            Feed word, e.g. F0.60
+//
+// DefaultProfile below is compiled first, so a profile file only needs the
+// settings and blocks that differ from it. Since nothing in the blocks
+// changes from file to file, they are rendered once, here; point lines
+// only need the pre-built prefix and separators (see EmitPoint()).
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "dialect.h"
+
+
+// Lines starting with this are comments among the settings
+#define PROFILE_COMMENT '#'
+
+// Longest description of a bad setting, plus one: room is left for the
+// "Line N: " it is given in the error
+#define PROFILE_REASON_MAX (DIALECT_ERROR_MAX - 27)
+
+// The machine this program was written for. Its output is the same as it
+// always has been.
+static const char DefaultProfile[] =
+  "units = inch\n"
+  "axes = X Y U V\n"
+  "x_min = -12\n"
+  "y_min = -12\n"
+  "x_max = 12\n"
+  "y_max = 12\n"
+  "scale = 5\n"
+  "feed = 0.60\n"
+  "move = G1\n"
+  "arc_cw = G2\n"
+  "arc_ccw = G3\n"
+  "compact = off\n"
+  "[header]\n"
+  "(Initialize)\n"
+  "{units}\n"
+  "G90\n"
+  "\n"
+  "(Wire reset)\n"
+  "G0 {X}{y_min} {U}{x_min}\n"
+  "G0 {Y}{y_min} {V}{x_min}\n"
+  "\n"
+  "(Knock slew)\n"
+  "G0 {X}{x_max} {U}{x_max}\n"
+  "G0 {Y}{y_max} {V}{y_max}\n"
+  "G0 {X}{x_min} {U}{x_min}\n"
+  "G0 {Y}{y_min} {V}{y_min}\n"
+  "\n"
+  "(Begin airfoil upper half)\n"
+  "[transition]\n"
+  "(End airfoil upper half)\n"
+  "\n"
+  "(Wire reset)\n"
+  "{move} {X}{x_max} {U}{x_max}\n"
+  "G0 {Y}{y_max} {V}{y_max}\n"
+  "G0 {X}{x_min} {U}{x_min}\n"
+  "G0 {Y}{y_min} {V}{y_min}\n"
+  "\n"
+  "(Begin airfoil lower half)\n"
+  "[next_bay]\n"
+  "(End airfoil lower half)\n"
+  "\n"
+  "(Wire reset)\n"
+  "{move} {X}{x_max} {U}{x_max}\n"
+  "G0 {Y}{y_max} {V}{y_max}\n"
+  "G0 {X}{x_min} {U}{x_min}\n"
+  "G0 {Y}{y_min} {V}{y_min}\n"
+  "\n"
+  "(Begin next bay, airfoil upper half)\n"
+  "[footer]\n"
+  "(End airfoil lower half)\n"
+  "\n"
+  "(Wire reset)\n"
+  "{move} {X}{x_max} {U}{x_max}\n"
+  "G0 {Y}{y_max} {V}{y_max}\n"
+  "G0 {X}{x_min} {U}{x_min}\n"
+  "G0 {Y}{y_min} {V}{y_min}\n"
+  "\n"
+  "(Stop)\n"
+  "M30";
+
+// Section names of the blocks, in Block order
+static const char *BlockName[] = { "[header]", "[transition]", "[footer]", "[next_bay]" };
+
+
+// The source text of each block, pointing into the profile it came from
+typedef struct
+{
+    const char *text[TOTAL_BLOCKS];
+    size_t length[TOTAL_BLOCKS];
+} Templates;
+
+
+// Function name: ParseNumberSetting()
+// Purpose: Reads a setting that must be a number and nothing else.
+//          Returns 0 if it isn't one.
+//
+static int ParseNumberSetting(const char *value, double *number)
+{
+    char *end;
+
+    *number = strtod(value, &end);
+
+    return(end != value && *end == '\0');
+}
+
+
+// Function name: ParseCompactSetting()
+// Purpose: Reads the "compact" setting: "off", or the decimals (0 to
+//          DIALECT_DECIMALS_MAX) of compact moves. Returns 0 if it is
+//          neither.
+//
+static int ParseCompactSetting(const char *value, int *decimals)
+{
+    char *end;
+    long number;
+
+    if (strcmp(value, "off") == 0)
+    {
+        *decimals = -1;
+        return(1);
+    }
+    number = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || number < 0 || number > DIALECT_DECIMALS_MAX)
+    {
+        return(0);
+    }
+    *decimals = (int)number;
+
+    return(1);
+}
+
+
+// Function name: ParseWordSetting()
+// Purpose: Reads a setting that must be a single word (such as "G1") that
+//          fits in DIALECT_WORD_MAX. Returns 0 if it isn't one.
+//
+static int ParseWordSetting(const char *value, char *word)
+{
+    if (*value == '\0' || strlen(value) >= DIALECT_WORD_MAX || strpbrk(value, " \t") != NULL)
+    {
+        return(0);
+    }
+    strcpy(word, value);
+
+    return(1);
+}
+
+
+// Function name: ParseSetting()
+// Purpose: Applies one "name = value" line (already trimmed) to the
+//          dialect. Returns 0 and describes the problem in "error" (which
+//          must hold PROFILE_REASON_MAX characters) if the line can't be
+//          understood.
+//
+static int ParseSetting(Dialect *dialect, char *line, char *error)
+{
+    char *value;
+    char *end;
+    int thisAxis;
+
+    value = strchr(line, '=');
+    if (value == NULL)
+    {
+        snprintf(error, PROFILE_REASON_MAX, "expected \"name = value\"");
+        return(0);
+    }
+
+    // Split into a trimmed name and value
+    end = value;
+    while (end > line && (end[-1] == ' ' || end[-1] == '\t'))
+    {
+        end--;
+    }
+    *end = '\0';
+    value++;
+    while (*value == ' ' || *value == '\t')
+    {
+        value++;
+    }
+
+    if (strcmp(line, "units") == 0)
+    {
+        if (strcmp(value, "inch") == 0)
+        {
+            strcpy(dialect->units, "G20");
+        }
+        else if (strcmp(value, "mm") == 0)
+        {
+            strcpy(dialect->units, "G21");
+        }
+        else
+        {
+            snprintf(error, PROFILE_REASON_MAX, "units must be \"inch\" or \"mm\"");
+            return(0);
+        }
+        return(1);
+    }
+    if (strcmp(line, "axes") == 0)
+    {
+        // Four letters, separated by spaces
+        for (thisAxis = 0; thisAxis < 4; thisAxis++)
+        {
+            if (!((*value >= 'A' && *value <= 'Z') || (*value >= 'a' && *value <= 'z')) ||
+                (value[1] != '\0' && value[1] != ' ' && value[1] != '\t'))
+            {
+                break;
+            }
+            dialect->axis[thisAxis] = *value++;
+            while (*value == ' ' || *value == '\t')
+            {
+                value++;
+            }
+        }
+        if (thisAxis < 4 || *value != '\0')
+        {
+            snprintf(error, PROFILE_REASON_MAX, "axes must be four letters, such as \"X Y U V\"");
+            return(0);
+        }
+        return(1);
+    }
+    if (strcmp(line, "scale") == 0)
+    {
+        if (!ParseNumberSetting(value, &dialect->scale) ||
+            !(dialect->scale > 0.0 && isfinite(dialect->scale)))
+        {
+            snprintf(error, PROFILE_REASON_MAX, "scale must be a number greater than 0");
+            return(0);
+        }
+        return(1);
+    }
+    if (strcmp(line, "feed") == 0)
+    {
+        // Written to hundredths, so a smaller feed would be F0.00
+        if (!ParseNumberSetting(value, &dialect->feed) ||
+            !(dialect->feed >= DIALECT_FEED_MIN && dialect->feed <= DIALECT_FEED_MAX))
+        {
+            snprintf(error, PROFILE_REASON_MAX, "feed must be from %.3f to %.0f",
+                     DIALECT_FEED_MIN, DIALECT_FEED_MAX);
+            return(0);
+        }
+        return(1);
+    }
+    if ((strcmp(line, "x_min") == 0 && ParseNumberSetting(value, &dialect->xMin)) ||
+        (strcmp(line, "y_min") == 0 && ParseNumberSetting(value, &dialect->yMin)) ||
+        (strcmp(line, "x_max") == 0 && ParseNumberSetting(value, &dialect->xMax)) ||
+        (strcmp(line, "y_max") == 0 && ParseNumberSetting(value, &dialect->yMax)) ||
+        (strcmp(line, "move") == 0 && ParseWordSetting(value, dialect->moveCommand)) ||
+        (strcmp(line, "arc_cw") == 0 && ParseWordSetting(value, dialect->arcClockwise)) ||
+        (strcmp(line, "arc_ccw") == 0 && ParseWordSetting(value, dialect->arcCounterclockwise)) ||
+        (strcmp(line, "compact") == 0 && ParseCompactSetting(value, &dialect->compactDecimals)))
+    {
+        return(1);
+    }
+
+    if (strcmp(line, "x_min") == 0 || strcmp(line, "y_min") == 0 ||
+        strcmp(line, "x_max") == 0 || strcmp(line, "y_max") == 0 ||
+        strcmp(line, "move") == 0 || strcmp(line, "arc_cw") == 0 ||
+        strcmp(line, "arc_ccw") == 0 || strcmp(line, "compact") == 0)
+    {
+        snprintf(error, PROFILE_REASON_MAX, "can't use \"%.40s\" as %.20s", value, line);
+    }
+    else
+    {
+        snprintf(error, PROFILE_REASON_MAX, "there is no setting called \"%.40s\"", line);
+    }
+    return(0);
+}
+
+
+// Function name: ParseProfile()
+// Purpose: Applies a whole profile to the dialect: its settings directly,
+//          and its blocks as templates for RenderBlocks(). Returns 0 and
+//          describes the problem in "error" if it can't be understood.
+//
+static int ParseProfile(Dialect *dialect, const char *profile, Templates *templates,
+                        char *error)
+{
+    const char *cursor = profile;
+    const char *next;
+    char line[256];
+    char reason[PROFILE_REASON_MAX];
+    char *start;
+    char *end;
+    size_t length;
+    long lineNumber = 0;
+    int thisBlock = -1;
+    int newBlock;
+
+    while (*cursor != '\0')
+    {
+        // Copy out the next line, trimmed
+        lineNumber++;
+        next = strchr(cursor, '\n');
+        next = (next == NULL) ? cursor + strlen(cursor) : next + 1;
+        length = next - cursor;
+        if (length >= sizeof(line))
+        {
+            length = sizeof(line) - 1;
+        }
+        memcpy(line, cursor, length);
+        line[length] = '\0';
+        start = line;
+        while (*start == ' ' || *start == '\t')
+        {
+            start++;
+        }
+        end = start + strlen(start);
+        while (end > start && (end[-1] == '\n' || end[-1] == '\r' ||
+                               end[-1] == ' ' || end[-1] == '\t'))
+        {
+            *--end = '\0';
+        }
+
+        // A block heading ends the block before it
+        if (*start == '[')
+        {
+            for (newBlock = 0; newBlock < TOTAL_BLOCKS; newBlock++)
+            {
+                if (strcmp(start, BlockName[newBlock]) == 0)
+                {
+                    break;
+                }
+            }
+            if (newBlock == TOTAL_BLOCKS)
+            {
+                snprintf(error, DIALECT_ERROR_MAX, "Line %ld: there is no %.40s block",
+                         lineNumber, start);
+                return(0);
+            }
+            thisBlock = newBlock;
+            templates->text[thisBlock] = next;
+            templates->length[thisBlock] = 0;
+        }
+        // Inside a block every line is kept as it is
+        else if (thisBlock >= 0)
+        {
+            templates->length[thisBlock] = next - templates->text[thisBlock];
+        }
+        else if (*start != '\0' && *start != PROFILE_COMMENT &&
+                 !ParseSetting(dialect, start, reason))
+        {
+            snprintf(error, DIALECT_ERROR_MAX, "Line %ld: %s", lineNumber, reason);
+            return(0);
+        }
+
+        cursor = next;
+    }
+
+    return(1);
+}
+
+
+// Function name: Placeholder()
+// Purpose: Renders the placeholder "name" (without its braces) into
+//          "text". Returns 0 if there is no such placeholder.
+//
+static int Placeholder(const Dialect *dialect, const char *name, size_t length, char *text)
+{
+    static const char *AxisName[] = { "X", "Y", "U", "V" };
+    int thisAxis;
+
+    for (thisAxis = 0; thisAxis < 4; thisAxis++)
+    {
+        if (length == 1 && name[0] == AxisName[thisAxis][0])
+        {
+            text[0] = dialect->axis[thisAxis];
+            text[1] = '\0';
+            return(1);
+        }
+    }
+
+#define IS_PLACEHOLDER(placeholder) \
+    (length == sizeof(placeholder) - 1 && memcmp(name, placeholder, length) == 0)
+    if (IS_PLACEHOLDER("x_min"))
+    {
+        sprintf(text, "%f", dialect->xMin);
+    }
+    else if (IS_PLACEHOLDER("x_max"))
+    {
+        sprintf(text, "%f", dialect->xMax);
+    }
+    else if (IS_PLACEHOLDER("y_min"))
+    {
+        sprintf(text, "%f", dialect->yMin);
+    }
+    else if (IS_PLACEHOLDER("y_max"))
+    {
+        sprintf(text, "%f", dialect->yMax);
+    }
+    else if (IS_PLACEHOLDER("units"))
+    {
+        strcpy(text, dialect->units);
+    }
+    else if (IS_PLACEHOLDER("move"))
+    {
+        strcpy(text, dialect->moveCommand);
+    }
+    else if (IS_PLACEHOLDER("feed"))
+    {
+        strcpy(text, dialect->feedWord);
+    }
+    else
+    {
+        return(0);
+    }
+#undef IS_PLACEHOLDER
+
+    return(1);
+}
+
+
+// Function name: RenderBlock()
+// Purpose: Renders one block's template, with every placeholder filled in,
+//          into newly allocated text. Carriage returns are left out.
+//          Returns 0 and describes the problem in "error" if a placeholder
+//          is unknown or memory runs out.
+//
+static int RenderBlock(Dialect *dialect, enum Block thisBlock, const char *source,
+                       size_t sourceLength, char *error)
+{
+    char value[512];        // Big enough for "%f" of any double
+    char *text;
+    char *grown;
+    size_t capacity;
+    size_t length = 0;
+    size_t valueLength;
+    const char *close;
+    size_t thisChar;
+
+    capacity = sourceLength + 256;
+    text = (char *)malloc(capacity);
+    if (text == NULL)
+    {
+        snprintf(error, DIALECT_ERROR_MAX, "out of memory");
+        return(0);
+    }
+
+    for (thisChar = 0; thisChar < sourceLength; thisChar++)
+    {
+        value[0] = source[thisChar];
+        value[1] = '\0';
+        if (source[thisChar] == '\r')
+        {
+            continue;
+        }
+        if (source[thisChar] == '{')
+        {
+            close = memchr(source + thisChar, '}', sourceLength - thisChar);
+            if (close == NULL ||
+                !Placeholder(dialect, source + thisChar + 1, close - source - thisChar - 1, value))
+            {
+                // Quote it up to its closing brace or the end of its line
+                valueLength = strcspn(source + thisChar, "}\r\n") + 1;
+                snprintf(error, DIALECT_ERROR_MAX, "%s has an unknown placeholder \"%.*s\"",
+                         BlockName[thisBlock], (int)((valueLength < 40) ? valueLength : 40),
+                         source + thisChar);
+                free(text);
+                return(0);
+            }
+            thisChar = close - source;
+        }
+
+        valueLength = strlen(value);
+        if (length + valueLength > capacity)
+        {
+            capacity = 2 * capacity + valueLength;
+            grown = (char *)realloc(text, capacity);
+            if (grown == NULL)
+            {
+                snprintf(error, DIALECT_ERROR_MAX, "out of memory");
+                free(text);
+                return(0);
+            }
+            text = grown;
+        }
+        memcpy(text + length, value, valueLength);
+        length += valueLength;
+    }
+
+    dialect->block[thisBlock] = text;
+    dialect->blockLength[thisBlock] = length;
+
+    return(1);
+}
+
+
+// Function name: ReadProfile()
+// Purpose: Reads a whole profile file into newly allocated, zero-terminated
+//          text. Returns NULL if it can't be read.
+//
+static char *ReadProfile(const char *filename)
+{
+    FILE *profileFile;
+    char *profile = NULL;
+    char *grown;
+    size_t length = 0;
+    size_t capacity = 0;
+    size_t result;
+
+    profileFile = fopen(filename, "r");
+    if (profileFile == NULL)
+    {
+        return(NULL);
+    }
+
+    do
+    {
+        if (capacity - length < 4096)
+        {
+            capacity = capacity * 2 + 4096;
+            grown = (char *)realloc(profile, capacity + 1);
+            if (grown == NULL)
+            {
+                free(profile);
+                fclose(profileFile);
+                return(NULL);
+            }
+            profile = grown;
+        }
+        result = fread(profile + length, 1, capacity - length, profileFile);
+        length += result;
+    } while (result > 0);
+
+    if (ferror(profileFile))
+    {
+        free(profile);
+        profile = NULL;
+    }
+    else
+    {
+        profile[length] = '\0';
+    }
+    fclose(profileFile);
+
+    return(profile);
+}
+
+
+// Function name: CompileDialect()
+// Purpose: Compiles the default profile, and then the profile file
+//          "filename" on top of it (unless it is NULL). Returns
+//          EXIT_FAILURE, with the problem described in "error" (which must
+//          hold DIALECT_ERROR_MAX characters), if the file can't be read or
+//          understood.
+//
+int CompileDialect(Dialect *dialect, const char *filename, char *error)
+{
+    Templates templates;
+    char *profile = NULL;
+    int result;
+    int thisBlock;
+    int thisSeparator;
+
+    memset(dialect, 0, sizeof(Dialect));
+    memset(&templates, 0, sizeof(Templates));
+    error[0] = '\0';
+
+    result = ParseProfile(dialect, DefaultProfile, &templates, error);
+    if (result && filename != NULL)
+    {
+        profile = ReadProfile(filename);
+        if (profile == NULL)
+        {
+            snprintf(error, DIALECT_ERROR_MAX, "The file can't be read");
+            result = 0;
+        }
+        else
+        {
+            result = ParseProfile(dialect, profile, &templates, error);
+        }
+    }
+
+    // Limits may be given in either order, so they are checked once all are
+    if (result && !(dialect->xMin < dialect->xMax))
+    {
+        snprintf(error, DIALECT_ERROR_MAX, "x_min (%g) must be less than x_max (%g)",
+                 dialect->xMin, dialect->xMax);
+        result = 0;
+    }
+    else if (result && !(dialect->yMin < dialect->yMax))
+    {
+        snprintf(error, DIALECT_ERROR_MAX, "y_min (%g) must be less than y_max (%g)",
+                 dialect->yMin, dialect->yMax);
+        result = 0;
+    }
+
+    if (result)
+    {
+        // Everything a point line needs besides its coordinates. The feed
+        // is rounded once, so the feed word, compact moves and the feed
+        // planner all write the same feed.
+        dialect->feedHundredths = (long)floor(dialect->feed * 100.0 + 0.5);
+        snprintf(dialect->feedWord, sizeof(dialect->feedWord), "F%ld.%02ld",
+                 dialect->feedHundredths / 100, dialect->feedHundredths % 100);
+        dialect->pointPrefixLength = snprintf(dialect->pointPrefix, sizeof(dialect->pointPrefix),
+          "%s %s %c", dialect->moveCommand, dialect->feedWord, dialect->axis[0]);
+        for (thisSeparator = 0; thisSeparator < 3; thisSeparator++)
+        {
+            dialect->separator[thisSeparator][0] = ' ';
+            dialect->separator[thisSeparator][1] = dialect->axis[thisSeparator + 1];
+        }
+
+        for (thisBlock = 0; thisBlock < TOTAL_BLOCKS && result; thisBlock++)
+        {
+            result = RenderBlock(dialect, (enum Block)thisBlock, templates.text[thisBlock],
+                                 templates.length[thisBlock], error);
+        }
+    }
+
+    free(profile);
+    if (!result)
+    {
+        FreeDialect(dialect);
+        return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: FreeDialect()
+// Purpose: Releases the rendered blocks of a dialect.
+//
+void FreeDialect(Dialect *dialect)
+{
+    int thisBlock;
+
+    for (thisBlock = 0; thisBlock < TOTAL_BLOCKS; thisBlock++)
+    {
+        free(dialect->block[thisBlock]);
+        dialect->block[thisBlock] = NULL;
+        dialect->blockLength[thisBlock] = 0;
+    }
+}
+
+
+// --- End of dialect.c
@@ -0,0 +1,90 @@
+// dialect.h
+//
+// Machine profiles: the G-code dialect and limits of a cutter, read at
+// run time (see dialect.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef DIALECT_H       // Don't define everything more than once
+#define DIALECT_H       //
+
+#include <stddef.h>
+
+
+#define DIALECT_WORD_MAX 16     // Longest command or units word, plus one
+#define DIALECT_PREFIX_MAX 64   // Longest point line prefix, plus one
+#define DIALECT_ERROR_MAX 128   // Longest error description, plus one
+#define DIALECT_DECIMALS_MAX 6  // Most decimals a compact move may have
+#define DIALECT_FEED_MIN 0.005  // Least feed, which is written as F0.01
+#define DIALECT_FEED_MAX 100000.0 // Greatest feed
+
+// The blocks of text written once per output file
+enum Block
+{
+    Header,                 // Before the upper half
+    Transition,             // Between the upper and lower halves
+    Footer,                 // After the lower half
+    NextBay                 // Between one bay and the next, in a loft
+                            //   written as one program (see loft.c)
+};
+#define TOTAL_BLOCKS 4
+
+
+// A machine profile, compiled. Everything that doesn't change from point
+// to point is rendered once, so writing a point costs the same whatever
+// the profile says.
+typedef struct
+{
+    // Settings
+    double xMin;            // Cutter limits, in output units. They also
+    double yMin;            //   apply to the U and V axes.
+    double xMax;            //
+    double yMax;            //
+    double scale;           // Every input coordinate is multiplied by this
+    double feed;            // Feed of every cutting move
+    char axis[4];           // Letters of the root X/Y and tip X/Y axes
+    char units[DIALECT_WORD_MAX];           // "G20" (inches) or "G21" (mm)
+    char moveCommand[DIALECT_WORD_MAX];     // Straight cutting move
+    char arcClockwise[DIALECT_WORD_MAX];    // Arcs (see reduce.c)
+    char arcCounterclockwise[DIALECT_WORD_MAX];
+    int compactDecimals;    // Decimals of modal, compact moves, or -1 to
+                            //   write every word of every move (see emit.c)
+
+    // Compiled from the settings
+    long feedHundredths;    // The feed, in hundredths
+    char feedWord[DIALECT_WORD_MAX * 2];    // The feed as written, e.g. "F0.60"
+    char pointPrefix[DIALECT_PREFIX_MAX];   // Start of a point line, up to
+    size_t pointPrefixLength;               //   the first coordinate
+    char separator[3][2];   // Space and letter before the Y, U, V coordinates
+    char *block[TOTAL_BLOCKS];              // Fully rendered blocks
+    size_t blockLength[TOTAL_BLOCKS];       //
+} Dialect;
+
+
+// Function prototypes
+int CompileDialect(Dialect *dialect, const char *filename, char *error);
+void FreeDialect(Dialect *dialect);
+
+
+#endif
+// --- End of dialect.h
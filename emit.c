@@ -0,0 +1,852 @@
+// emit.c
+//
+// Formats coordinates with integer arithmetic and writes G-code to the
+// output file in large blocks
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// A float is exactly mantissa * 2^exponent, so value * 10^6 can be worked
+// out exactly in 64-bit integers and rounded half-to-even, which is what
+// printf("%f") does with the exact value of its argument. The text is
+// therefore byte-for-byte the same as "%f", without any format string or
+// locale handling per coordinate. Values too large for 64 bits, infinities
+// and NaNs are still handed to snprintf().
+//
+// Compact moves (a profile's "compact" setting, or "--compact") use modal
+// G-code instead: the command, the F word and each axis are only written
+// when they differ from what the controller already has, to the chosen
+// number of decimals, without trailing zeros. The same exact rounding
+// decides both what is written and whether an axis moved, so the program
+// moves the wire exactly as the verbose one does, to those decimals. Any
+// other text (a block of the profile) makes the next move write every word.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "gcode.h"
+#include "emit.h"
+
+
+// 10^OUTPUT_DECIMALS
+#define OUTPUT_SCALE 1000000ULL
+
+// Steps of each number of decimals a compact move may have
+static const unsigned long long PowerOfTen[OUTPUT_DECIMALS + 1] =
+  { 1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL };
+
+// Exponents at or above this could overflow 64 bits (24-bit mantissa times
+// 10^6, which needs 44 bits, shifted left)
+#define EXPONENT_LIMIT 20
+
+
+
+// Function name: ForgetModalState()
+// Purpose: Makes the next compact move write every word, since text that
+//          isn't a move (a block of the profile, say) may have changed
+//          anything.
+//
+static void ForgetModalState(OutputBuffer *output)
+{
+    output->modal.known = 0;
+    output->modal.command = NULL;
+    output->modal.feed = -1;
+}
+
+
+// Function name: OpenOutputBuffer()
+// Purpose: Prepares an empty output buffer for a file that has just been
+//          opened, to be written in the given dialect. Returns EXIT_FAILURE
+//          if the buffer can't be allocated.
+//
+int OpenOutputBuffer(OutputBuffer *output, FILE *file, const Dialect *dialect)
+{
+    output->file = file;
+    output->sink = NULL;
+    output->sinkData = NULL;
+    output->dialect = dialect;
+    output->length = 0;
+    output->error = 0;
+    output->totalWritten = 0;
+    output->totalLines = 0;
+    output->buffer = (char *)malloc(OUTPUT_BUFFER_SIZE);
+    output->ownsBuffer = 1;
+    ForgetModalState(output);
+    output->verboseBytes = 0;
+
+    return((output->buffer == NULL) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+// Function name: OpenOutputSink()
+// Purpose: Prepares an empty output buffer whose text goes to a sink
+//          instead of a file, using "storage" (OUTPUT_BUFFER_SIZE bytes)
+//          as the buffer, or allocating one if it is NULL. Returns
+//          EXIT_FAILURE if the buffer can't be allocated.
+//
+int OpenOutputSink(OutputBuffer *output, OutputSink sink, void *sinkData,
+                   const Dialect *dialect, char *storage)
+{
+    int result = EXIT_SUCCESS;
+
+    if (storage == NULL)
+    {
+        result = OpenOutputBuffer(output, NULL, dialect);
+    }
+    else
+    {
+        output->file = NULL;
+        output->dialect = dialect;
+        output->length = 0;
+        output->error = 0;
+        output->totalWritten = 0;
+        output->totalLines = 0;
+        output->buffer = storage;
+        output->ownsBuffer = 0;
+        ForgetModalState(output);
+        output->verboseBytes = 0;
+    }
+    output->sink = sink;
+    output->sinkData = sinkData;
+
+    return(result);
+}
+
+
+// Function name: WriteOutput()
+// Purpose: Hands a block of text to the output file or sink.
+//
+static void WriteOutput(OutputBuffer *output, const char *text, size_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    if (output->sink != NULL)
+    {
+        if (output->sink(output->sinkData, text, length) != EXIT_SUCCESS)
+        {
+            output->error = 1;
+        }
+    }
+    else if (fwrite(text, 1, length, output->file) != length)
+    {
+        output->error = 1;
+    }
+    output->totalWritten += length;
+}
+
+
+// Function name: FlushOutputBuffer()
+// Purpose: Writes all buffered text to the output file.
+//
+void FlushOutputBuffer(OutputBuffer *output)
+{
+    WriteOutput(output, output->buffer, output->length);
+    output->length = 0;
+}
+
+
+// Function name: CloseOutputBuffer()
+// Purpose: Writes out whatever is left and releases the buffer. Returns
+//          EXIT_FAILURE if any write to the output file failed. The file
+//          itself is left open.
+//
+int CloseOutputBuffer(OutputBuffer *output)
+{
+    if (output->buffer == NULL)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    FlushOutputBuffer(output);
+    if (output->file != NULL && fflush(output->file) != 0)
+    {
+        output->error = 1;
+    }
+    if (output->ownsBuffer)
+    {
+        free(output->buffer);
+    }
+    output->buffer = NULL;
+
+    return(output->error ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+// Function name: MakeRoom()
+// Purpose: Flushes the buffer if it can't take another OUTPUT_LINE_MAX bytes.
+//
+static void MakeRoom(OutputBuffer *output)
+{
+    if (OUTPUT_BUFFER_SIZE - output->length < OUTPUT_LINE_MAX)
+    {
+        FlushOutputBuffer(output);
+    }
+}
+
+
+// Function name: CountLines()
+// Purpose: Adds the line breaks in some text to the output's line count.
+//          Only used for text written once per file.
+//
+static void CountLines(OutputBuffer *output, const char *text, size_t length)
+{
+    const char *end = text + length;
+
+    while ((text = memchr(text, '\n', end - text)) != NULL)
+    {
+        output->totalLines++;
+        text++;
+    }
+}
+
+
+// Function name: EmitFormat()
+// Purpose: Adds printf()-style text to the output. Used for the blocks
+//          that are written once per file, such as the header and footer.
+//
+void EmitFormat(OutputBuffer *output, const char *format, ...)
+{
+    va_list arguments;
+    size_t room;
+    int result;
+
+    room = OUTPUT_BUFFER_SIZE - output->length;
+    va_start(arguments, format);
+    result = vsnprintf(output->buffer + output->length, room, format, arguments);
+    va_end(arguments);
+
+    // If the text didn't fit, make the whole buffer available and try again
+    if (result >= 0 && (size_t)result >= room && output->length > 0)
+    {
+        FlushOutputBuffer(output);
+        room = OUTPUT_BUFFER_SIZE;
+        va_start(arguments, format);
+        result = vsnprintf(output->buffer, room, format, arguments);
+        va_end(arguments);
+    }
+
+    if (result < 0 || (size_t)result >= room)
+    {
+        output->error = 1;
+        return;
+    }
+    CountLines(output, output->buffer + output->length, result);
+    output->length += result;
+    output->verboseBytes += result;
+    ForgetModalState(output);
+}
+
+
+// Function name: EmitText()
+// Purpose: Adds text that is already rendered, such as a dialect's header,
+//          to the output. Text too long for the buffer is written directly.
+//
+void EmitText(OutputBuffer *output, const char *text, size_t length)
+{
+    CountLines(output, text, length);
+    output->verboseBytes += length;
+    ForgetModalState(output);
+    if (OUTPUT_BUFFER_SIZE - output->length < length)
+    {
+        FlushOutputBuffer(output);
+    }
+    if (length > OUTPUT_BUFFER_SIZE)
+    {
+        WriteOutput(output, text, length);
+        return;
+    }
+
+    memcpy(output->buffer + output->length, text, length);
+    output->length += length;
+}
+
+
+// Function name: ScaleExactly()
+// Purpose: Works out |value| * scale (10^OUTPUT_DECIMALS at most), rounded
+//          half-to-even, from the exact value of the float. Returns 0 for
+//          infinities, NaNs and values too large for 64 bits.
+//
+static int ScaleExactly(float value, unsigned long long scale, unsigned long long *scaled)
+{
+    unsigned int bits;
+    unsigned long long mantissa;
+    unsigned long long remainder;
+    unsigned long long half;
+    int exponent;
+    int shift;
+
+    memcpy(&bits, &value, sizeof(bits));
+    exponent = (int)((bits >> 23) & 0xFF);
+    mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF || exponent - 150 >= EXPONENT_LIMIT)
+    {
+        return(0);
+    }
+
+    // value = mantissa * 2^exponent, with subnormals having no hidden bit
+    if (exponent == 0)
+    {
+        exponent = -149;
+    }
+    else
+    {
+        mantissa |= 0x800000;
+        exponent -= 150;
+    }
+
+    *scaled = mantissa * scale;
+    if (exponent >= 0)
+    {
+        *scaled <<= exponent;
+    }
+    else if (-exponent >= 64)
+    {
+        // Less than 2^-20, which rounds to zero
+        *scaled = 0;
+    }
+    else
+    {
+        shift = -exponent;
+        remainder = *scaled & ((1ULL << shift) - 1);
+        half = 1ULL << (shift - 1);
+        *scaled >>= shift;
+        if (remainder > half || (remainder == half && (*scaled & 1)))
+        {
+            (*scaled)++;
+        }
+    }
+
+    return(1);
+}
+
+
+// Function name: FormatFixed()
+// Purpose: Writes a float at "cursor" exactly as printf("%f") would, and
+//          returns the position just after the text.
+//
+char *FormatFixed(char *cursor, float value)
+{
+    unsigned long long scaled;
+    unsigned long long whole;
+    char digits[24];
+    int totalDigits;
+    int thisDigit;
+
+    // Infinity, NaN and huge values take the slow road
+    if (!ScaleExactly(value, OUTPUT_SCALE, &scaled))
+    {
+        return(cursor + sprintf(cursor, "%f", value));
+    }
+
+    // The sign always shows, even on values that round to zero
+    if (signbit(value))
+    {
+        *cursor++ = '-';
+    }
+
+    // Whole part
+    whole = scaled / OUTPUT_SCALE;
+    totalDigits = 0;
+    do
+    {
+        digits[totalDigits++] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (whole != 0);
+    while (totalDigits > 0)
+    {
+        *cursor++ = digits[--totalDigits];
+    }
+
+    // Fraction
+    *cursor++ = '.';
+    scaled %= OUTPUT_SCALE;
+    for (thisDigit = OUTPUT_DECIMALS - 1; thisDigit >= 0; thisDigit--)
+    {
+        cursor[thisDigit] = (char)('0' + scaled % 10);
+        scaled /= 10;
+    }
+
+    return(cursor + OUTPUT_DECIMALS);
+}
+
+
+// Function name: FixedLength()
+// Purpose: Returns how many characters FormatFixed() writes for a float.
+//
+static size_t FixedLength(float value)
+{
+    unsigned long long scaled;
+    unsigned long long whole;
+    size_t length;
+
+    if (!ScaleExactly(value, OUTPUT_SCALE, &scaled))
+    {
+        return((size_t)snprintf(NULL, 0, "%f", value));
+    }
+
+    length = (signbit(value) ? 1 : 0) + 1 + 1 + OUTPUT_DECIMALS;
+    for (whole = scaled / OUTPUT_SCALE; whole >= 10; whole /= 10)
+    {
+        length++;
+    }
+
+    return(length);
+}
+
+
+// Function name: QuantizeValue()
+// Purpose: Returns a float in steps of the last of "decimals" decimals,
+//          rounded as FormatFixed() rounds, or MODAL_UNKNOWN if it doesn't
+//          fit.
+//
+static long long QuantizeValue(float value, int decimals)
+{
+    unsigned long long scaled;
+
+    if (!ScaleExactly(value, PowerOfTen[decimals], &scaled))
+    {
+        return(MODAL_UNKNOWN);
+    }
+
+    return(signbit(value) ? -(long long)scaled : (long long)scaled);
+}
+
+
+// Function name: FormatSteps()
+// Purpose: Writes a number given in steps of the last of "decimals"
+//          decimals at "cursor", without trailing zeros (or a point, for a
+//          whole number) or the sign of zero, and returns the position
+//          just after the text.
+//
+static char *FormatSteps(char *cursor, long long steps, int decimals)
+{
+    unsigned long long magnitude;
+    unsigned long long whole;
+    unsigned long long fraction;
+    char digits[24];
+    int totalDigits = 0;
+    int thisDigit;
+
+    if (steps < 0)
+    {
+        *cursor++ = '-';
+        magnitude = 0ULL - (unsigned long long)steps;
+    }
+    else
+    {
+        magnitude = (unsigned long long)steps;
+    }
+
+    whole = magnitude / PowerOfTen[decimals];
+    fraction = magnitude % PowerOfTen[decimals];
+    do
+    {
+        digits[totalDigits++] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (whole != 0);
+    while (totalDigits > 0)
+    {
+        *cursor++ = digits[--totalDigits];
+    }
+
+    if (fraction != 0)
+    {
+        while (fraction % 10 == 0)
+        {
+            fraction /= 10;
+            decimals--;
+        }
+        *cursor++ = '.';
+        for (thisDigit = decimals - 1; thisDigit >= 0; thisDigit--)
+        {
+            cursor[thisDigit] = (char)('0' + fraction % 10);
+            fraction /= 10;
+        }
+        cursor += decimals;
+    }
+
+    return(cursor);
+}
+
+
+// Function name: EmitCompact()
+// Purpose: Adds one move to the output, leaving out whatever the
+//          controller already has: the command if it is the one in
+//          effect, the F word if the feed is, and every axis whose value,
+//          to the profile's decimals, is where the wire already is. An arc
+//          always has its X/Y end and I/J. A move that changes nothing at
+//          all isn't written. "verboseLength" is what the move takes with
+//          every word written.
+//
+static void EmitCompact(OutputBuffer *output, const char *command, long feed,
+                        const float *coordinate, int totalCoordinates, size_t verboseLength)
+{
+    const Dialect *dialect = output->dialect;
+    ModalState *modal = &output->modal;
+    int decimals = dialect->compactDecimals;
+    int arc = (totalCoordinates == 6);
+    int sameCommand = (modal->command != NULL && strcmp(modal->command, command) == 0);
+    int writeFeed = (feed >= 0 && feed != modal->feed);
+    int changed[4];
+    int anyChanged = 0;
+    long long steps[6];
+    char *cursor;
+    char *start;
+    size_t length;
+    int thisCoordinate;
+
+    output->verboseBytes += verboseLength;
+
+    for (thisCoordinate = 0; thisCoordinate < totalCoordinates; thisCoordinate++)
+    {
+        steps[thisCoordinate] = QuantizeValue(coordinate[thisCoordinate], decimals);
+    }
+    for (thisCoordinate = 0; thisCoordinate < 4; thisCoordinate++)
+    {
+        changed[thisCoordinate] = !modal->known || steps[thisCoordinate] == MODAL_UNKNOWN ||
+                                  steps[thisCoordinate] != modal->position[thisCoordinate] ||
+                                  (arc && thisCoordinate < 2);
+        anyChanged |= changed[thisCoordinate];
+    }
+    if (!anyChanged && sameCommand && !writeFeed)
+    {
+        return;
+    }
+
+    MakeRoom(output);
+    start = output->buffer + output->length;
+    cursor = start;
+
+    if (!sameCommand)
+    {
+        length = strlen(command);
+        memcpy(cursor, command, length);
+        cursor += length;
+    }
+    if (writeFeed)
+    {
+        memcpy(cursor, " F", 2);
+        cursor = FormatSteps(cursor + 2, feed, 2);
+    }
+    for (thisCoordinate = 0; thisCoordinate < totalCoordinates; thisCoordinate++)
+    {
+        if (thisCoordinate < 4 && !changed[thisCoordinate])
+        {
+            continue;
+        }
+        *cursor++ = ' ';
+        *cursor++ = (thisCoordinate < 4) ? dialect->axis[thisCoordinate] :
+                                           "IJ"[thisCoordinate - 4];
+        if (steps[thisCoordinate] == MODAL_UNKNOWN)
+        {
+            cursor += sprintf(cursor, "%.*f", decimals, coordinate[thisCoordinate]);
+        }
+        else
+        {
+            cursor = FormatSteps(cursor, steps[thisCoordinate], decimals);
+        }
+    }
+    *cursor++ = '\n';
+
+    // A line that starts with the space before a word doesn't need it
+    if (*start == ' ')
+    {
+        memmove(start, start + 1, cursor - start - 1);
+        cursor--;
+    }
+
+    output->length = cursor - output->buffer;
+    output->totalLines++;
+
+    modal->known = 1;
+    modal->command = command;
+    if (feed >= 0)
+    {
+        modal->feed = feed;
+    }
+    memcpy(modal->position, steps, sizeof(modal->position));
+}
+
+
+// Function name: EmitPoint()
+// Purpose: Adds one line of airfoil coordinates to the output, the same
+//          text as "G1 F0.60 X%f Y%f U%f V%f\n" with the dialect's move
+//          command, feed and axis letters.
+//
+void EmitPoint(OutputBuffer *output, float x, float y, float u, float v)
+{
+    const Dialect *dialect = output->dialect;
+    float coordinate[4];
+    char *cursor;
+
+    if (dialect->compactDecimals >= 0)
+    {
+        coordinate[0] = x;
+        coordinate[1] = y;
+        coordinate[2] = u;
+        coordinate[3] = v;
+        EmitCompact(output, dialect->moveCommand, dialect->feedHundredths, coordinate, 4,
+                    dialect->pointPrefixLength + 3 * 2 + FixedLength(x) + FixedLength(y) +
+                    FixedLength(u) + FixedLength(v) + 1);
+        return;
+    }
+
+    MakeRoom(output);
+    cursor = output->buffer + output->length;
+
+    memcpy(cursor, dialect->pointPrefix, dialect->pointPrefixLength);
+    cursor = FormatFixed(cursor + dialect->pointPrefixLength, x);
+    memcpy(cursor, dialect->separator[0], 2);
+    cursor = FormatFixed(cursor + 2, y);
+    memcpy(cursor, dialect->separator[1], 2);
+    cursor = FormatFixed(cursor + 2, u);
+    memcpy(cursor, dialect->separator[2], 2);
+    cursor = FormatFixed(cursor + 2, v);
+    *cursor++ = '\n';
+
+    output->length = cursor - output->buffer;
+    output->totalLines++;
+}
+
+
+// Function name: FormatFeed()
+// Purpose: Writes " F" and a feed given in hundredths at "cursor", the same
+//          text as " F%.2f", and returns the position just after it.
+//
+static char *FormatFeed(char *cursor, long feed)
+{
+    char digits[24];
+    int totalDigits = 0;
+
+    memcpy(cursor, " F", 2);
+    cursor += 2;
+    do
+    {
+        digits[totalDigits++] = (char)('0' + feed % 10);
+        feed /= 10;
+    } while (feed != 0 || totalDigits < 3);
+    while (totalDigits > 2)
+    {
+        *cursor++ = digits[--totalDigits];
+    }
+    *cursor++ = '.';
+    *cursor++ = digits[1];
+    *cursor++ = digits[0];
+
+    return(cursor);
+}
+
+
+// Function name: EmitMove()
+// Purpose: Adds one move to the output: the command (such as "G1" or
+//          "G2"), an F word unless "feed" (in hundredths) is negative, and
+//          then the X, Y, U and V coordinates (with the dialect's letters),
+//          followed by I and J if there are six of them.
+//
+void EmitMove(OutputBuffer *output, const char *command, long feed,
+              const float *coordinate, int totalCoordinates)
+{
+    char letter[6];
+    char *cursor;
+    size_t length;
+    long whole;
+    int thisCoordinate;
+
+    if (output->dialect->compactDecimals >= 0)
+    {
+        // What FormatFeed() and FormatFixed() would have written
+        length = strlen(command) + 1;
+        if (feed >= 0)
+        {
+            length += 6;
+            for (whole = feed / 100; whole >= 10; whole /= 10)
+            {
+                length++;
+            }
+        }
+        for (thisCoordinate = 0; thisCoordinate < totalCoordinates; thisCoordinate++)
+        {
+            length += 2 + FixedLength(coordinate[thisCoordinate]);
+        }
+        EmitCompact(output, command, feed, coordinate, totalCoordinates, length);
+        return;
+    }
+
+    MakeRoom(output);
+    cursor = output->buffer + output->length;
+
+    memcpy(letter, output->dialect->axis, 4);
+    letter[4] = 'I';
+    letter[5] = 'J';
+
+    length = strlen(command);
+    memcpy(cursor, command, length);
+    cursor += length;
+    if (feed >= 0)
+    {
+        cursor = FormatFeed(cursor, feed);
+    }
+    for (thisCoordinate = 0; thisCoordinate < totalCoordinates; thisCoordinate++)
+    {
+        *cursor++ = ' ';
+        *cursor++ = letter[thisCoordinate];
+        cursor = FormatFixed(cursor, coordinate[thisCoordinate]);
+    }
+    *cursor++ = '\n';
+
+    output->length = cursor - output->buffer;
+    output->totalLines++;
+}
+
+
+// Function name: EmitChunks()
+// Purpose: Adds chunks of lines formatted into buffers of their own (by
+//          other threads, say) to the output, in order. For a file they
+//          are handed to writev() as they are, without being copied.
+//
+void EmitChunks(OutputBuffer *output, OutputBuffer *chunk, int totalChunks)
+{
+    struct iovec piece[EMIT_WRITE_PIECES];
+    int totalPieces = 0;
+    int thisChunk;
+
+    // Whatever is buffered comes first
+    FlushOutputBuffer(output);
+    if (output->file != NULL && fflush(output->file) != 0)
+    {
+        output->error = 1;
+    }
+
+    for (thisChunk = 0; thisChunk < totalChunks; thisChunk++)
+    {
+        output->totalLines += chunk[thisChunk].totalLines;
+        output->verboseBytes += chunk[thisChunk].verboseBytes;
+        if (output->file == NULL)
+        {
+            WriteOutput(output, chunk[thisChunk].buffer, chunk[thisChunk].length);
+            continue;
+        }
+
+        piece[totalPieces].iov_base = chunk[thisChunk].buffer;
+        piece[totalPieces].iov_len = chunk[thisChunk].length;
+        totalPieces++;
+        output->totalWritten += chunk[thisChunk].length;
+        if (totalPieces == EMIT_WRITE_PIECES || thisChunk == totalChunks - 1)
+        {
+            if (WriteWholly(fileno(output->file), piece, totalPieces) != EXIT_SUCCESS)
+            {
+                output->error = 1;
+            }
+            totalPieces = 0;
+        }
+    }
+
+    // The controller is left where the last chunk left it
+    if (totalChunks > 0)
+    {
+        output->modal = chunk[totalChunks - 1].modal;
+    }
+}
+
+
+// Function name: WriteWholly()
+// Purpose: Writes every byte of the pieces to a file descriptor, carrying
+//          on after a partial write. The pieces are used up on the way.
+//          Returns EXIT_FAILURE if a write fails.
+//
+int WriteWholly(int file, struct iovec *piece, int totalPieces)
+{
+    ssize_t written;
+
+    while (totalPieces > 0)
+    {
+        written = writev(file, piece,
+                         (totalPieces < EMIT_WRITE_PIECES) ? totalPieces : EMIT_WRITE_PIECES);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return(EXIT_FAILURE);
+        }
+
+        // Skip what was written
+        while (totalPieces > 0 && (size_t)written >= piece->iov_len)
+        {
+            written -= piece->iov_len;
+            piece++;
+            totalPieces--;
+        }
+        if (totalPieces > 0)
+        {
+            piece->iov_base = (char *)piece->iov_base + written;
+            piece->iov_len -= written;
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: TakeText()
+// Purpose: An output sink that appends the text to a TextBuffer, growing
+//          it as needed. Returns EXIT_FAILURE if memory runs out.
+//
+int TakeText(void *sinkData, const char *text, size_t length)
+{
+    TextBuffer *buffer = (TextBuffer *)sinkData;
+    size_t capacity;
+    char *grown;
+
+    if (buffer->length + length > buffer->capacity)
+    {
+        capacity = (buffer->capacity > 0) ? buffer->capacity : OUTPUT_BUFFER_SIZE;
+        while (capacity < buffer->length + length)
+        {
+            capacity *= 2;
+        }
+        grown = (char *)realloc(buffer->text, capacity);
+        if (grown == NULL)
+        {
+            return(EXIT_FAILURE);
+        }
+        buffer->text = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->text + buffer->length, text, length);
+    buffer->length += length;
+
+    return(EXIT_SUCCESS);
+}
+
+
+// --- End of emit.c
@@ -0,0 +1,121 @@
+// emit.h
+//
+// Buffered G-code output and fast coordinate formatting (see emit.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef EMIT_H          // Don't define everything more than once
+#define EMIT_H          //
+
+#include <stdio.h>
+#include <sys/uio.h>
+
+#include "dialect.h"
+
+
+// Size of the block written to the output file at a time
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+
+// Room kept free for one more line before the buffer is flushed. The
+// longest possible line (an arc with six coordinates near FLT_MAX) is well
+// below this.
+#define OUTPUT_LINE_MAX 512
+
+// Coordinates are written with this many decimals, exactly like "%f"
+#define OUTPUT_DECIMALS 6
+
+// A compact move's position on an axis that doesn't fit in 64 bits of
+// steps: always written
+#define MODAL_UNKNOWN (-0x7FFFFFFFFFFFFFFFLL - 1)
+
+// Large halves are formatted by several threads, a chunk of lines each,
+// and the chunks are written in order (see OutputHalfInParallel() in
+// gcode.c). A chunk's lines always fit in one buffer.
+#define EMIT_CHUNK_LINES (OUTPUT_BUFFER_SIZE / OUTPUT_LINE_MAX)
+#define EMIT_CHUNKS_PER_THREAD 4        // Chunks each thread formats between writes
+#define EMIT_PARALLEL_LINES (16 * EMIT_CHUNK_LINES) // Smallest half that is worth it
+#define EMIT_WRITE_PIECES 64            // Most chunks handed to one writev()
+
+
+// Takes a block of output text instead of a file (see libgcode.c).
+// Returns EXIT_FAILURE if the text can't be taken.
+typedef int (*OutputSink)(void *sinkData, const char *text, size_t length);
+
+// Output text kept in memory, grown as needed: the sink data of TakeText()
+typedef struct
+{
+    char *text;             // The text
+    size_t length;          // Bytes of text
+    size_t capacity;        // Size of "text"
+} TextBuffer;
+
+// What the controller already has, so a compact move can leave it out
+// (see EmitCompact())
+typedef struct
+{
+    int known;              // Nonzero once a move has been written since the
+                            //   last text of any other kind
+    const char *command;    // Motion command in effect
+    long feed;              // F in effect, in hundredths (-1 = not known)
+    long long position[4];  // Each axis, in steps of the last decimal written
+} ModalState;
+
+// Collects output text and writes it to the output file (or sink) in
+// large blocks
+typedef struct
+{
+    FILE *file;             // File the text is written to, or NULL for
+    OutputSink sink;        //   this sink,
+    void *sinkData;         //   which is passed this
+    const Dialect *dialect; // How moves are written (see dialect.c)
+    char *buffer;           // Text not written yet
+    int ownsBuffer;         // Nonzero if the buffer was allocated here
+    size_t length;          // Bytes of text in the buffer
+    int error;              // Nonzero once a write has failed
+    long long totalWritten; // Bytes written to the file so far
+    long long totalLines;   // Lines added so far
+    ModalState modal;       // What compact moves may leave out
+    long long verboseBytes; // Bytes the text would take with every word of
+                            //   every move written (compact output only)
+} OutputBuffer;
+
+
+// Function prototypes
+int OpenOutputBuffer(OutputBuffer *output, FILE *file, const Dialect *dialect);
+int OpenOutputSink(OutputBuffer *output, OutputSink sink, void *sinkData,
+                   const Dialect *dialect, char *storage);
+int CloseOutputBuffer(OutputBuffer *output);
+void FlushOutputBuffer(OutputBuffer *output);
+void EmitFormat(OutputBuffer *output, const char *format, ...);
+void EmitText(OutputBuffer *output, const char *text, size_t length);
+void EmitPoint(OutputBuffer *output, float x, float y, float u, float v);
+void EmitMove(OutputBuffer *output, const char *command, long feed,
+              const float *coordinate, int totalCoordinates);
+char *FormatFixed(char *cursor, float value);
+void EmitChunks(OutputBuffer *output, OutputBuffer *chunk, int totalChunks);
+int WriteWholly(int file, struct iovec *piece, int totalPieces);
+int TakeText(void *sinkData, const char *text, size_t length);
+
+
+#endif
+// --- End of emit.h
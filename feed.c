@@ -0,0 +1,242 @@
+// feed.c
+//
+// Plans the feedrate of every cutting move, so that the end of the wire
+// with further to go moves at the maximum wire speed
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// The controller runs each move at F along the combined X, Y, U, V path,
+// so a move of length L = sqrt(root^2 + tip^2) takes L / F minutes, and
+// the root end moves at F * root / L (likewise the tip). The fastest feed
+// that keeps both ends at or below the maximum wire speed is therefore
+// maxSpeed * L / max(root, tip). The two ends of the wire each stay in
+// their own plane, so their path lengths are measured in X/Y and U/V.
+//
+// Feeds are rounded down to the hundredths written in the file, and an F
+// word is only written when the feed changes. Planning happens as each
+// move is written, so it adds no pass of its own.
+//
+
+
+#include <math.h>
+
+#include "gcode.h"
+#include "emit.h"
+#include "feed.h"
+
+
+#define TWO_PI (2.0 * 3.14159265358979323846)
+
+
+// Function name: InitializeFeedPlanner()
+// Purpose: Prepares a planner for a new output file. A maximum speed of 0
+//          writes every move at the profile's feed, exactly as without one.
+//
+void InitializeFeedPlanner(FeedPlanner *planner, double maxSpeed, const Dialect *dialect)
+{
+    planner->dialect = dialect;
+    planner->maxSpeed = maxSpeed;
+    planner->feed = -1;
+    planner->constantTime = 0.0;
+    planner->plannedTime = 0.0;
+    BeginPlannedHalf(planner);
+}
+
+
+// Function name: BeginPlannedHalf()
+// Purpose: Notes that the wire is where the header and the transition
+//          between the halves leave it, ready to cut the next half.
+//
+void BeginPlannedHalf(FeedPlanner *planner)
+{
+    planner->position[0] = planner->dialect->xMin;
+    planner->position[1] = planner->dialect->yMin;
+    planner->position[2] = planner->dialect->xMin;
+    planner->position[3] = planner->dialect->yMin;
+}
+
+
+// Function name: ResumeFeedPlanner()
+// Purpose: Readies the planner for the lower half. EndPlannedHalf() always
+//          leaves the profile's feed in effect, so the lower half is planned
+//          the same whether the upper one was just written or not.
+//
+void ResumeFeedPlanner(FeedPlanner *planner)
+{
+    BeginPlannedHalf(planner);
+    if (planner->maxSpeed > 0.0)
+    {
+        planner->feed = planner->dialect->feedHundredths;
+    }
+}
+
+
+// Function name: EndPlannedHalf()
+// Purpose: Puts the feed back to the profile's after a planned half, so
+//          that the wire reset moves run exactly as they always have.
+//
+void EndPlannedHalf(FeedPlanner *planner, OutputBuffer *output)
+{
+    if (planner->maxSpeed <= 0.0 || planner->feed == planner->dialect->feedHundredths)
+    {
+        return;
+    }
+
+    EmitFormat(output, "%s\n", planner->dialect->feedWord);
+    planner->feed = planner->dialect->feedHundredths;
+}
+
+
+// Function name: PlanMove()
+// Purpose: Works out the feed for a move whose ends travel "root" and
+//          "tip", adds up how long it takes, and returns the feed to write
+//          (in hundredths), or -1 if it is the feed already in effect.
+//
+static long PlanMove(FeedPlanner *planner, double root, double tip)
+{
+    double length = sqrt(root * root + tip * tip);
+    double longest = (root > tip) ? root : tip;
+    double speed;
+    long feed;
+
+    planner->constantTime += length / (planner->dialect->feedHundredths / 100.0);
+
+    // A move that goes nowhere can keep whatever feed is in effect
+    if (longest <= 0.0)
+    {
+        if (planner->feed >= 0)
+        {
+            return(-1);
+        }
+        planner->feed = planner->dialect->feedHundredths;
+        return(planner->feed);
+    }
+
+    // No faster than a profile's feed may be, so the feed fits its word
+    speed = 100.0 * planner->maxSpeed * length / longest;
+    if (speed > DIALECT_FEED_MAX * 100.0)
+    {
+        speed = DIALECT_FEED_MAX * 100.0;
+    }
+    feed = (long)floor(speed);
+    if (feed < 1)
+    {
+        feed = 1;
+    }
+    planner->plannedTime += length / (feed / 100.0);
+
+    if (feed == planner->feed)
+    {
+        return(-1);
+    }
+    planner->feed = feed;
+
+    return(feed);
+}
+
+
+// Function name: PlanPoint()
+// Purpose: Writes a straight move to (x, y, u, v), at the profile's feed if
+//          the planner has no maximum speed, or else at the fastest feed
+//          the maximum allows.
+//
+void PlanPoint(FeedPlanner *planner, OutputBuffer *output, float x, float y, float u, float v)
+{
+    float coordinate[4];
+    long feed;
+
+    if (planner->maxSpeed <= 0.0)
+    {
+        EmitPoint(output, x, y, u, v);
+        return;
+    }
+
+    feed = PlanMove(planner,
+                    hypot(x - planner->position[0], y - planner->position[1]),
+                    hypot(u - planner->position[2], v - planner->position[3]));
+
+    coordinate[0] = x;
+    coordinate[1] = y;
+    coordinate[2] = u;
+    coordinate[3] = v;
+    EmitMove(output, planner->dialect->moveCommand, feed, coordinate, 4);
+
+    planner->position[0] = x;
+    planner->position[1] = y;
+    planner->position[2] = u;
+    planner->position[3] = v;
+}
+
+
+// Function name: PlanArc()
+// Purpose: Writes an arc to (x, y, u, v) whose center is (i, j) from where
+//          it starts, with its feed chosen like PlanPoint(). The root
+//          travels around the arc and the tip in a straight line.
+//
+void PlanArc(FeedPlanner *planner, OutputBuffer *output, int clockwise,
+             float x, float y, float u, float v, float i, float j)
+{
+    const char *command = clockwise ? planner->dialect->arcClockwise :
+                                      planner->dialect->arcCounterclockwise;
+    float coordinate[6];
+    double centerX;
+    double centerY;
+    double sweep;
+    long feed = planner->dialect->feedHundredths;
+
+    coordinate[0] = x;
+    coordinate[1] = y;
+    coordinate[2] = u;
+    coordinate[3] = v;
+    coordinate[4] = i;
+    coordinate[5] = j;
+
+    if (planner->maxSpeed > 0.0)
+    {
+        // Angle turned through, in the arc's direction
+        centerX = planner->position[0] + i;
+        centerY = planner->position[1] + j;
+        sweep = atan2(y - centerY, x - centerX) - atan2(-j, -i);
+        if (clockwise)
+        {
+            sweep = -sweep;
+        }
+        sweep = fmod(sweep, TWO_PI);
+        if (sweep < 0.0)
+        {
+            sweep += TWO_PI;
+        }
+
+        feed = PlanMove(planner, hypot(i, j) * sweep,
+                        hypot(u - planner->position[2], v - planner->position[3]));
+
+        planner->position[0] = x;
+        planner->position[1] = y;
+        planner->position[2] = u;
+        planner->position[3] = v;
+    }
+
+    EmitMove(output, command, feed, coordinate, 6);
+}
+
+
+// --- End of feed.c
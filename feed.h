@@ -0,0 +1,60 @@
+// feed.h
+//
+// Feedrate planning: the fastest feed for each move that keeps both ends
+// of the wire within a maximum speed (see feed.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef FEED_H          // Don't define everything more than once
+#define FEED_H          //
+
+#include "emit.h"
+#include "dialect.h"
+
+
+// Follows the wire through the cutting moves of one output file
+typedef struct
+{
+    const Dialect *dialect; // Commands, feed and limits of the machine
+    double maxSpeed;        // Fastest either end of the wire may move, in
+                            //   output units per minute (0 = every move at
+                            //   the profile's feed, as without a planner)
+    double position[4];     // Where the wire is: X, Y, U, V
+    long feed;              // F in effect, in hundredths (-1 = none yet)
+    double constantTime;    // Minutes the moves take at the profile's feed
+    double plannedTime;     // Minutes they take at the planned feeds
+} FeedPlanner;
+
+
+// Function prototypes
+void InitializeFeedPlanner(FeedPlanner *planner, double maxSpeed, const Dialect *dialect);
+void BeginPlannedHalf(FeedPlanner *planner);
+void ResumeFeedPlanner(FeedPlanner *planner);
+void EndPlannedHalf(FeedPlanner *planner, OutputBuffer *output);
+void PlanPoint(FeedPlanner *planner, OutputBuffer *output, float x, float y, float u, float v);
+void PlanArc(FeedPlanner *planner, OutputBuffer *output, int clockwise,
+             float x, float y, float u, float v, float i, float j);
+
+
+#endif
+// --- End of feed.h
@@ -1,430 +1,1896 @@
-// gcode.c
-//
-// Takes separate airfoil coordinate files and outputs a single GCode file 
-// for CAM processing
-// 
-// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
-//
-// This program is free software; you can redistribute it and/or
-// modify it under the terms of the GNU General Public License
-// as published by the Free Software Foundation; either version 2
-// of the License, or (at your option) any later version.
-//
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-// GNU General Public License for more details.
-//
-// You should have received a copy of the GNU General Public License
-// along with this program; if not, write to the Free Software
-// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, 
-// USA.
-//
-// See LICENSE for the full license text, or view it here:
-// http://www.gnu.org/licenses/gpl-2.0.html
-//
-//
-// Revision History:
-//
-// v0.9.4, 9/4/2017
-//     - [3ebee92] Fixed GitHub issue #2 (Valgrind Errors) related to
-//       'filename' scratch variable.
-// v0.9.3, 2/1/2012
-//     - Moved project to GitHub / git
-//     - Updated copyright and copyright holder's contact information
-//     - Renamed "readme.txt" to "README" and added additional content
-//     - Added "LICENSE" file, containing GPLv2 license
-// v0.9.2, 12/7/2010
-//     - Created Google Code / Mercurial project for version control at
-//       http://gcode.googlecode.com
-//     - Project is now covered under the GNU General Public License v2
-//       (full version included as #define LICENSE="..." in gcode.h)
-//     - Renamed source file "main.c" to "gcode.c"
-// v0.9.1, 12/6/2010
-//     - Modified the final Wire Reset commands to prevent the wire from
-//       cutting the airfoil in half
-//     - Successful CAM simulation of separate Upper and Lower airfoil halves
-//     - Added coordinate scalar to X, Y, U and V axes. The program will scale
-//       all data points by this number as they are read from the input files
-// v0.9.0, 12/3/2010
-//     - Refactored all previous versions to Minor Version x.8.x (from x.9)
-//     - Added concept of "Half" and associated enum to represent Upper and
-//       Lower airfoil halves for each Side
-//     - Modified input file processing to accept eight files (vs. six).
-//       The filenames are: ROOTUPPERX, ROOTUPPERY, ROOTLOWERX, ROOTLOWERY,
-//       TIPUPPERX, TIPUPPERY, TIPLOWERX, TIPLOWERY
-//     - Feedrate is now fixed to a constant value
-//     - Renamed axis[][][] to thisVector[][][]
-// v0.8.2, 12/1/2010
-//     - Added Revision History
-//     - Adjusted source code tabs and line breaks to improve readability,
-//       and revised comments
-//     - Refactored the concept of "Sides" to replace Upper and Lower
-//       with Root and Tip
-//     - Increased F dimension decimal precision from n.n to n.nn
-// v0.8.1, 11/30/2010
-//     - Added source code comments
-//     - Adjusted output header and footer string processing to be somewhat
-//       more flexible
-//     - Verified to compile and run with GCC on Windows, Linux, and Mac OS X
-//     - First successful CAM simulation of GCode output
-// v0.8.0 (source unversioned)
-//     - Initial Proof-of-concept
-//
-
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-#include "gcode.h"
-
-
-// Declare the variable that holds the vector data
-Vector thisVector[TOTAL_SIDES][TOTAL_HALVES][TOTAL_DIMENSIONS_PER_HALF];
-
-
-////////// MAIN PROGRAM BLOCK //////////
-int main (int argc, const char *argv[])
-{
-    OpenDataFiles();
-    atexit(CloseDataFiles);
-        
-    CheckVectorConsistency();
-        
-    AllocateMemory();
-    atexit(FreeMemory);
-        
-    ReadVectorData();
-    OutputGCode();
-                
-    // Normal program exit
-    return(EXIT_SUCCESS);
-}
-////////////////////////////////////////
-
-
-// Function name: OpenDataFiles()
-// Purpose: Opens all input and output files requred by the program. This
-//          function also reads the first numerical value from the file, which
-//          should be the total number of values to follow.
-//
-void OpenDataFiles()
-{
-    enum Side thisSide;
-    enum Half thisHalf;
-    enum Dimension thisDimension;
-
-    char *filename; // This local variable is a scratchpad for constructing
-                    // a dynamic filename
-        
-        
-    // Open the output file
-    outputFile = fopen(OUTPUT_FILENAME, WRITEONLY);
-                
-    // Open all vector input files
-    for (thisSide = Root; thisSide <= Tip; thisSide++)
-    {
-        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
-        {
-            for (thisDimension = X; thisDimension <= Y; thisDimension++)
-            {
-                // Allocate memory for the local variable which will hold
-                // the input filename
-                filename = (char *)malloc(strlen(SideToString[thisSide]) +
-                           strlen(HalfToString[thisHalf]) +
-                           strlen(DimensionToString[thisDimension]) + 1);
-                // Populate that variable with a dynamically-generated
-                // input filename
-                strcpy(filename, SideToString[thisSide]);
-                strcat(filename, HalfToString[thisHalf]);
-                strcat(filename, DimensionToString[thisDimension]);
-                // Open the file
-                thisVector[thisSide][thisHalf][thisDimension].inputFile =
-                  fopen(filename, READONLY);
-                // See if the file actually opened
-                if (thisVector[thisSide][thisHalf][thisDimension].inputFile == NULL)
-                {
-                    // If it didn't...
-                    fprintf(stderr, MESSAGE_ERROR);
-                    fprintf(stderr, MESSAGE_FILE_OPENERROR, filename);                              
-                    // Exit
-                    exit(EXIT_FAILURE);
-                }
-                // Read the first value of the file: The total number of
-                // point values for this vector
-                fscanf(thisVector[thisSide][thisHalf][thisDimension].inputFile, "%d",
-                   &thisVector[thisSide][thisHalf][thisDimension].totalValues);
-                // See if the value a number greater than zero
-                if (thisVector[thisSide][thisHalf][thisDimension].totalValues <= 0)
-                {
-                    // If it's not...
-                    fprintf(stderr, MESSAGE_ERROR);
-                    fprintf(stderr, MESSAGE_FILE_READERROR, filename);
-                    // Exit
-                    exit(EXIT_FAILURE);
-                }
-                // Free the memory used by the filename variable
-                free(filename);
-            }
-        }
-    }
-}
-        
-
-// Function name: CloseDataFiles()
-// Purpose: Closes all input and output files required by the program.
-//
-void CloseDataFiles()
-{
-    enum Side thisSide;
-    enum Half thisHalf;
-    enum Dimension thisDimension;
-        
-    // Close the output file
-    fclose(outputFile);
-        
-    // Iterate through all vectors...
-    for (thisSide = Root; thisSide <= Tip; thisSide++)
-    {
-        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
-        {        
-            for (thisDimension = X; thisDimension <= Y; thisDimension++)
-            {                       
-                // Close the input file
-                fclose(thisVector[thisSide][thisHalf][thisDimension].inputFile);        
-            }
-        }
-    }
-}
-
-
-// Function name: AllocateMemory()
-// Purpose: Requests RAM from the operating system. This memory is then used
-//          to store the all of the vector data points.
-//
-void AllocateMemory()
-{
-    enum Side thisSide;
-    enum Half thisHalf;
-    enum Dimension thisDimension;
-        
-    // Iterate through all vectors...
-    for (thisSide = Root; thisSide <= Tip; thisSide++)
-    {
-        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
-        {        
-            for (thisDimension = X; thisDimension <= Y; thisDimension++)
-            {
-                // Allocate memory based on the total number of data values
-                thisVector[thisSide][thisHalf][thisDimension].value = 
-                  (float *)malloc(thisVector[thisSide][thisHalf][thisDimension].totalValues *
-                  sizeof(float));
-                // See if the memory allocation is successful
-                if (thisVector[thisSide][thisHalf][thisDimension].value == NULL)
-                {
-                    // If it's not...
-                    fprintf(stderr, MESSAGE_ERROR);
-                    fprintf(stderr, MESSAGE_MEMORY_ALLOCERROR);
-                    // Exit
-                    exit(EXIT_FAILURE);
-                }
-            }
-        }
-    }
-}
-
-
-// Function name: FreeMemory()
-// Purpose: Releases all allocated vector data point memory back to
-//          the operating system.
-//
-void FreeMemory()
-{
-    enum Side thisSide;
-    enum Half thisHalf;
-    enum Dimension thisDimension;
-        
-    // Iterate through all vectors...
-    for (thisSide = Root; thisSide <= Tip; thisSide++)
-    {
-        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
-        {       
-            for (thisDimension = X; thisDimension <= Y; thisDimension++)
-            {
-                // Free allocated memory
-                free(thisVector[thisSide][thisHalf][thisDimension].value);
-            }
-        }
-    }
-}
-
-
-// Function name: CheckVectorConsistency()
-// Purpose: Performs a quick check to see if all vectors advertise
-//          the same number of data points. Displays a warning if not.
-//
-void CheckVectorConsistency()
-{
-    enum Side thisSide;
-    enum Half thisHalf;
-    enum Dimension thisDimension;
-        
-    int reference;
-    
-    // Select an arbitrary reference
-    reference = 
-     thisVector[thisSide = Tip][thisHalf = Lower][thisDimension = Y].totalValues;
-        
-    // Check every other vector against that reference
-    if (!((thisVector[thisSide = Root][thisHalf = Upper][thisDimension = X].totalValues == reference)
-     && (thisVector[thisSide = Root][thisHalf = Upper][thisDimension = Y].totalValues == reference)
-     && (thisVector[thisSide = Root][thisHalf = Lower][thisDimension = X].totalValues == reference)
-     && (thisVector[thisSide = Root][thisHalf = Lower][thisDimension = Y].totalValues == reference)
-     && (thisVector[thisSide = Tip][thisHalf = Upper][thisDimension = X].totalValues == reference)
-     && (thisVector[thisSide = Tip][thisHalf = Upper][thisDimension = Y].totalValues == reference)
-     && (thisVector[thisSide = Tip][thisHalf = Lower][thisDimension = X].totalValues == reference)))
-    {
-        // If they aren't consistent...
-        fprintf(stderr, MESSAGE_WARNING);
-        fprintf(stderr, MESSAGE_VECTOR_CONSISTENCY);
-    }
-}
-
-
-// Function name: ReadVectorData()
-// Purpose: Reads all vector data points from their files and
-//          into allocated memory.
-//
-void ReadVectorData()
-{
-    enum Side thisSide;
-    enum Half thisHalf;
-    enum Dimension thisDimension;
-        
-    int thisValue;
-    int result;
-        
-    // Iterate through all vectors...
-    for (thisSide = Root; thisSide <= Tip; thisSide++)
-    {
-        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
-        {  
-            for (thisDimension = X; thisDimension <= Y; thisDimension++)
-            {                       
-                // Read all data values into allocated memory
-                for (thisValue = 0;
-                     thisValue < thisVector[thisSide][thisHalf][thisDimension].totalValues;
-                     thisValue++)
-                {
-                    // Read the value from the proper input file. The success
-                    // or failure of the read operation is stored in the "result"
-                    // variable.
-                    result = fscanf(thisVector[thisSide][thisHalf][thisDimension].inputFile, "%f",
-                             &thisVector[thisSide][thisHalf][thisDimension].value[thisValue]);
-                    // Scale the value by the coordinate scalar
-                    thisVector[thisSide][thisHalf][thisDimension].value[thisValue] *= XYUV_COORDINATE_SCALAR;
-                    // See if End-of-File was reached unexpectedly
-                    if (result == EOF)
-                    {
-                        // If it was...
-                        fprintf(stderr, MESSAGE_WARNING);
-                        fprintf(stderr, MESSAGE_VECTOR_EOF);
-                        // Just abort reading this vector; don't exit the program.
-                        break;
-                    }
-                }
-            }
-        }
-    }
-}
-
-
-// Function name: OutputGCode()
-// Purpose: Produces valid GCode from the raw data points and writes 
-//          it to an output file. This function does not buffer writes to be
-//          "actually written" at a later time -- All writes are performed
-//          in real-time.
-//
-void OutputGCode()
-{
-    enum Side thisSide;
-    enum Half thisHalf;
-    enum Dimension thisDimension;
-
-    int thisValue;
-    int result;
-
-
-    // Output the GCode header ////////////////////////////////////////////////
-    fprintf(outputFile, GCODE_HEADER);
-    ///////////////////////////////////////////////////////////////////////////
-
-        
-    // Iterate through all of the data points for the Upper airfoil half, using
-    // TIPUPPERX as the reference for the total number of data points.
-    thisHalf = Upper;
-    for (thisValue = 0;
-         thisValue < thisVector[thisSide = Tip][thisHalf][thisDimension = X].totalValues;
-         thisValue++)
-    {
-        // Output one line of airfoil coordinates /////////////////////////////
-        fprintf(outputFile, "%s %s %s%f %s%f ",
-                GCODE_MOVE_COMMAND,
-                GCODE_FEEDRATE,
-                DimensionToString[thisDimension = X],
-                thisVector[thisSide = Root][thisHalf][thisDimension = X].value[thisValue],
-                DimensionToString[thisDimension = Y],
-                thisVector[thisSide = Root][thisHalf][thisDimension = Y].value[thisValue]);
-        fprintf(outputFile, "U%f V%f\n", 
-                thisVector[thisSide = Tip][thisHalf][thisDimension = X].value[thisValue],
-                thisVector[thisSide = Tip][thisHalf][thisDimension = Y].value[thisValue]);
-        ///////////////////////////////////////////////////////////////////////
-    }
-        
-        
-    // Output the transition between the Upper and Lower halves ///////////////
-    fprintf(outputFile, GCODE_UPPERLOWER_TRANSITION);
-    ///////////////////////////////////////////////////////////////////////////
-        
-        
-    // Iterate through all of the data points for the Lower airfoil half, using
-    // TIPLOWERX as the reference for the total number of data points.
-    thisHalf = Lower;
-    for (thisValue = 0;
-        thisValue < thisVector[thisSide = Tip][thisHalf][thisDimension = X].totalValues;
-         thisValue++)
-    {
-        // Output one line of airfoil coordinates /////////////////////////////
-        fprintf(outputFile, "%s %s %s%f %s%f ",
-                GCODE_MOVE_COMMAND,
-                GCODE_FEEDRATE,
-                DimensionToString[thisDimension = X],
-                thisVector[thisSide = Root][thisHalf][thisDimension = X].value[thisValue],
-                DimensionToString[thisDimension = Y],
-                thisVector[thisSide = Root][thisHalf][thisDimension = Y].value[thisValue]);
-        fprintf(outputFile, "U%f V%f\n", 
-                thisVector[thisSide = Tip][thisHalf][thisDimension = X].value[thisValue],
-                thisVector[thisSide = Tip][thisHalf][thisDimension = Y].value[thisValue]);
-        ///////////////////////////////////////////////////////////////////////
-    }   
-
-        
-    // Output the GCode footer ////////////////////////////////////////////////
-    result = fprintf(outputFile, GCODE_FOOTER);
-    ///////////////////////////////////////////////////////////////////////////
-    
-       
-    // See if the final write to the output file failed
-    if (result < 0)
-    {
-        // If it did...
-        fprintf(stderr, MESSAGE_ERROR);
-        fprintf(stderr, MESSAGE_FILE_WRITEERROR, OUTPUT_FILENAME);
-        // Exit
-        exit(EXIT_FAILURE);
-    }
-}
-
-
-// --- End of gcode.c
+// gcode.c
+//
+// Takes separate airfoil coordinate files and outputs a single GCode file 
+// for CAM processing
+// 
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, 
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// Revision History:
+//
+// v0.10.0, 10/16/2026
+//     - Added batch mode ("--batch"), which runs every job folder listed in
+//       a manifest or found under a directory on a work-stealing thread
+//       pool (see batch.c and pool.c)
+//     - Replaced the global thisVector[][][] and outputFile with a per-job
+//       context. Errors now fail only the job they belong to.
+//     - Replaced the per-value fscanf() calls with a block-buffered number
+//       parser (see parse.c). Values that aren't numbers are now reported
+//       with their line and column instead of being silently misread.
+//     - Point lines are now formatted with integer arithmetic and written
+//       in large blocks (see emit.c). The text is unchanged.
+//     - Added binary section files (SECTION.gcs), which hold all eight
+//       vectors and are mapped into memory instead of parsed, and the
+//       "--pack" / "--unpack" converters (see section.c). The coordinate
+//       scalar is now applied as points are written, not as they are read.
+//     - The output file is only created once the input has been loaded
+//     - Added streaming mode ("--stream"), which reads the four files of
+//       each half in lockstep while writing, so memory use no longer grows
+//       with the number of data points (see stream.c)
+//     - Added per-side placement ("--root-transform", "--tip-transform"):
+//       chord scale, twist about a pivot, sweep and dihedral offsets and
+//       mirroring, applied to whole arrays with SIMD (see transform.c)
+//     - Added tool path reduction ("--reduce", "--arcs"): collinear runs
+//       are merged and the rest simplified to within a tolerance, with
+//       optional G2/G3 arcs, keeping root and tip in step (see reduce.c)
+//     - Added spline resampling ("--resample", "--cluster"). A half whose
+//       vectors list different numbers of points is now resampled to a
+//       common count instead of read past the end of the shorter ones
+//       (see resample.c).
+//     - Added feedrate planning ("--max-wire-speed"): each move gets the
+//       fastest feed that keeps both ends of the wire within the maximum,
+//       and F is only written when it changes (see feed.c)
+//     - Added machine profiles ("--profile"): the header, transition,
+//       footer, commands, axis letters, units, feed, limits and coordinate
+//       scale are read at run time instead of compiled in. The built-in
+//       profile writes exactly what the old macros did (see dialect.c).
+//     - Added job statistics ("--stats", "--stats-json"): the time spent in
+//       each stage, bytes read and written, lines and points written, peak
+//       memory and parse errors (see stats.c)
+//     - Split everything but the command line into a library ("libgcode.a")
+//       that renders from the caller's arrays into a buffer or callback,
+//       from any number of threads at once (see libgcode.c). The command
+//       line is now in main.c.
+//     - Added server mode ("--serve", "--max-in-flight"), which renders jobs
+//       sent over a Unix domain socket on a pool of workers, each reusing
+//       an arena for its buffers, and the "gcode_client" program (see
+//       server.c, arena.c and client.c)
+//     - Added the output cache ("--cache", "--cache-limit", "--cache-stats"):
+//       outputs are kept under an XXH64 key of the inputs and settings and
+//       hard-linked into place when the same job comes again, with LRU
+//       eviction (see cache.c and hash.c). OUTPUT.txt is now replaced
+//       rather than rewritten.
+//     - Added watch mode ("--watch"), which regenerates the output whenever
+//       the input files change, rendering only the half that changed and
+//       replacing the output through a temporary file (see watch.c)
+//     - Large halves are now formatted in chunks by the "--jobs" threads and
+//       written in order with writev() (see OutputHalfInParallel())
+//     - A single job now opens and reads its eight input files at the same
+//       time, reporting problems afterwards in the usual order
+//     - Input files may be gzip- or zstd-compressed, and are decompressed a
+//       block at a time as they are parsed; "--compress" writes the output
+//       through a streaming compressor (see compress.c)
+//     - Added lofting ("--loft", "--combine"): a wing of several stations,
+//       listed in a STATIONS file, is cut as one bay per pair of stations,
+//       each station read once and the bays rendered at the same time
+//       (see loft.c)
+//     - Every job is now checked against the cutter's limits before it is
+//       written, and "--verify" reads a program back and reports its
+//       bounds, wire skew and cut time (see verify.c)
+//     - Added compact output ("--compact", or "compact" in a profile): only
+//       the words that change from move to move are written, to a chosen
+//       number of decimals (see EmitCompact())
+// v0.9.4, 9/4/2017
+//     - [3ebee92] Fixed GitHub issue #2 (Valgrind Errors) related to
+//       'filename' scratch variable.
+// v0.9.3, 2/1/2012
+//     - Moved project to GitHub / git
+//     - Updated copyright and copyright holder's contact information
+//     - Renamed "readme.txt" to "README" and added additional content
+//     - Added "LICENSE" file, containing GPLv2 license
+// v0.9.2, 12/7/2010
+//     - Created Google Code / Mercurial project for version control at
+//       http://gcode.googlecode.com
+//     - Project is now covered under the GNU General Public License v2
+//       (full version included as #define LICENSE="..." in gcode.h)
+//     - Renamed source file "main.c" to "gcode.c"
+// v0.9.1, 12/6/2010
+//     - Modified the final Wire Reset commands to prevent the wire from
+//       cutting the airfoil in half
+//     - Successful CAM simulation of separate Upper and Lower airfoil halves
+//     - Added coordinate scalar to X, Y, U and V axes. The program will scale
+//       all data points by this number as they are read from the input files
+// v0.9.0, 12/3/2010
+//     - Refactored all previous versions to Minor Version x.8.x (from x.9)
+//     - Added concept of "Half" and associated enum to represent Upper and
+//       Lower airfoil halves for each Side
+//     - Modified input file processing to accept eight files (vs. six).
+//       The filenames are: ROOTUPPERX, ROOTUPPERY, ROOTLOWERX, ROOTLOWERY,
+//       TIPUPPERX, TIPUPPERY, TIPLOWERX, TIPLOWERY
+//     - Feedrate is now fixed to a constant value
+//     - Renamed axis[][][] to thisVector[][][]
+// v0.8.2, 12/1/2010
+//     - Added Revision History
+//     - Adjusted source code tabs and line breaks to improve readability,
+//       and revised comments
+//     - Refactored the concept of "Sides" to replace Upper and Lower
+//       with Root and Tip
+//     - Increased F dimension decimal precision from n.n to n.nn
+// v0.8.1, 11/30/2010
+//     - Added source code comments
+//     - Adjusted output header and footer string processing to be somewhat
+//       more flexible
+//     - Verified to compile and run with GCC on Windows, Linux, and Mac OS X
+//     - First successful CAM simulation of GCode output
+// v0.8.0 (source unversioned)
+//     - Initial Proof-of-concept
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "gcode.h"
+#include "batch.h"
+#include "cache.h"
+#include "compress.h"
+#include "emit.h"
+#include "feed.h"
+#include "parse.h"
+#include "pool.h"
+#include "reduce.h"
+#include "resample.h"
+#include "section.h"
+#include "stream.h"
+#include "verify.h"
+
+
+// Names used to build the input filenames
+char *SideToString[] = { "ROOT", "TIP" };
+char *HalfToString[] = { "UPPER", "LOWER" };
+char *DimensionToString[] = { "X", "Y" };
+
+
+// Function name: InitializeSettings()
+// Purpose: Fills in the settings used when nothing is given on the command
+//          line.
+//
+void InitializeSettings(Settings *settings)
+{
+    enum Side thisSide;
+
+    memset(settings, 0, sizeof(Settings));
+    settings->cacheLimit = CACHE_DEFAULT_LIMIT * 1024LL * 1024LL;
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        InitializeTransform(&settings->transform[thisSide]);
+    }
+}
+
+
+// Function name: InitializeJob()
+// Purpose: Prepares an empty job whose input and output files live in the
+//          given directory (or in the current working directory if NULL).
+//          "settings" may be NULL for a job that only names its files.
+//
+void InitializeJob(Job *job, const char *directory, const Settings *settings)
+{
+    memset(job, 0, sizeof(Job));
+    job->directory = directory;
+    job->settings = settings;
+    job->stats.enabled = (settings != NULL && settings->statsFormat != NoStats);
+    job->threads = 1;
+}
+
+
+// Function name: ParseNumberOption()
+// Purpose: Reads an option's value, which has to be a finite number and
+//          nothing else. Returns 0 if it isn't one.
+//
+static int ParseNumberOption(const char *text, double *number)
+{
+    char *end;
+
+    *number = strtod(text, &end);
+
+    return(end != text && *end == '\0' && isfinite(*number));
+}
+
+
+// Function name: ParseCountOption()
+// Purpose: Reads an option's value, which has to be a whole number that
+//          fits an int and nothing else. Returns 0 if it isn't one.
+//
+static int ParseCountOption(const char *text, int *count)
+{
+    char *end;
+    long number;
+
+    errno = 0;
+    number = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || number < INT_MIN || number > INT_MAX)
+    {
+        return(0);
+    }
+    *count = (int)number;
+
+    return(1);
+}
+
+
+// Function name: ParseJobOption()
+// Purpose: Applies argv[*thisArgument] to the settings if it is one of the
+//          options that change how a job's G-code is made, moving
+//          *thisArgument on past its value. Returns 1 if it was, 0 if it
+//          is some other option and -1 if its placement can't be parsed.
+//          Used for the command line and for server requests alike.
+//
+int ParseJobOption(Settings *settings, int argc, const char *argv[], int *thisArgument)
+{
+    enum Side thisSide;
+    const char *option = argv[*thisArgument];
+    int hasValue = (*thisArgument + 1 < argc);
+    double number;
+    int count;
+
+    if ((strcmp(option, "--root-transform") == 0 ||
+         strcmp(option, "--tip-transform") == 0) && hasValue)
+    {
+        thisSide = (strcmp(option, "--root-transform") == 0) ? Root : Tip;
+        if (ParseTransform(argv[++*thisArgument], &settings->transform[thisSide]) != EXIT_SUCCESS)
+        {
+            return(-1);
+        }
+    }
+    else if (strcmp(option, "--resample") == 0 && hasValue &&
+             ParseCountOption(argv[*thisArgument + 1], &count) && count >= 2)
+    {
+        settings->resampleTotal = count;
+        ++*thisArgument;
+    }
+    else if (strcmp(option, "--cluster") == 0)
+    {
+        settings->clustering = 1;
+    }
+    else if (strcmp(option, "--reduce") == 0 && hasValue &&
+             ParseNumberOption(argv[*thisArgument + 1], &number) && number >= 0.0)
+    {
+        settings->reducing = 1;
+        settings->tolerance = number;
+        ++*thisArgument;
+    }
+    else if (strcmp(option, "--arcs") == 0)
+    {
+        settings->fitArcs = 1;
+    }
+    else if (strcmp(option, "--max-wire-speed") == 0 && hasValue &&
+             ParseNumberOption(argv[*thisArgument + 1], &number) && number > 0.0)
+    {
+        settings->maxWireSpeed = number;
+        ++*thisArgument;
+    }
+    else
+    {
+        return(0);
+    }
+
+    return(1);
+}
+
+
+// Function name: RunJob()
+// Purpose: Runs the whole pipeline for one job, from opening the input files
+//          to writing the output file, and releases everything it acquired.
+//          Returns EXIT_SUCCESS or EXIT_FAILURE; a failing job never exits
+//          the program, so other jobs are not affected.
+//
+int RunJob(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    double jobStart = BeginStage(&job->stats);
+    double start;
+    int result;
+    int cached = 0;
+
+    // Output made before from the same inputs and settings is used as is
+    if (job->settings->cacheDirectory != NULL)
+    {
+        start = BeginStage(&job->stats);
+        cached = (FetchCachedOutput(job) == EXIT_SUCCESS);
+        EndStage(&job->stats, StageCache, start);
+    }
+    if (cached)
+    {
+        EndStage(&job->stats, StageTotal, jobStart);
+        ReportStats(&job->stats, job->directory, job->settings->statsFormat, 1);
+        return(EXIT_SUCCESS);
+    }
+
+    result = LoadVectorData(job);
+    if (result == EXIT_SUCCESS)
+    {
+        result = BuildToolPaths(job);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        start = BeginStage(&job->stats);
+        result = OutputGCode(job);
+        EndStage(&job->stats, StageEmit, start);
+    }
+
+    FreeMemory(job);
+    CloseDataFiles(job);
+    if (result == EXIT_SUCCESS && job->settings->cacheDirectory != NULL)
+    {
+        start = BeginStage(&job->stats);
+        StoreCachedOutput(job);
+        EndStage(&job->stats, StageCache, start);
+    }
+    EndStage(&job->stats, StageTotal, jobStart);
+
+    // Every reader counted what it read
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                job->stats.bytesRead +=
+                  job->thisVector[thisSide][thisHalf][thisDimension].reader.totalRead;
+            }
+        }
+    }
+    ReportStats(&job->stats, job->directory, job->settings->statsFormat,
+                result == EXIT_SUCCESS);
+
+    return(result);
+}
+
+
+// Function name: BuildToolPaths()
+// Purpose: Turns the loaded vectors into what OutputGCode() writes:
+//          resampled, placed and reduced as the settings ask, and checked
+//          against the cutter's limits.
+//
+int BuildToolPaths(Job *job)
+{
+    double start;
+    int result;
+
+    start = BeginStage(&job->stats);
+    result = ResampleVectors(job);
+    EndStage(&job->stats, StageResample, start);
+    if (result == EXIT_SUCCESS)
+    {
+        start = BeginStage(&job->stats);
+        result = ApplyTransforms(job);
+        EndStage(&job->stats, StageTransform, start);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        start = BeginStage(&job->stats);
+        result = ReduceToolPaths(job);
+        EndStage(&job->stats, StageReduce, start);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        start = BeginStage(&job->stats);
+        result = CheckEnvelope(job);
+        EndStage(&job->stats, StageEnvelope, start);
+    }
+
+    return(result);
+}
+
+
+// Function name: LoadVectorData()
+// Purpose: Gets the values of all eight vectors into memory, either by
+//          mapping the job's binary section file if it has one, or by
+//          reading the eight vector input files. In streaming mode the
+//          input files are only opened; their values are read as the
+//          output is written, and vectors that disagree on the number of
+//          points can only be warned about (ResampleVectors() reconciles
+//          them otherwise). A section file only ever holds a root and a
+//          tip, so it isn't looked for under other names (see loft.c). A
+//          section older than one of the vector files is passed over, with
+//          a warning (see IsSectionCurrent()).
+//
+int LoadVectorData(Job *job)
+{
+    double start = BeginStage(&job->stats);
+    char newer[MAX_PATH_LENGTH];
+    int result;
+
+    if (job->sideName[Root] == NULL && job->sideName[Tip] == NULL && HasSection(job))
+    {
+        if (IsSectionCurrent(job, newer))
+        {
+            result = LoadSection(job);
+            job->stats.bytesRead += job->sectionLength;
+            EndStage(&job->stats, StageOpen, start);
+            return(result);
+        }
+        ReportMessage(job, MESSAGE_WARNING, MESSAGE_SECTION_STALE, newer);
+    }
+
+    result = OpenDataFiles(job);
+    EndStage(&job->stats, StageOpen, start);
+    if (result == EXIT_SUCCESS)
+    {
+        if (job->settings->streaming)
+        {
+            start = BeginStage(&job->stats);
+            CheckVectorConsistency(job);
+            EndStage(&job->stats, StageCheck, start);
+            job->streaming = 1;
+            return(EXIT_SUCCESS);
+        }
+        start = BeginStage(&job->stats);
+        result = AllocateMemory(job);
+        EndStage(&job->stats, StageAllocate, start);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        start = BeginStage(&job->stats);
+        result = ReadVectorData(job);
+        EndStage(&job->stats, StageRead, start);
+    }
+
+    return(result);
+}
+
+
+// Function name: ReportMessage()
+// Purpose: Writes one error or warning message to stderr, or for a
+//          library job after the messages already in its buffer, as far as
+//          GCODE_MESSAGE_MAX allows.
+//          In batch mode the message is prefixed with the job's directory.
+//          The whole message is written with a single call so that messages
+//          from jobs running at the same time are not interleaved.
+//
+void ReportMessage(const Job *job, const char *severity, const char *format, ...)
+{
+    char message[GCODE_MESSAGE_MAX];
+    int length = 0;
+    size_t used;
+    va_list arguments;
+
+    if (job->directory != NULL)
+    {
+        length = snprintf(message, sizeof(message), "[%s] ", job->directory);
+    }
+    length += snprintf(message + length, sizeof(message) - length, "%s", severity);
+    va_start(arguments, format);
+    vsnprintf(message + length, sizeof(message) - length, format, arguments);
+    va_end(arguments);
+
+    if (job->message != NULL)
+    {
+        used = strlen(job->message);
+        snprintf(job->message + used, GCODE_MESSAGE_MAX - used, "%s", message);
+        return;
+    }
+    fputs(message, stderr);
+}
+
+
+// Function name: ReportParseError()
+// Purpose: Reports a value in one of the vector input files that isn't a
+//          number, with the line and column the parser stopped at.
+//
+void ReportParseError(Job *job, enum Side thisSide, enum Half thisHalf,
+                      enum Dimension thisDimension)
+{
+    const NumberReader *reader = &job->thisVector[thisSide][thisHalf][thisDimension].reader;
+    char filename[MAX_PATH_LENGTH];
+
+    job->stats.parseErrors++;
+    FindVectorFile(job, thisSide, thisHalf, thisDimension, filename);
+    ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_PARSEERROR, filename,
+                  reader->line, reader->column);
+}
+
+
+// Function name: BuildFilename()
+// Purpose: Places the full path of one of the job's files into "filename",
+//          which must hold at least MAX_PATH_LENGTH characters.
+//
+void BuildFilename(const Job *job, const char *name, char *filename)
+{
+    if (job->directory == NULL)
+    {
+        snprintf(filename, MAX_PATH_LENGTH, "%s", name);
+    }
+    else
+    {
+        snprintf(filename, MAX_PATH_LENGTH, "%s" PATH_SEPARATOR "%s", job->directory, name);
+    }
+}
+
+
+// Function name: BuildVectorFilename()
+// Purpose: Places the full path of one vector's input file (for example
+//          ROOTUPPERX, or KINKUPPERX for a loft station named KINK) into
+//          "filename", which must hold at least MAX_PATH_LENGTH characters.
+//
+void BuildVectorFilename(const Job *job, enum Side thisSide, enum Half thisHalf,
+                         enum Dimension thisDimension, char *filename)
+{
+    char name[MAX_PATH_LENGTH];
+
+    snprintf(name, sizeof(name), "%s%s%s",
+             (job->sideName[thisSide] != NULL) ? job->sideName[thisSide] :
+                                                 SideToString[thisSide],
+             HalfToString[thisHalf], DimensionToString[thisDimension]);
+    BuildFilename(job, name, filename);
+}
+
+
+// Function name: FindVectorFile()
+// Purpose: Like BuildVectorFilename(), but if there is no such file and
+//          there is a compressed one instead (for example ROOTUPPERX.gz),
+//          gives that one. Compressed files are also recognised by their
+//          contents, whatever they are called (see parse.c).
+//
+void FindVectorFile(const Job *job, enum Side thisSide, enum Half thisHalf,
+                    enum Dimension thisDimension, char *filename)
+{
+    enum Compression format;
+    struct stat status;
+    size_t length;
+
+    BuildVectorFilename(job, thisSide, thisHalf, thisDimension, filename);
+    if (stat(filename, &status) == 0)
+    {
+        return;
+    }
+    length = strlen(filename);
+    for (format = CompressionGzip; format < TOTAL_COMPRESSIONS; format++)
+    {
+        snprintf(filename + length, MAX_PATH_LENGTH - length, "%s", CompressionSuffix[format]);
+        if (stat(filename, &status) == 0)
+        {
+            return;
+        }
+    }
+    filename[length] = '\0';
+}
+
+
+// Function name: BuildOutputFilename()
+// Purpose: Places the full path of the job's output file into "filename"
+//          (MAX_PATH_LENGTH characters): OUTPUT.txt unless the job names
+//          another, with the suffix of its compression if it is compressed.
+//
+void BuildOutputFilename(const Job *job, char *filename)
+{
+    char name[MAX_PATH_LENGTH];
+
+    snprintf(name, sizeof(name), "%s%s",
+             (job->outputName != NULL) ? job->outputName : OUTPUT_FILENAME,
+             (job->settings != NULL) ? CompressionSuffix[job->settings->compression] : "");
+    BuildFilename(job, name, filename);
+}
+
+
+// Function name: IsVectorSkipped()
+// Purpose: Returns nonzero for the vectors of a half or side the job
+//          leaves unloaded.
+//
+static int IsVectorSkipped(const Job *job, enum Side thisSide, enum Half thisHalf)
+{
+    return(job->skipHalf[thisHalf] || job->skipSide[thisSide]);
+}
+
+
+// Function name: VectorOfTask()
+// Purpose: Finds the vector a pool task index stands for, counting in the
+//          order of the Side x Half x Dimension nest.
+//
+static void VectorOfTask(int index, enum Side *thisSide, enum Half *thisHalf,
+                         enum Dimension *thisDimension)
+{
+    *thisSide = (enum Side)(index / (TOTAL_HALVES * TOTAL_DIMENSIONS_PER_HALF));
+    *thisHalf = (enum Half)(index / TOTAL_DIMENSIONS_PER_HALF % TOTAL_HALVES);
+    *thisDimension = (enum Dimension)(index % TOTAL_DIMENSIONS_PER_HALF);
+}
+
+
+// Function name: ReportVectorOutcome()
+// Purpose: Reports what went wrong opening or reading one vector, if
+//          anything. Returns EXIT_FAILURE if the job can't go on; a file
+//          that ends early is only warned about.
+//
+static int ReportVectorOutcome(Job *job, enum Side thisSide, enum Half thisHalf,
+                               enum Dimension thisDimension)
+{
+    char filename[MAX_PATH_LENGTH];
+    enum Compression format;
+
+    FindVectorFile(job, thisSide, thisHalf, thisDimension, filename);
+    switch (job->thisVector[thisSide][thisHalf][thisDimension].outcome)
+    {
+        case VectorOpenFailed:
+            ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_OPENERROR, filename);
+            return(EXIT_FAILURE);
+        case VectorNoMemory:
+            ReportMessage(job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+            return(EXIT_FAILURE);
+        case VectorNoTotal:
+            ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_READERROR, filename);
+            return(EXIT_FAILURE);
+        case VectorEnded:
+            if (job->thisVector[thisSide][thisHalf][thisDimension].totalValues == 0)
+            {
+                ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_EMPTYERROR, filename);
+                return(EXIT_FAILURE);
+            }
+            ReportMessage(job, MESSAGE_WARNING, MESSAGE_VECTOR_EOF);
+            return(EXIT_SUCCESS);
+        case VectorNotNumber:
+            ReportParseError(job, thisSide, thisHalf, thisDimension);
+            return(EXIT_FAILURE);
+        case VectorDamaged:
+            ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_DAMAGEDERROR, filename);
+            return(EXIT_FAILURE);
+        case VectorUnsupported:
+            format = job->thisVector[thisSide][thisHalf][thisDimension].reader.compression;
+            ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_COMPRESSIONERROR, filename,
+                          CompressionName[format]);
+            return(EXIT_FAILURE);
+        default:
+            return(EXIT_SUCCESS);
+    }
+}
+
+
+// Function name: OpenVector()
+// Purpose: Opens one vector's input file and reads its first numerical
+//          value, which should be the total number of values to follow.
+//          How it went is left in the vector's outcome, so different
+//          vectors can be opened at the same time.
+//
+static void OpenVector(Job *job, enum Side thisSide, enum Half thisHalf,
+                       enum Dimension thisDimension)
+{
+    Vector *thisInput = &job->thisVector[thisSide][thisHalf][thisDimension];
+    char filename[MAX_PATH_LENGTH]; // This local variable is a scratchpad for
+                                    // constructing a dynamic filename
+    int result;
+
+    // Populate the scratchpad with a dynamically-generated input filename
+    FindVectorFile(job, thisSide, thisHalf, thisDimension, filename);
+    // Open the file
+    thisInput->inputFile = fopen(filename, READONLY);
+    // See if the file actually opened
+    if (thisInput->inputFile == NULL)
+    {
+        // If it didn't...
+        thisInput->outcome = VectorOpenFailed;
+        return;
+    }
+    // Get a block buffer to parse the file from
+    if (OpenNumberReader(&thisInput->reader, thisInput->inputFile,
+                         (job->arena != NULL) ?
+                           (char *)AllocateFromArena(job->arena, PARSE_BUFFER_SIZE) : NULL) !=
+        EXIT_SUCCESS)
+    {
+        thisInput->outcome = VectorNoMemory;
+        return;
+    }
+    // Read the first value of the file: The total number of point values
+    // for this vector
+    result = ReadInteger(&thisInput->reader, &thisInput->totalValues);
+    // See if the file could be decompressed, if it is compressed
+    if (thisInput->reader.damaged)
+    {
+        thisInput->outcome = IsCompressionAvailable(thisInput->reader.compression) ?
+                               VectorDamaged : VectorUnsupported;
+        return;
+    }
+    // See if the value a number greater than zero
+    thisInput->outcome = (result != PARSE_OK || thisInput->totalValues <= 0) ?
+                           VectorNoTotal : VectorLoaded;
+}
+
+
+// Function name: OpenVectorTask()
+// Purpose: Pool task that opens one of the eight vectors.
+//
+static void OpenVectorTask(void *context, int index)
+{
+    Job *job = (Job *)context;
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    VectorOfTask(index, &thisSide, &thisHalf, &thisDimension);
+    if (!IsVectorSkipped(job, thisSide, thisHalf))
+    {
+        OpenVector(job, thisSide, thisHalf, thisDimension);
+    }
+}
+
+
+// Function name: OpenDataFiles()
+// Purpose: Opens all input files requred by the program. This
+//          function also reads the first numerical value from the file, which
+//          should be the total number of values to follow. A job that may
+//          use several threads opens the eight files at the same time, so
+//          a slow file share costs the wait for one file rather than eight.
+//          Either way the first file that fails, in order, is reported.
+//
+int OpenDataFiles(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    // An arena gives out memory to one thread at a time
+    int concurrent = (job->threads > 1 && job->arena == NULL);
+
+    if (concurrent)
+    {
+        PoolRun(OpenVectorTask, job, TOTAL_VECTORS, TOTAL_VECTORS);
+    }
+
+    // Open all vector input files
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            if (IsVectorSkipped(job, thisSide, thisHalf))
+            {
+                continue;
+            }
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                if (!concurrent)
+                {
+                    OpenVector(job, thisSide, thisHalf, thisDimension);
+                }
+                if (job->thisVector[thisSide][thisHalf][thisDimension].reader.buffer != NULL)
+                {
+                    CountAllocation(&job->stats, PARSE_BUFFER_SIZE);
+                }
+                if (job->thisVector[thisSide][thisHalf][thisDimension].reader.decompressor != NULL)
+                {
+                    CountAllocation(&job->stats, DECOMPRESS_BUFFER_SIZE);
+                }
+                if (ReportVectorOutcome(job, thisSide, thisHalf, thisDimension) != EXIT_SUCCESS)
+                {
+                    return(EXIT_FAILURE);
+                }
+            }
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+        
+
+// Function name: CloseDataFiles()
+// Purpose: Closes all input and output files required by the program.
+//          Files that were never opened (or are already closed) are skipped.
+//
+void CloseDataFiles(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+        
+    // Close the output file
+    if (job->outputFile != NULL)
+    {
+        fclose(job->outputFile);
+        job->outputFile = NULL;
+    }
+        
+    // Iterate through all vectors...
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {        
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {                       
+                // Close the input file and release its block buffer
+                if (job->thisVector[thisSide][thisHalf][thisDimension].reader.buffer != NULL)
+                {
+                    CountAllocation(&job->stats, -PARSE_BUFFER_SIZE);
+                }
+                if (job->thisVector[thisSide][thisHalf][thisDimension].reader.decompressor != NULL)
+                {
+                    CountAllocation(&job->stats, -DECOMPRESS_BUFFER_SIZE);
+                }
+                CloseNumberReader(&job->thisVector[thisSide][thisHalf][thisDimension].reader);
+                if (job->thisVector[thisSide][thisHalf][thisDimension].inputFile != NULL)
+                {
+                    fclose(job->thisVector[thisSide][thisHalf][thisDimension].inputFile);
+                    job->thisVector[thisSide][thisHalf][thisDimension].inputFile = NULL;
+                }
+            }
+        }
+    }
+}
+
+
+// Function name: AllocateJobMemory()
+// Purpose: Gets memory for one of the job's buffers: from the job's arena
+//          if it has one, or from malloc(). Returns NULL if there is none.
+//
+void *AllocateJobMemory(Job *job, size_t size)
+{
+    if (job->arena != NULL)
+    {
+        return(AllocateFromArena(job->arena, size));
+    }
+
+    return(malloc(size));
+}
+
+
+// Function name: FreeJobMemory()
+// Purpose: Releases memory from AllocateJobMemory(). Arena memory is only
+//          taken back when the arena is reset, once the job is done.
+//
+void FreeJobMemory(Job *job, void *memory)
+{
+    if (job->arena == NULL)
+    {
+        free(memory);
+    }
+}
+
+
+// Function name: AllocateMemory()
+// Purpose: Requests RAM from the operating system. This memory is then used
+//          to store the all of the vector data points.
+//
+int AllocateMemory(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+        
+    // Iterate through all vectors...
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {        
+            if (IsVectorSkipped(job, thisSide, thisHalf))
+            {
+                continue;
+            }
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                // Allocate memory based on the total number of data values
+                job->thisVector[thisSide][thisHalf][thisDimension].value = 
+                  (float *)AllocateJobMemory(job,
+                  job->thisVector[thisSide][thisHalf][thisDimension].totalValues * sizeof(float));
+                // See if the memory allocation is successful
+                if (job->thisVector[thisSide][thisHalf][thisDimension].value == NULL)
+                {
+                    // If it's not...
+                    ReportMessage(job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+                    return(EXIT_FAILURE);
+                }
+                CountAllocation(&job->stats,
+                  (long long)job->thisVector[thisSide][thisHalf][thisDimension].totalValues *
+                  sizeof(float));
+            }
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: FreeMemory()
+// Purpose: Releases all allocated vector data point memory back to
+//          the operating system.
+//
+void FreeMemory(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        CountAllocation(&job->stats, -(long long)job->path[thisHalf].totalMoves * sizeof(Move));
+        FreePath(&job->path[thisHalf]);
+    }
+
+    // Values mapped from a section file were never allocated
+    if (job->section != NULL)
+    {
+        UnloadSection(job);
+        return;
+    }
+        
+    // Iterate through all vectors...
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {       
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                // Borrowed values belong to whoever lent them
+                if (job->borrowed)
+                {
+                    job->thisVector[thisSide][thisHalf][thisDimension].value = NULL;
+                    continue;
+                }
+                // Free allocated memory
+                if (job->thisVector[thisSide][thisHalf][thisDimension].value != NULL)
+                {
+                    CountAllocation(&job->stats,
+                      -(long long)job->thisVector[thisSide][thisHalf][thisDimension].totalValues *
+                      sizeof(float));
+                }
+                FreeJobMemory(job, job->thisVector[thisSide][thisHalf][thisDimension].value);
+                job->thisVector[thisSide][thisHalf][thisDimension].value = NULL;
+            }
+        }
+    }
+    job->borrowed = 0;
+}
+
+
+// Function name: DetachVectors()
+// Purpose: Gives the job its own copy of values it doesn't own (mapped
+//          from a section file, or lent by a library caller), for stages
+//          that change the values in place.
+//
+int DetachVectors(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    float *borrowed[TOTAL_SIDES][TOTAL_HALVES][TOTAL_DIMENSIONS_PER_HALF];
+    int result;
+
+    if (job->section == NULL && !job->borrowed)
+    {
+        return(EXIT_SUCCESS);
+    }
+
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                borrowed[thisSide][thisHalf][thisDimension] =
+                  job->thisVector[thisSide][thisHalf][thisDimension].value;
+                job->thisVector[thisSide][thisHalf][thisDimension].value = NULL;
+            }
+        }
+    }
+
+    result = AllocateMemory(job);
+    if (result == EXIT_SUCCESS)
+    {
+        for (thisSide = Root; thisSide <= Tip; thisSide++)
+        {
+            for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+            {
+                for (thisDimension = X; thisDimension <= Y; thisDimension++)
+                {
+                    // Skipped vectors weren't given memory (see AllocateMemory())
+                    if (IsVectorSkipped(job, thisSide, thisHalf))
+                    {
+                        continue;
+                    }
+                    memcpy(job->thisVector[thisSide][thisHalf][thisDimension].value,
+                           borrowed[thisSide][thisHalf][thisDimension],
+                           (size_t)job->thisVector[thisSide][thisHalf][thisDimension].totalValues *
+                           sizeof(float));
+                }
+            }
+        }
+    }
+
+    // Whatever happened, the vectors no longer point at borrowed values
+    UnmapSection(job);
+    job->borrowed = 0;
+
+    return(result);
+}
+
+
+// Function name: CheckVectorConsistency()
+// Purpose: Performs a quick check to see if all vectors advertise
+//          the same number of data points. Displays a warning if not.
+//
+void CheckVectorConsistency(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+        
+    int reference;
+    
+    // Select an arbitrary reference
+    reference = 
+     job->thisVector[thisSide = Tip][thisHalf = Lower][thisDimension = Y].totalValues;
+        
+    // Check every other vector against that reference
+    if (!((job->thisVector[thisSide = Root][thisHalf = Upper][thisDimension = X].totalValues == reference)
+     && (job->thisVector[thisSide = Root][thisHalf = Upper][thisDimension = Y].totalValues == reference)
+     && (job->thisVector[thisSide = Root][thisHalf = Lower][thisDimension = X].totalValues == reference)
+     && (job->thisVector[thisSide = Root][thisHalf = Lower][thisDimension = Y].totalValues == reference)
+     && (job->thisVector[thisSide = Tip][thisHalf = Upper][thisDimension = X].totalValues == reference)
+     && (job->thisVector[thisSide = Tip][thisHalf = Upper][thisDimension = Y].totalValues == reference)
+     && (job->thisVector[thisSide = Tip][thisHalf = Lower][thisDimension = X].totalValues == reference)))
+    {
+        // If they aren't consistent...
+        ReportMessage(job, MESSAGE_WARNING, MESSAGE_VECTOR_CONSISTENCY);
+    }
+}
+
+
+// Function name: ReadVector()
+// Purpose: Reads all of one vector's data points from its file and into
+//          allocated memory, leaving how it went in the vector's outcome.
+//          Values are kept as read; OutputGCode() applies the coordinate
+//          scalar.
+//
+static void ReadVector(Job *job, enum Side thisSide, enum Half thisHalf,
+                       enum Dimension thisDimension)
+{
+    Vector *thisInput = &job->thisVector[thisSide][thisHalf][thisDimension];
+    int thisValue;
+    int result;
+
+    // Read all data values into allocated memory
+    for (thisValue = 0; thisValue < thisInput->totalValues; thisValue++)
+    {
+        // Read the value from the proper input file. The success or failure
+        // of the read operation is stored in the "result" variable.
+        result = ReadFloat(&thisInput->reader, &thisInput->value[thisValue]);
+        // See if a compressed file turned out to be damaged or cut short
+        if (result != PARSE_OK && thisInput->reader.damaged)
+        {
+            thisInput->outcome = VectorDamaged;
+            return;
+        }
+        // See if End-of-File was reached unexpectedly
+        if (result == PARSE_EOF)
+        {
+            // If it was, just abort reading this vector; don't fail the
+            // job. Only the values that were read are kept, so resampling,
+            // writing and packing never take the missing ones for points.
+            thisInput->outcome = VectorEnded;
+            thisInput->totalValues = thisValue;
+            return;
+        }
+        // See if the value wasn't a number
+        if (result == PARSE_BAD)
+        {
+            thisInput->outcome = VectorNotNumber;
+            return;
+        }
+    }
+    // The last value may have been cut short along with the file
+    thisInput->outcome = thisInput->reader.damaged ? VectorDamaged : VectorLoaded;
+}
+
+
+// Function name: ReadVectorTask()
+// Purpose: Pool task that reads one of the eight vectors.
+//
+static void ReadVectorTask(void *context, int index)
+{
+    Job *job = (Job *)context;
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    VectorOfTask(index, &thisSide, &thisHalf, &thisDimension);
+    if (!IsVectorSkipped(job, thisSide, thisHalf))
+    {
+        ReadVector(job, thisSide, thisHalf, thisDimension);
+    }
+}
+
+
+// Function name: ReadVectorData()
+// Purpose: Reads all vector data points from their files and
+//          into allocated memory, all eight at the same time if the job
+//          may use several threads. A value that isn't a number is reported
+//          with its line and column, and fails the job; messages come out
+//          in the same order either way.
+//
+int ReadVectorData(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    int concurrent = (job->threads > 1);
+
+    if (concurrent)
+    {
+        PoolRun(ReadVectorTask, job, TOTAL_VECTORS, TOTAL_VECTORS);
+    }
+
+    // Iterate through all vectors...
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {  
+            if (IsVectorSkipped(job, thisSide, thisHalf))
+            {
+                continue;
+            }
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {                       
+                if (!concurrent)
+                {
+                    ReadVector(job, thisSide, thisHalf, thisDimension);
+                }
+                if (ReportVectorOutcome(job, thisSide, thisHalf, thisDimension) != EXIT_SUCCESS)
+                {
+                    return(EXIT_FAILURE);
+                }
+            }
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ResampleVectors()
+// Purpose: Resamples the root and tip of each half to a common number of
+//          points (see resample.c): every half if the settings give a
+//          count, and otherwise only halves whose four vectors disagree,
+//          which are resampled to the largest of their counts. The leading
+//          edge is taken to be the end of the half with the smaller root X.
+//
+int ResampleVectors(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    Vector *thisX;
+    Vector *thisY;
+    int totalPoints[TOTAL_SIDES];
+    int totalSamples;
+    int consistent;
+    double *fraction;
+    float *sampleX;
+    float *sampleY;
+    int result;
+
+    if (job->streaming)
+    {
+        return(EXIT_SUCCESS);
+    }
+
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        if (job->skipHalf[thisHalf])
+        {
+            continue;
+        }
+
+        // Only whole points can be used if X and Y disagree
+        consistent = 1;
+        totalSamples = 0;
+        for (thisSide = Root; thisSide <= Tip; thisSide++)
+        {
+            thisX = &job->thisVector[thisSide][thisHalf][X];
+            thisY = &job->thisVector[thisSide][thisHalf][Y];
+            totalPoints[thisSide] = (thisX->totalValues < thisY->totalValues) ?
+                                      thisX->totalValues : thisY->totalValues;
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                if (job->thisVector[thisSide][thisHalf][thisDimension].totalValues !=
+                    job->thisVector[Root][thisHalf][X].totalValues)
+                {
+                    consistent = 0;
+                }
+                if (job->thisVector[thisSide][thisHalf][thisDimension].totalValues > totalSamples)
+                {
+                    totalSamples = job->thisVector[thisSide][thisHalf][thisDimension].totalValues;
+                }
+            }
+        }
+        if (job->settings->resampleTotal > 0)
+        {
+            totalSamples = job->settings->resampleTotal;
+        }
+        else if (consistent)
+        {
+            continue;
+        }
+        else
+        {
+            ReportMessage(job, MESSAGE_NOTE, MESSAGE_VECTOR_RESAMPLED,
+                          HalfToString[thisHalf], totalSamples);
+        }
+
+        // Borrowed values can't be replaced, so take a copy first
+        result = DetachVectors(job);
+        if (result != EXIT_SUCCESS)
+        {
+            return(result);
+        }
+
+        // Where along the curve each sample goes, the same for both sides
+        fraction = (double *)AllocateJobMemory(job, totalSamples * sizeof(double));
+        if (fraction == NULL)
+        {
+            ReportMessage(job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+            return(EXIT_FAILURE);
+        }
+        CountAllocation(&job->stats, (long long)totalSamples * sizeof(double));
+        thisX = &job->thisVector[Root][thisHalf][X];
+        SampleFractions(fraction, totalSamples, job->settings->clustering,
+                        thisX->value[0] <= thisX->value[totalPoints[Root] - 1]);
+
+        for (thisSide = Root; thisSide <= Tip; thisSide++)
+        {
+            thisX = &job->thisVector[thisSide][thisHalf][X];
+            thisY = &job->thisVector[thisSide][thisHalf][Y];
+            sampleX = (float *)AllocateJobMemory(job, totalSamples * sizeof(float));
+            sampleY = (float *)AllocateJobMemory(job, totalSamples * sizeof(float));
+            if (sampleX == NULL || sampleY == NULL)
+            {
+                FreeJobMemory(job, sampleX);
+                FreeJobMemory(job, sampleY);
+                FreeJobMemory(job, fraction);
+                ReportMessage(job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+                return(EXIT_FAILURE);
+            }
+
+            CountAllocation(&job->stats, 2LL * totalSamples * sizeof(float));
+            ResampleCurve(thisX->value, thisY->value, totalPoints[thisSide],
+                          fraction, totalSamples, sampleX, sampleY);
+
+            CountAllocation(&job->stats, -((long long)thisX->totalValues +
+                                           thisY->totalValues) * sizeof(float));
+            FreeJobMemory(job, thisX->value);
+            FreeJobMemory(job, thisY->value);
+            thisX->value = sampleX;
+            thisY->value = sampleY;
+            thisX->totalValues = totalSamples;
+            thisY->totalValues = totalSamples;
+        }
+
+        FreeJobMemory(job, fraction);
+        CountAllocation(&job->stats, -(long long)totalSamples * sizeof(double));
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ApplyTransforms()
+// Purpose: Places each side of the wing as the settings ask (see
+//          transform.c), by transforming whole X/Y arrays in place. Sides
+//          without a placement are left alone. In streaming mode the
+//          transform is kept for StreamHalf() to apply point by point.
+//
+int ApplyTransforms(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+
+    Vector *thisX;
+    Vector *thisY;
+    int result;
+
+    // Work out which sides need transforming
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        job->transformed[thisSide] =
+          !IsIdentityTransform(&job->settings->transform[thisSide]);
+        ComposeTransform(&job->settings->transform[thisSide], &job->transform[thisSide]);
+    }
+    if ((!job->transformed[Root] && !job->transformed[Tip]) || job->streaming)
+    {
+        return(EXIT_SUCCESS);
+    }
+
+    // Borrowed values can't be changed, so take a copy first
+    result = DetachVectors(job);
+    if (result != EXIT_SUCCESS)
+    {
+        return(result);
+    }
+
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        if (!job->transformed[thisSide])
+        {
+            continue;
+        }
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            if (IsVectorSkipped(job, thisSide, thisHalf))
+            {
+                continue;
+            }
+            // Only whole points can be transformed if X and Y disagree
+            thisX = &job->thisVector[thisSide][thisHalf][X];
+            thisY = &job->thisVector[thisSide][thisHalf][Y];
+            TransformArrays(&job->transform[thisSide], thisX->value, thisY->value,
+                            (thisX->totalValues < thisY->totalValues) ?
+                              thisX->totalValues : thisY->totalValues);
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ReduceToolPaths()
+// Purpose: Replaces the point-by-point tool path of each airfoil half with
+//          fewer, longer moves if the settings ask for it (see reduce.c),
+//          and reports how much each half was reduced. Only points that all
+//          four vectors have are used.
+//
+int ReduceToolPaths(Job *job)
+{
+    enum Half thisHalf;
+
+    const float *point[4];
+    int totalPoints;
+    int thisAxis;
+    ToolPath *thisPath;
+
+    if (!job->settings->reducing)
+    {
+        return(EXIT_SUCCESS);
+    }
+
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        if (job->skipHalf[thisHalf])
+        {
+            continue;
+        }
+
+        // Root X, root Y, tip X, tip Y: the order of a line's coordinates
+        point[0] = job->thisVector[Root][thisHalf][X].value;
+        point[1] = job->thisVector[Root][thisHalf][Y].value;
+        point[2] = job->thisVector[Tip][thisHalf][X].value;
+        point[3] = job->thisVector[Tip][thisHalf][Y].value;
+        totalPoints = job->thisVector[Tip][thisHalf][X].totalValues;
+        for (thisAxis = 0; thisAxis < 4; thisAxis++)
+        {
+            if (job->thisVector[thisAxis / 2][thisHalf][thisAxis % 2].totalValues < totalPoints)
+            {
+                totalPoints = job->thisVector[thisAxis / 2][thisHalf][thisAxis % 2].totalValues;
+            }
+        }
+
+        // The tolerance is in output units; the values aren't scaled yet.
+        // ReducePath() needs a status byte and a candidate per point.
+        thisPath = &job->path[thisHalf];
+        CountAllocation(&job->stats, (long long)totalPoints * (1 + sizeof(int)));
+        if (ReducePath(point, totalPoints, job->settings->tolerance / job->settings->dialect.scale,
+                       job->settings->fitArcs, thisPath) != EXIT_SUCCESS)
+        {
+            ReportMessage(job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+            return(EXIT_FAILURE);
+        }
+        CountAllocation(&job->stats, (long long)thisPath->totalMoves * sizeof(Move));
+        CountAllocation(&job->stats, -(long long)totalPoints * (1 + sizeof(int)));
+        ReportMessage(job, "", MESSAGE_REDUCE_SUMMARY, HalfToString[thisHalf],
+                      thisPath->totalPoints, thisPath->totalMoves, thisPath->totalArcs,
+                      thisPath->maxDeviation * job->settings->dialect.scale);
+    }
+    job->reduced = 1;
+
+    return(EXIT_SUCCESS);
+}
+
+
+// A large half being formatted by several threads: the lines of one round
+// of chunks (see OutputHalfInParallel())
+typedef struct
+{
+    Job *job;
+    enum Half half;
+    int firstLine;          // Line the round starts at
+    int endLine;            // One past the last line of the half
+    OutputBuffer *chunk;    // Buffers the chunks are formatted into
+    char *storage;          // OUTPUT_BUFFER_SIZE bytes for each chunk
+} Emission;
+
+
+// Function name: OutputLine()
+// Purpose: Writes one line of an airfoil half: the move to one data point,
+//          or for a reduced half one move of its tool path. Every value is
+//          scaled by the profile's coordinate scale on its way out.
+//
+static void OutputLine(Job *job, OutputBuffer *output, enum Half thisHalf, int thisLine)
+{
+    const float *rootX = job->thisVector[Root][thisHalf][X].value;
+    const float *rootY = job->thisVector[Root][thisHalf][Y].value;
+    const float *tipX = job->thisVector[Tip][thisHalf][X].value;
+    const float *tipY = job->thisVector[Tip][thisHalf][Y].value;
+    double scale = job->settings->dialect.scale;
+    const Move *thisMove;
+    int thisIndex = thisLine;
+
+    // A reduced half is written a move at a time
+    if (job->reduced)
+    {
+        thisMove = &job->path[thisHalf].move[thisLine];
+        thisIndex = thisMove->index;
+        if (thisMove->type != LineMove)
+        {
+            PlanArc(&job->planner, output, thisMove->type == ClockwiseArc,
+                    SCALE_COORDINATE(rootX[thisIndex], scale),
+                    SCALE_COORDINATE(rootY[thisIndex], scale),
+                    SCALE_COORDINATE(tipX[thisIndex], scale),
+                    SCALE_COORDINATE(tipY[thisIndex], scale),
+                    SCALE_COORDINATE(thisMove->centerI, scale),
+                    SCALE_COORDINATE(thisMove->centerJ, scale));
+            return;
+        }
+    }
+
+    PlanPoint(&job->planner, output,
+              SCALE_COORDINATE(rootX[thisIndex], scale),
+              SCALE_COORDINATE(rootY[thisIndex], scale),
+              SCALE_COORDINATE(tipX[thisIndex], scale),
+              SCALE_COORDINATE(tipY[thisIndex], scale));
+}
+
+
+// Function name: FormatChunk()
+// Purpose: Pool task that formats one chunk of a round into its own buffer.
+//          Without a maximum wire speed the planner is only read, so any
+//          number of chunks can be formatted at once.
+//
+static void FormatChunk(void *context, int index)
+{
+    Emission *emission = (Emission *)context;
+    OutputBuffer *chunk = &emission->chunk[index];
+    int thisLine = emission->firstLine + index * EMIT_CHUNK_LINES;
+    int endLine = thisLine + EMIT_CHUNK_LINES;
+
+    if (endLine > emission->endLine)
+    {
+        endLine = emission->endLine;
+    }
+
+    // EMIT_CHUNK_LINES lines always fit, so the buffer is never flushed
+    OpenOutputSink(chunk, NULL, NULL, &emission->job->settings->dialect,
+                   emission->storage + (size_t)index * OUTPUT_BUFFER_SIZE);
+
+    // A compact line leaves out what the line before it wrote, so that line
+    // is formatted first, and thrown away, to leave the same modal state
+    if (thisLine > 0 && emission->job->settings->dialect.compactDecimals >= 0)
+    {
+        OutputLine(emission->job, chunk, emission->half, thisLine - 1);
+        chunk->length = 0;
+        chunk->totalLines = 0;
+        chunk->verboseBytes = 0;
+    }
+
+    for (; thisLine < endLine; thisLine++)
+    {
+        OutputLine(emission->job, chunk, emission->half, thisLine);
+    }
+}
+
+
+// Function name: OutputHalfInParallel()
+// Purpose: Writes the lines of a large airfoil half with several threads.
+//          The half is cut into chunks of EMIT_CHUNK_LINES lines, a round
+//          of chunks is formatted at once, each into its own buffer, and
+//          the round is then written in order, so the output is the same
+//          as OutputHalf() writes on its own.
+//
+static int OutputHalfInParallel(Job *job, OutputBuffer *output, enum Half thisHalf,
+                                int totalLines)
+{
+    Emission emission;
+    int totalChunks = (totalLines + EMIT_CHUNK_LINES - 1) / EMIT_CHUNK_LINES;
+    int totalBuffers = job->threads * EMIT_CHUNKS_PER_THREAD;
+    int roundChunks;
+    int thisChunk;
+
+    if (totalBuffers > totalChunks)
+    {
+        totalBuffers = totalChunks;
+    }
+    emission.job = job;
+    emission.half = thisHalf;
+    emission.endLine = totalLines;
+    emission.chunk = (OutputBuffer *)AllocateJobMemory(job, totalBuffers * sizeof(OutputBuffer));
+    emission.storage = (char *)AllocateJobMemory(job, (size_t)totalBuffers * OUTPUT_BUFFER_SIZE);
+    if (emission.chunk == NULL || emission.storage == NULL)
+    {
+        FreeJobMemory(job, emission.chunk);
+        FreeJobMemory(job, emission.storage);
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+        return(EXIT_FAILURE);
+    }
+    CountAllocation(&job->stats, (long long)totalBuffers * OUTPUT_BUFFER_SIZE);
+
+    // One round of chunks per buffer
+    for (thisChunk = 0; thisChunk < totalChunks; thisChunk += roundChunks)
+    {
+        roundChunks = (totalChunks - thisChunk < totalBuffers) ?
+                        totalChunks - thisChunk : totalBuffers;
+        emission.firstLine = thisChunk * EMIT_CHUNK_LINES;
+        PoolRun(FormatChunk, &emission, roundChunks, job->threads);
+        EmitChunks(output, emission.chunk, roundChunks);
+    }
+
+    CountAllocation(&job->stats, -(long long)totalBuffers * OUTPUT_BUFFER_SIZE);
+    FreeJobMemory(job, emission.chunk);
+    FreeJobMemory(job, emission.storage);
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: OutputHalf()
+// Purpose: Writes one line of coordinates for every data point of one
+//          airfoil half, using TIP<half>X as the reference for the total
+//          number of data points, or one line for every move of its
+//          reduced tool path.
+//
+static int OutputHalf(Job *job, OutputBuffer *output, enum Half thisHalf)
+{
+    int totalLines = job->thisVector[Tip][thisHalf][X].totalValues;
+    int thisLine;
+
+    // In streaming mode the values are still in the input files
+    if (job->streaming)
+    {
+        return(StreamHalf(job, output, thisHalf));
+    }
+
+    if (job->reduced)
+    {
+        totalLines = job->path[thisHalf].totalMoves;
+    }
+
+    // Every line depends on its data point alone unless feeds are planned
+    if (job->threads > 1 && job->planner.maxSpeed <= 0.0 &&
+        totalLines >= EMIT_PARALLEL_LINES)
+    {
+        return(OutputHalfInParallel(job, output, thisHalf, totalLines));
+    }
+
+    for (thisLine = 0; thisLine < totalLines; thisLine++)
+    {
+        OutputLine(job, output, thisHalf, thisLine);
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: EmitHalf()
+// Purpose: Writes one airfoil half with its feeds planned, exactly as it
+//          appears in the whole output file. The upper half starts a new
+//          planner; the lower half carries on from the upper one, or from
+//          where the upper one would have left it if it is written on its
+//          own (see watch.c).
+//
+int EmitHalf(Job *job, OutputBuffer *output, enum Half thisHalf)
+{
+    int result;
+
+    if (thisHalf == Upper || job->planner.dialect == NULL)
+    {
+        InitializeFeedPlanner(&job->planner, job->settings->maxWireSpeed,
+                              &job->settings->dialect);
+    }
+    if (thisHalf == Lower)
+    {
+        ResumeFeedPlanner(&job->planner);
+    }
+
+    result = OutputHalf(job, output, thisHalf);
+    EndPlannedHalf(&job->planner, output);
+
+    return(result);
+}
+
+
+// Function name: EmitGCode()
+// Purpose: Produces valid GCode from the raw data points: the profile's
+//          header, both halves with the transition between them, and the
+//          footer, into an output buffer that has just been opened.
+//
+int EmitGCode(Job *job, OutputBuffer *output)
+{
+    const Dialect *dialect = &job->settings->dialect;
+    int result;
+
+    job->stats.points[Upper] = job->thisVector[Tip][Upper][X].totalValues;
+    job->stats.points[Lower] = job->thisVector[Tip][Lower][X].totalValues;
+
+    // Output the GCode header ////////////////////////////////////////////////
+    EmitText(output, dialect->block[Header], dialect->blockLength[Header]);
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Output the Upper airfoil half //////////////////////////////////////////
+    result = EmitHalf(job, output, Upper);
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Output the transition between the Upper and Lower halves ///////////////
+    if (result == EXIT_SUCCESS)
+    {
+        EmitText(output, dialect->block[Transition], dialect->blockLength[Transition]);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Output the Lower airfoil half //////////////////////////////////////////
+    if (result == EXIT_SUCCESS)
+    {
+        result = EmitHalf(job, output, Lower);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Output the GCode footer ////////////////////////////////////////////////
+    if (result == EXIT_SUCCESS)
+    {
+        EmitText(output, dialect->block[Footer], dialect->blockLength[Footer]);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    return(result);
+}
+
+
+// Function name: BuildTemporaryFilename()
+// Purpose: Names the file an output file is written as until it is
+//          complete, beside it so it can be renamed into place.
+//
+static void BuildTemporaryFilename(const char *filename, char *temporary)
+{
+    snprintf(temporary, MAX_PATH_LENGTH, "%.*s.%ld" OUTPUT_TEMP_SUFFIX,
+             MAX_PATH_LENGTH - 32, filename, (long)getpid());
+}
+
+
+// Function name: OutputGCode()
+// Purpose: Writes the job's GCode (see EmitGCode()) to its output file.
+//          Text is collected in a large buffer and written a block at a
+//          time (see emit.c), through a compressor if the output is
+//          compressed (see compress.c). It goes to a temporary file that
+//          is renamed over the output file once it is complete, so a job
+//          that fails part way (a streamed one, say) leaves the last good
+//          output in place.
+//
+int OutputGCode(Job *job)
+{
+    const Dialect *dialect = &job->settings->dialect;
+    enum Compression compression = job->settings->compression;
+    OutputBuffer output;
+    Compressor compressor;
+    int result;
+    int closed;
+
+    char filename[MAX_PATH_LENGTH];
+    char temporary[MAX_PATH_LENGTH];
+
+
+    // Open the output file. An old one is replaced rather than rewritten,
+    // since it may be a hard link to an entry of the output cache.
+    BuildOutputFilename(job, filename);
+    BuildTemporaryFilename(filename, temporary);
+    job->outputFile = fopen(temporary, (compression != CompressionNone) ? WRITEBINARY : WRITEONLY);
+    // See if the file actually opened
+    if (job->outputFile == NULL)
+    {
+        // If it didn't...
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_WRITEERROR, temporary);
+        return(EXIT_FAILURE);
+    }
+
+    if (compression != CompressionNone)
+    {
+        if (OpenCompressor(&compressor, job->outputFile, compression,
+                           job->settings->compressionLevel) != EXIT_SUCCESS)
+        {
+            fclose(job->outputFile);
+            job->outputFile = NULL;
+            unlink(temporary);
+            ReportMessage(job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+            return(EXIT_FAILURE);
+        }
+        result = OpenOutputSink(&output, CompressText, &compressor, dialect, NULL);
+        CountAllocation(&job->stats, COMPRESS_BUFFER_SIZE);
+    }
+    else
+    {
+        result = OpenOutputBuffer(&output, job->outputFile, dialect);
+    }
+    if (result != EXIT_SUCCESS)
+    {
+        if (compression != CompressionNone)
+        {
+            CloseCompressor(&compressor);
+        }
+        fclose(job->outputFile);
+        job->outputFile = NULL;
+        unlink(temporary);
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+        return(EXIT_FAILURE);
+    }
+    CountAllocation(&job->stats, OUTPUT_BUFFER_SIZE);
+
+    result = EmitGCode(job, &output);
+
+    // Write out the rest, and count what was written
+    closed = CloseOutputBuffer(&output);
+    if (compression != CompressionNone)
+    {
+        if (CloseCompressor(&compressor) != EXIT_SUCCESS)
+        {
+            closed = EXIT_FAILURE;
+        }
+        CountAllocation(&job->stats, -COMPRESS_BUFFER_SIZE);
+    }
+    if (fclose(job->outputFile) != 0)
+    {
+        closed = EXIT_FAILURE;
+    }
+    job->outputFile = NULL;
+    // Count what reached the disk
+    job->stats.bytesWritten += (compression != CompressionNone) ? compressor.totalWritten :
+                                                                   output.totalWritten;
+    job->stats.linesWritten += output.totalLines;
+    CountAllocation(&job->stats, -OUTPUT_BUFFER_SIZE);
+
+    // A streamed half can fail part way through; that's already reported
+    if (result != EXIT_SUCCESS)
+    {
+        unlink(temporary);
+        return(EXIT_FAILURE);
+    }
+       
+    // See if any write to the output file failed
+    if (closed != EXIT_SUCCESS || rename(temporary, filename) != 0)
+    {
+        // If it did...
+        unlink(temporary);
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_WRITEERROR, filename);
+        return(EXIT_FAILURE);
+    }
+
+    if (job->planner.maxSpeed > 0.0)
+    {
+        ReportMessage(job, "", MESSAGE_FEED_SUMMARY, job->planner.constantTime,
+                      dialect->feedWord, job->planner.plannedTime);
+    }
+    if (dialect->compactDecimals >= 0 && output.verboseBytes > 0)
+    {
+        ReportMessage(job, "", MESSAGE_COMPACT_SUMMARY, output.totalWritten,
+                      output.verboseBytes,
+                      100.0 * (1.0 - (double)output.totalWritten / output.verboseBytes));
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: CompressPieces()
+// Purpose: Writes the pieces of an output file through a compressor, and
+//          closes the file. Returns EXIT_FAILURE if anything failed.
+//
+static int CompressPieces(int file, const struct iovec *piece, int totalPieces,
+                          const Settings *settings)
+{
+    Compressor compressor;
+    FILE *stream;
+    int result;
+    int thisPiece;
+
+    stream = fdopen(file, WRITEBINARY);
+    if (stream == NULL)
+    {
+        close(file);
+        return(EXIT_FAILURE);
+    }
+    result = OpenCompressor(&compressor, stream, settings->compression,
+                            settings->compressionLevel);
+    for (thisPiece = 0; thisPiece < totalPieces && result == EXIT_SUCCESS; thisPiece++)
+    {
+        result = CompressText(&compressor, (const char *)piece[thisPiece].iov_base,
+                              piece[thisPiece].iov_len);
+    }
+    if (CloseCompressor(&compressor) != EXIT_SUCCESS)
+    {
+        result = EXIT_FAILURE;
+    }
+    if (fclose(stream) != 0)
+    {
+        result = EXIT_FAILURE;
+    }
+
+    return(result);
+}
+
+
+// Function name: WriteOutputPieces()
+// Purpose: Writes an output file already rendered in pieces (blocks of the
+//          profile and halves kept in memory) with writev(), compressed if
+//          the settings ask, under a temporary name that is then renamed
+//          over the job's output file. A program watching the output never
+//          sees it part way written. The pieces are used up on the way.
+//
+int WriteOutputPieces(const Job *job, struct iovec *piece, int totalPieces)
+{
+    char filename[MAX_PATH_LENGTH];
+    char temporary[MAX_PATH_LENGTH];
+    int file;
+    int result;
+    int closed;
+
+    BuildOutputFilename(job, filename);
+    BuildTemporaryFilename(filename, temporary);
+    file = open(temporary, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (file < 0)
+    {
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_WRITEERROR, temporary);
+        return(EXIT_FAILURE);
+    }
+
+    if (job->settings->compression != CompressionNone)
+    {
+        result = CompressPieces(file, piece, totalPieces, job->settings);
+        closed = 0;
+    }
+    else
+    {
+        result = WriteWholly(file, piece, totalPieces);
+        closed = close(file);
+    }
+    if (closed != 0 || result != EXIT_SUCCESS || rename(temporary, filename) != 0)
+    {
+        unlink(temporary);
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_WRITEERROR, filename);
+        return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// --- End of gcode.c
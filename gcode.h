@@ -1,137 +1,350 @@
-// gcode.h
-//
-// This is the primary header (.h) file for the GCode project (gcode.c)
-// 
-// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
-//
-// This program is free software; you can redistribute it and/or
-// modify it under the terms of the GNU General Public License
-// as published by the Free Software Foundation; either version 2
-// of the License, or (at your option) any later version.
-//
-// This program is distributed in the hope that it will be useful,
-// but WITHOUT ANY WARRANTY; without even the implied warranty of
-// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
-// GNU General Public License for more details.
-//
-// You should have received a copy of the GNU General Public License
-// along with this program; if not, write to the Free Software
-// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, 
-// USA.
-//
-// See LICENSE for the full license text, or view it here:
-// http://www.gnu.org/licenses/gpl-2.0.html
-//
-//
-// (See gcode.c for project revision history)
-//
-
-
-#ifndef GCODE_H         // Don't define everything more than once
-#define GCODE_H         //
-
-#include <stdio.h>
-#include <string.h>
-
-
-// Program data constants (you may modify these)
-// ----------------------------------------------------------------------------
-#define OUTPUT_FILENAME "OUTPUT.txt"
-
-// These are full fprintf() string and parameter defines. The intention is
-// to use them with a "fprintf(outputFile, GCODE_HEADER);" style of line.
-#define GCODE_HEADER "(Initialize)\nG20\nG90\n\n(Wire reset)\nG0 X%f U%f\nG0 Y%f V%f\n\n(Knock slew)\nG0 X%f U%f\nG0 Y%f V%f\nG0 X%f U%f\nG0 Y%f V%f\n\n(Begin airfoil upper half)\n", Y_MIN, X_MIN, Y_MIN, X_MIN, X_MAX, X_MAX, Y_MAX, Y_MAX, X_MIN, X_MIN, Y_MIN, Y_MIN
-#define GCODE_FOOTER "(End airfoil lower half)\n\n(Wire reset)\n%s X%f U%f\nG0 Y%f V%f\nG0 X%f U%f\nG0 Y%f V%f\n\n(Stop)\nM30", GCODE_MOVE_COMMAND, X_MAX, X_MAX, Y_MAX, Y_MAX, X_MIN, X_MIN, Y_MIN, Y_MIN
-#define GCODE_UPPERLOWER_TRANSITION "(End airfoil upper half)\n\n(Wire reset)\n%s X%f U%f\nG0 Y%f V%f\nG0 X%f U%f\nG0 Y%f V%f\n\n(Begin airfoil lower half)\n", GCODE_MOVE_COMMAND, X_MAX, X_MAX, Y_MAX, Y_MAX, X_MIN, X_MIN, Y_MIN, Y_MIN
-
-// These are string-only defines that are used as parameters to an "%s" in the
-// fprintf() call that outputs each data point line to the output file.
-// They are not full fprintf() strings and parameter defines. Each data point
-// in the entire airfoil will use this move command and this feedrate.
-#define GCODE_MOVE_COMMAND "G1"
-#define GCODE_FEEDRATE "F0.60"
-
-// Cutter min/max dimension values (in units specified in GCode header)
-// Note: These also apply to U and V axes in the output file
-#define X_MIN -12.0
-#define Y_MIN -12.0 
-#define X_MAX 12.0
-#define Y_MAX 12.0
-
-// All data points read from the input files will be scaled by this number
-#define XYUV_COORDINATE_SCALAR 5.0
-// ----------------------------------------------------------------------------
-
-
-// Program data constants (do not modify these)
-#define TOTAL_SIDES 2               // Sides per wing (Root, Tip)
-#define TOTAL_HALVES 2              // Halves per side (Upper, Lower)
-#define TOTAL_DIMENSIONS_PER_HALF 2 // Dimensions per half (X, Y)
-
-#define READONLY "r"                // File access constants
-#define WRITEONLY "w"               //
-
-// Fatal error messages
-#define MESSAGE_ERROR "* Oops -- Can't "
-#define MESSAGE_FILE_OPENERROR "open %s. Are all vector files present?\n"
-#define MESSAGE_FILE_READERROR "read %s. The first line should be the 'Total Values'.\n"
-#define MESSAGE_FILE_WRITEERROR "write to %s. Is the file in-use or the disk full?\n"
-#define MESSAGE_MEMORY_ALLOCERROR "allocate memory for that many data points!\n"
-
-// Non-fatal error messages
-#define MESSAGE_WARNING "* Note: You should "
-#define MESSAGE_VECTOR_CONSISTENCY "ensure all vector files list the same number of data points\n"
-#define MESSAGE_VECTOR_EOF "check all vector files for the listed number of data points\n"
-
-
-// Function prototypes
-void OpenDataFiles();
-void CloseDataFiles();
-void AllocateMemory();
-void FreeMemory();
-void CheckVectorConsistency();
-void ReadVectorData();
-void OutputGCode();
-
-
-// Enum values for each airfoil side
-enum Side
-{
-    Root,
-    Tip
-};
-char *SideToString[] = { "ROOT", "TIP" };
-
-// Enum values for each airfoil half
-enum Half
-{
-    Upper,
-    Lower
-};
-char *HalfToString[] = { "UPPER", "LOWER" };
-
-// Enum values for each airfoil axis. Note that U and V axes are
-// represented here by a second Side of X and Y coordinates.
-enum Dimension 
-{
-    X,
-    Y
-};
-char *DimensionToString[] = { "X", "Y" };
-
-
-// Each internal vector instance has these properties associated with it
-typedef struct
-{
-    FILE *inputFile;        // File handle to the input file
-    int totalValues;        // Total data point values
-    float *value;           // Data point values
-} Vector;
-
-
-// File handle to the output file
-FILE *outputFile;
-
-
-#endif
-// --- End of gcode.h
+// gcode.h
+//
+// This is the primary header (.h) file for the GCode project (gcode.c)
+// 
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, 
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// (See gcode.c for project revision history)
+//
+
+
+#ifndef GCODE_H         // Don't define everything more than once
+#define GCODE_H         //
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/uio.h>
+
+#include "arena.h"
+#include "compress.h"
+#include "parse.h"
+#include "transform.h"
+#include "reduce.h"
+#include "feed.h"
+#include "dialect.h"
+#include "stats.h"
+
+
+// Program data constants (you may modify these)
+// ----------------------------------------------------------------------------
+#define OUTPUT_FILENAME "OUTPUT.txt"
+#define OUTPUT_TEMP_SUFFIX ".tmp"       // An output file, until it is complete
+#define SECTION_FILENAME "SECTION.gcs"  // Used instead of the eight input
+                                        // files if present (see section.c)
+
+// The header and footer text, the move commands and feedrate, the cutter
+// limits, the axis letters and the coordinate scalar all come from a
+// machine profile given with "--profile" now. The profile of the machine
+// this program was written for is built in (see DefaultProfile in
+// dialect.c).
+
+// Coordinates are multiplied by the profile's scalar as they are written
+#define SCALE_COORDINATE(value, scale) ((float)((value) * (scale)))
+// ----------------------------------------------------------------------------
+
+
+// Program data constants (do not modify these)
+#define TOTAL_SIDES 2               // Sides per wing (Root, Tip)
+#define TOTAL_HALVES 2              // Halves per side (Upper, Lower)
+#define TOTAL_DIMENSIONS_PER_HALF 2 // Dimensions per half (X, Y)
+#define TOTAL_VECTORS (TOTAL_SIDES * TOTAL_HALVES * TOTAL_DIMENSIONS_PER_HALF)
+
+#define GCODE_VERSION "0.10.0"      // Part of every cache key (see cache.c)
+
+#define READONLY "r"                // File access constants
+#define WRITEONLY "w"               //
+
+#define PATH_SEPARATOR "/"          // Joins a job directory and a filename
+#define MAX_PATH_LENGTH 4096        // Longest input/output path we construct
+#define GCODE_MESSAGE_MAX (MAX_PATH_LENGTH + 256) // Longest message, plus one
+
+// Fatal error messages
+#define MESSAGE_ERROR "* Oops -- Can't "
+#define MESSAGE_FILE_OPENERROR "open %s. Are all vector files present?\n"
+#define MESSAGE_FILE_READERROR "read %s. The first line should be the 'Total Values'.\n"
+#define MESSAGE_FILE_EMPTYERROR "read %s. It lists data points but holds none.\n"
+#define MESSAGE_FILE_WRITEERROR "write to %s. Is the file in-use or the disk full?\n"
+#define MESSAGE_SECTION_FORMATERROR "read %s. It isn't a version %d section file for this machine.\n"
+#define MESSAGE_SECTION_MAPERROR "map %s into memory.\n"
+#define MESSAGE_TRANSFORM_ERROR "understand the placement \"%s\".\n"
+#define MESSAGE_FILE_PARSEERROR "read %s. Line %ld, column %ld is not a number.\n"
+#define MESSAGE_FILE_DAMAGEDERROR "decompress %s. It is damaged or cut short.\n"
+#define MESSAGE_FILE_COMPRESSIONERROR "read %s. It is %s-compressed, and this build can't " \
+  "decompress that.\n"
+#define MESSAGE_COMPRESS_ERROR "compress the output as \"%s\". Give gzip or zstd, with " \
+  "an optional :level, that this build supports.\n"
+#define MESSAGE_REDUCE_STREAMERROR "reduce the tool path while streaming. Leave out --stream or --reduce.\n"
+#define MESSAGE_PROFILE_ERROR "use the profile %s. %s.\n"
+#define MESSAGE_RESAMPLE_STREAMERROR "resample while streaming. Leave out --stream or --resample.\n"
+#define MESSAGE_LIBRARY_INPUTERROR "use the %s%s%s array. It has no values.\n"
+#define MESSAGE_LIBRARY_SINKERROR "write the output. The sink didn't take it.\n"
+#define MESSAGE_LIBRARY_BUFFERERROR "fit the output in the buffer. It needs %lu bytes.\n"
+#define MESSAGE_CACHE_OPENERROR "use %s as the cache. Is it a folder you can write to?\n"
+#define MESSAGE_WATCH_ERROR "watch %s for changes. %s.\n"
+#define MESSAGE_LOFT_OPENERROR "open %s. A loft folder lists its stations, root to tip, " \
+  "in a STATIONS file.\n"
+#define MESSAGE_LOFT_LINEERROR "understand line %d of %s: \"%.40s\". It should give a " \
+  "station name and an optional placement, or \"interpolate\" and a count.\n"
+#define MESSAGE_LOFT_STATIONSERROR "loft %s. It needs at least two stations, with any " \
+  "\"interpolate\" line between two of them.\n"
+#define MESSAGE_LOFT_STREAMERROR "loft while streaming. Leave out --stream or --loft.\n"
+#define MESSAGE_WATCH_STREAMERROR "watch for changes while streaming. Leave out --stream or --watch.\n"
+#define MESSAGE_SERVER_LISTENERROR "listen on %s. %s.\n"
+#define MESSAGE_SERVER_INUSEERROR "listen on %s. Another server is already listening there.\n"
+#define MESSAGE_REQUEST_LINEERROR "understand the request line \"%.40s\".\n"
+#define MESSAGE_REQUEST_OPTIONERROR "use the option \"%.40s\" in a request.\n"
+#define MESSAGE_REQUEST_VECTORERROR "read the vector \"%.40s\". It should give a side, " \
+  "half and dimension, the total values and that many values.\n"
+#define MESSAGE_ENVELOPE_ERROR "cut the %s half. Its %c axis would go from %f to %f, outside " \
+  "the cutter's limits of %f to %f.\n"
+#define MESSAGE_VERIFY_OPENERROR "read %s to verify it.\n"
+#define MESSAGE_VERIFY_LINEERROR "understand %lld lines of %s, the first of them line %lld. " \
+  "Each word should be a letter and a number, and each arc needs I or J.\n"
+#define MESSAGE_VERIFY_LIMITERROR "cut %s safely. %lld moves leave the cutter's limits, the " \
+  "first on line %lld (the %c axis).\n"
+#define MESSAGE_MEMORY_ALLOCERROR "allocate memory for that many data points!\n"
+#define MESSAGE_BATCH_OPENERROR "open %s. Is it a job manifest or a directory of jobs?\n"
+#define MESSAGE_BATCH_EMPTY "find any jobs in %s. Each job folder needs a ROOTUPPERX or SECTION.gcs file.\n"
+
+// Usage and batch summary messages
+#define MESSAGE_USAGE "Usage: %s [options]\n" \
+  "  --profile <file>              Machine profile: G-code dialect, limits, units\n" \
+  "  --stream                      Read points while writing them (constant memory)\n" \
+  "  --root-transform <placement>  Place the root section, e.g.\n" \
+  "                                scale=1.2,twist=0,pivot=0.25:0,sweep=0,dihedral=0,mirror\n" \
+  "  --tip-transform <placement>   Place the tip section, likewise\n" \
+  "  --resample <points>           Resample every half to this many points\n" \
+  "  --cluster                     Resample with points closer together near the\n" \
+  "                                leading edge\n" \
+  "  --reduce <tolerance>          Merge and simplify moves to within the tolerance\n" \
+  "                                (in output units)\n" \
+  "  --arcs                        With --reduce, also fit G2/G3 arcs\n" \
+  "  --max-wire-speed <speed>      Plan the feed of every move so that neither end\n" \
+  "                                of the wire goes faster (output units/minute)\n" \
+  "  --batch <manifest|directory>  Run every job folder listed or found there\n" \
+  "  --jobs <threads>              Threads for batch mode, or for writing a large\n" \
+  "                                job's lines (default: one per processor)\n" \
+  "  --loft <folder>               Cut a wing of several stations, listed root to tip\n" \
+  "                                in the folder's STATIONS file, a bay at a time\n" \
+  "  --combine                     With --loft, write all bays as one program\n" \
+  "  --verify <file>               Read a G-code program back and report its bounds,\n" \
+  "                                wire skew and cut time against the profile\n" \
+  "  --compact <decimals>          Write only the words that change from move to\n" \
+  "                                move, to at most this many decimals (0 to 6)\n" \
+  "  --pack | --unpack             Convert the eight input files to/from " SECTION_FILENAME "\n" \
+  "  --stats | --stats-json        Print each job's stage times and counters\n" \
+  "  --compress <gzip|zstd>[:level] Write the output compressed, to " OUTPUT_FILENAME ".gz\n" \
+  "                                or " OUTPUT_FILENAME ".zst\n" \
+  "  --cache <folder>              Keep every output in this folder and reuse it\n" \
+  "                                when the same inputs and settings come again\n" \
+  "  --cache-limit <megabytes>     Most the cache may hold (default: 256)\n" \
+  "  --cache-stats                 Print the cache's contents and hit rate\n" \
+  "  --watch                       Write the output again whenever the input files\n" \
+  "                                change, rendering only the half that changed\n" \
+  "  --serve <socket>              Render jobs sent to this Unix socket\n" \
+  "  --max-in-flight <jobs>        Requests the server queues or runs at once\n" \
+  "                                (default: four per --jobs thread)\n"
+#define MESSAGE_BATCH_FAILED "* Job failed: %s\n"
+#define MESSAGE_BATCH_SUMMARY "%d of %d jobs completed\n"
+#define MESSAGE_LOFT_SUMMARY "%d of %d bays written\n"
+#define MESSAGE_VERIFY_SUMMARY "%s: %lld lines, %lld bytes; %lld cutting moves (%lld arcs), " \
+  "%lld rapid moves\n"
+#define MESSAGE_VERIFY_AXIS "  %c from %f to %f (limits %f to %f)\n"
+#define MESSAGE_VERIFY_SKEW "  Wire skew: %c-%c from %f to %f, %c-%c from %f to %f, " \
+  "at most %f (line %lld)\n"
+#define MESSAGE_VERIFY_TIME "  Cut time: %.2f minutes over %f of cutting moves, %f of rapid moves\n"
+#define MESSAGE_FEED_SUMMARY "Cut time: %.2f minutes at %s, %.2f minutes planned\n"
+#define MESSAGE_LOFT_FEED_SUMMARY "%s: " MESSAGE_FEED_SUMMARY
+#define MESSAGE_COMPACT_SUMMARY "Compact output: %lld bytes instead of %lld (%.1f%% smaller)\n"
+#define MESSAGE_CACHE_SUMMARY "Cache %s: %d entries, %lld of %lld bytes; %lld hits, " \
+  "%lld misses (%.1f%% hits), %lld evicted\n"
+#define MESSAGE_WATCH_READY "Watching %s for changes. Press Ctrl-C to stop.\n"
+#define MESSAGE_WATCH_UPDATED "%s%s: rendered %s in %.2f ms\n"
+#define MESSAGE_SERVER_LISTENING "Serving on %s with %d workers, at most %d requests in flight\n"
+#define MESSAGE_REDUCE_SUMMARY "%s half: %d points reduced to %d moves (%d arcs), " \
+  "max deviation %f\n"
+
+// Non-fatal error messages
+#define MESSAGE_WARNING "* Note: You should "
+#define MESSAGE_VECTOR_CONSISTENCY "ensure all vector files list the same number of data points\n"
+#define MESSAGE_SECTION_STALE "pack the section again: %s is newer than " SECTION_FILENAME \
+  ", so the vector files were read instead\n"
+#define MESSAGE_VECTOR_EOF "check all vector files for the listed number of data points\n"
+#define MESSAGE_VERIFY_FEEDWARNING "give a feed before the first cutting move (%lld moves have " \
+  "none, and aren't in the cut time)\n"
+#define MESSAGE_NOTE "* Note: "
+#define MESSAGE_VECTOR_RESAMPLED "The %s half's vector files list different numbers of data points, " \
+  "so it was resampled to %d\n"
+
+
+// Enum values for each airfoil side
+enum Side
+{
+    Root,
+    Tip
+};
+extern char *SideToString[];
+
+// Enum values for each airfoil half
+enum Half
+{
+    Upper,
+    Lower
+};
+extern char *HalfToString[];
+
+// Enum values for each airfoil axis. Note that U and V axes are
+// represented here by a second Side of X and Y coordinates.
+enum Dimension 
+{
+    X,
+    Y
+};
+extern char *DimensionToString[];
+
+// How opening or reading one vector's input file went. Vectors may be
+// loaded at the same time, so what happened is reported afterwards, in order.
+enum VectorOutcome
+{
+    VectorLoaded,           // Fine so far
+    VectorOpenFailed,       // The file couldn't be opened
+    VectorNoMemory,         // Its block buffer couldn't be allocated
+    VectorNoTotal,          // The first value isn't a total above zero
+    VectorEnded,            // It ended before the total (which is cut down
+                            //   to the values it held)
+    VectorNotNumber,        // A value isn't a number
+    VectorDamaged,          // It is compressed, but damaged or cut short
+    VectorUnsupported       // It is compressed in a way this build can't read
+};
+
+
+// Each internal vector instance has these properties associated with it
+typedef struct
+{
+    FILE *inputFile;        // File handle to the input file
+    NumberReader reader;    // Parses the numbers out of the input file
+    int totalValues;        // Total data point values
+    float *value;           // Data point values, as read (unscaled)
+    enum VectorOutcome outcome; // How opening or reading it last went
+} Vector;
+
+
+// Options given on the command line. They apply to every job of a run.
+typedef struct
+{
+    int totalThreads;       // Worker threads for batch mode (0 = one per processor)
+    int streaming;          // Nonzero to stream points from the input files
+                            //   instead of loading them all (see stream.c)
+    SideTransform transform[TOTAL_SIDES]; // Placement of each side
+    int resampleTotal;      // Points to resample each half to (0 = only
+                            //   halves whose vectors disagree; see resample.c)
+    int clustering;         // Nonzero to resample closer to the leading edge
+    int reducing;           // Nonzero to reduce the tool path (see reduce.c)
+    double tolerance;       //   to within this distance, in output units,
+    int fitArcs;            //   fitting arcs if this is nonzero
+    double maxWireSpeed;    // Plans each move's feed so neither end of the
+                            //   wire goes faster (0 = the profile's feed)
+    Dialect dialect;        // The machine profile, compiled (see dialect.c)
+    enum StatsFormat statsFormat; // How job statistics are printed (see stats.c)
+    const char *cacheDirectory; // Output cache folder, or NULL (see cache.c)
+    long long cacheLimit;   // Most bytes the cache may hold
+    enum Compression compression; // How output files are compressed
+    int compressionLevel;   //   and how hard (see compress.c)
+} Settings;
+
+
+// Everything needed to turn one set of eight input files (or eight arrays
+// lent by a library caller) into one output file. Jobs share no state, so
+// several of them may run at the same time.
+typedef struct
+{
+    const char *directory;  // Folder holding the input files (NULL = CWD)
+    const Settings *settings; // Options for this run (shared, read-only)
+    Vector thisVector[TOTAL_SIDES][TOTAL_HALVES][TOTAL_DIMENSIONS_PER_HALF];
+    FILE *outputFile;       // File handle to the output file
+    void *section;          // Mapped section file the vectors point into,
+    size_t sectionLength;   //   if they were loaded from one (see section.c)
+    int borrowed;           // Nonzero if the vectors point at a library
+                            //   caller's arrays (see libgcode.c)
+    char *message;          // Where messages go instead of stderr, or NULL
+                            //   (GCODE_MESSAGE_MAX characters)
+    Arena *arena;           // Where the job's buffers come from, or NULL
+                            //   for malloc() (see arena.c)
+    int skipHalf[TOTAL_HALVES]; // Nonzero for a half that is left unloaded
+                            //   (watch mode reloads one half at a time)
+    int skipSide[TOTAL_SIDES];  // Likewise for a side (a loft loads each
+                            //   station once; see loft.c)
+    const char *sideName[TOTAL_SIDES]; // Start of each side's input
+                            //   filenames (NULL = ROOT or TIP)
+    const char *outputName; // Name of the output file (NULL = OUTPUT.txt)
+    int streaming;          // Nonzero if points are read while being written
+    int threads;            // Threads the job may use for itself: to load
+                            //   the eight vectors at once and to format large
+                            //   halves (1 = just this one)
+    int transformed[TOTAL_SIDES]; // Nonzero if a side has a placement,
+    AffineTransform transform[TOTAL_SIDES]; // which is this transform
+    int reduced;            // Nonzero if each half is written from its
+    ToolPath path[TOTAL_HALVES]; // reduced tool path instead of point by point
+    FeedPlanner planner;    // Chooses the feed of each move as it's written
+    JobStats stats;         // Stage times and counters (see stats.c)
+    unsigned long long identityKey; // Cache keys of the input files' identities
+    unsigned long long contentKey;  //   and of their contents (0 = not known)
+} Job;
+
+
+// Function prototypes
+void InitializeSettings(Settings *settings);
+void InitializeJob(Job *job, const char *directory, const Settings *settings);
+int ParseJobOption(Settings *settings, int argc, const char *argv[], int *thisArgument);
+int RunJob(Job *job);
+int BuildToolPaths(Job *job);
+int LoadVectorData(Job *job);
+void *AllocateJobMemory(Job *job, size_t size);
+void FreeJobMemory(Job *job, void *memory);
+void ReportMessage(const Job *job, const char *severity, const char *format, ...);
+void ReportParseError(Job *job, enum Side thisSide, enum Half thisHalf,
+                      enum Dimension thisDimension);
+void BuildFilename(const Job *job, const char *name, char *filename);
+void BuildVectorFilename(const Job *job, enum Side thisSide, enum Half thisHalf,
+                         enum Dimension thisDimension, char *filename);
+void FindVectorFile(const Job *job, enum Side thisSide, enum Half thisHalf,
+                    enum Dimension thisDimension, char *filename);
+void BuildOutputFilename(const Job *job, char *filename);
+int OpenDataFiles(Job *job);
+void CloseDataFiles(Job *job);
+int AllocateMemory(Job *job);
+void FreeMemory(Job *job);
+int DetachVectors(Job *job);
+void CheckVectorConsistency(Job *job);
+int ReadVectorData(Job *job);
+int ResampleVectors(Job *job);
+int ApplyTransforms(Job *job);
+int ReduceToolPaths(Job *job);
+int OutputGCode(Job *job);
+int WriteOutputPieces(const Job *job, struct iovec *piece, int totalPieces);
+int EmitHalf(Job *job, OutputBuffer *output, enum Half thisHalf);
+int EmitGCode(Job *job, OutputBuffer *output);
+
+
+#endif
+// --- End of gcode.h
@@ -0,0 +1,217 @@
+// hash.c
+//
+// XXH64: a fast, well-mixed 64-bit hash of any number of bytes
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// This is the published XXH64 algorithm, so a key can be checked with the
+// xxhsum tool. Input is consumed in 32-byte stripes across four lanes,
+// which keeps it at several gigabytes a second. Words are read in the
+// byte order of this machine; on the usual little-endian machines that
+// matches xxhsum, and either way a cache is only read by the machine that
+// wrote it.
+//
+
+
+#include <string.h>
+
+#include "hash.h"
+
+
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+#define PRIME4 0x85EBCA77C2B2AE63ULL
+#define PRIME5 0x27D4EB2F165667C5ULL
+
+#define ROTATE_LEFT(value, bits) (((value) << (bits)) | ((value) >> (64 - (bits))))
+
+
+// Function name: ReadWord()
+// Purpose: Reads eight bytes that may not be aligned.
+//
+static uint64_t ReadWord(const unsigned char *bytes)
+{
+    uint64_t word;
+
+    memcpy(&word, bytes, sizeof(word));
+
+    return(word);
+}
+
+
+// Function name: MixLane()
+// Purpose: Folds one word into one lane.
+//
+static uint64_t MixLane(uint64_t accumulator, uint64_t word)
+{
+    accumulator += word * PRIME2;
+    accumulator = ROTATE_LEFT(accumulator, 31);
+
+    return(accumulator * PRIME1);
+}
+
+
+// Function name: MergeLane()
+// Purpose: Folds one lane into the final hash.
+//
+static uint64_t MergeLane(uint64_t hash, uint64_t accumulator)
+{
+    hash ^= MixLane(0, accumulator);
+
+    return(hash * PRIME1 + PRIME4);
+}
+
+
+// Function name: BeginHash()
+// Purpose: Starts a hash with nothing added yet.
+//
+void BeginHash(HashState *state, uint64_t seed)
+{
+    state->accumulator[0] = seed + PRIME1 + PRIME2;
+    state->accumulator[1] = seed + PRIME2;
+    state->accumulator[2] = seed;
+    state->accumulator[3] = seed - PRIME1;
+    state->totalLength = 0;
+    state->totalPending = 0;
+    state->seed = seed;
+}
+
+
+// Function name: AddToHash()
+// Purpose: Adds "length" bytes to the hash.
+//
+void AddToHash(HashState *state, const void *bytes, size_t length)
+{
+    const unsigned char *cursor = (const unsigned char *)bytes;
+    const unsigned char *end = cursor + length;
+    size_t needed;
+
+    state->totalLength += length;
+
+    // Finish the stripe left over from last time
+    if (state->totalPending > 0)
+    {
+        needed = 32 - state->totalPending;
+        if (length < needed)
+        {
+            memcpy(state->pending + state->totalPending, cursor, length);
+            state->totalPending += length;
+            return;
+        }
+        memcpy(state->pending + state->totalPending, cursor, needed);
+        cursor += needed;
+        state->accumulator[0] = MixLane(state->accumulator[0], ReadWord(state->pending));
+        state->accumulator[1] = MixLane(state->accumulator[1], ReadWord(state->pending + 8));
+        state->accumulator[2] = MixLane(state->accumulator[2], ReadWord(state->pending + 16));
+        state->accumulator[3] = MixLane(state->accumulator[3], ReadWord(state->pending + 24));
+        state->totalPending = 0;
+    }
+
+    // Whole stripes straight from the input
+    while (end - cursor >= 32)
+    {
+        state->accumulator[0] = MixLane(state->accumulator[0], ReadWord(cursor));
+        state->accumulator[1] = MixLane(state->accumulator[1], ReadWord(cursor + 8));
+        state->accumulator[2] = MixLane(state->accumulator[2], ReadWord(cursor + 16));
+        state->accumulator[3] = MixLane(state->accumulator[3], ReadWord(cursor + 24));
+        cursor += 32;
+    }
+
+    // Keep the rest for next time
+    memcpy(state->pending, cursor, end - cursor);
+    state->totalPending = end - cursor;
+}
+
+
+// Function name: EndHash()
+// Purpose: Returns the hash of everything added. The state is left as it
+//          was, so more can still be added.
+//
+uint64_t EndHash(const HashState *state)
+{
+    const unsigned char *cursor = state->pending;
+    const unsigned char *end = state->pending + state->totalPending;
+    uint64_t hash;
+    uint32_t half;
+
+    if (state->totalLength >= 32)
+    {
+        hash = ROTATE_LEFT(state->accumulator[0], 1) + ROTATE_LEFT(state->accumulator[1], 7) +
+               ROTATE_LEFT(state->accumulator[2], 12) + ROTATE_LEFT(state->accumulator[3], 18);
+        hash = MergeLane(hash, state->accumulator[0]);
+        hash = MergeLane(hash, state->accumulator[1]);
+        hash = MergeLane(hash, state->accumulator[2]);
+        hash = MergeLane(hash, state->accumulator[3]);
+    }
+    else
+    {
+        hash = state->seed + PRIME5;
+    }
+    hash += state->totalLength;
+
+    // The bytes short of a whole stripe
+    while (end - cursor >= 8)
+    {
+        hash ^= MixLane(0, ReadWord(cursor));
+        hash = ROTATE_LEFT(hash, 27) * PRIME1 + PRIME4;
+        cursor += 8;
+    }
+    if (end - cursor >= 4)
+    {
+        memcpy(&half, cursor, sizeof(half));
+        hash ^= (uint64_t)half * PRIME1;
+        hash = ROTATE_LEFT(hash, 23) * PRIME2 + PRIME3;
+        cursor += 4;
+    }
+    while (cursor < end)
+    {
+        hash ^= (*cursor++) * PRIME5;
+        hash = ROTATE_LEFT(hash, 11) * PRIME1;
+    }
+
+    // Final mix
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+
+    return(hash);
+}
+
+
+// Function name: HashBytes()
+// Purpose: Returns the hash of one block of bytes.
+//
+uint64_t HashBytes(const void *bytes, size_t length, uint64_t seed)
+{
+    HashState state;
+
+    BeginHash(&state, seed);
+    AddToHash(&state, bytes, length);
+
+    return(EndHash(&state));
+}
+
+
+// --- End of hash.c
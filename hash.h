@@ -0,0 +1,53 @@
+// hash.h
+//
+// 64-bit XXH64 hashing of byte streams, for cache keys (see hash.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef HASH_H          // Don't define everything more than once
+#define HASH_H          //
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// A hash in progress. Bytes can be added in pieces of any size.
+typedef struct
+{
+    uint64_t accumulator[4];    // The four lanes
+    uint64_t totalLength;       // Bytes added so far
+    unsigned char pending[32];  // Bytes not yet making up a whole stripe
+    size_t totalPending;        //
+    uint64_t seed;
+} HashState;
+
+
+// Function prototypes
+void BeginHash(HashState *state, uint64_t seed);
+void AddToHash(HashState *state, const void *bytes, size_t length);
+uint64_t EndHash(const HashState *state);
+uint64_t HashBytes(const void *bytes, size_t length, uint64_t seed);
+
+
+#endif
+// --- End of hash.h
@@ -0,0 +1,275 @@
+// libgcode.c
+//
+// The GCode project as a library: renders G-code from airfoil coordinates
+// held in the caller's memory, into the caller's buffer or sink
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// A render is a job like any other (see RunJob()), except that its
+// vectors point at the caller's arrays (or are read from a folder the
+// caller names), and its output goes to a sink instead of OUTPUT.txt. The
+// arrays are borrowed: they are only copied if resampling or a placement
+// has to change the values (see DetachVectors()). Everything a render changes is
+// in its own Job on the stack, so renders on different threads share
+// nothing but the read-only context.
+//
+// Messages go into the caller's "message" buffer (GCODE_MESSAGE_MAX
+// characters) when one is given, one after another, or to stderr otherwise. Statistics are
+// not printed, whatever the context's settings say.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libgcode.h"
+
+
+// Where RenderGCodeToBuffer() puts the output
+typedef struct
+{
+    char *buffer;
+    size_t capacity;
+    size_t length;          // Bytes of output so far, even past capacity
+} BufferSink;
+
+
+// Function name: CreateGCodeContext()
+// Purpose: Fills in the default settings and compiles the machine profile
+//          file "profile" (or just the built-in one, if it is NULL). The
+//          caller may then change the settings before rendering. Returns
+//          EXIT_FAILURE, with the problem in "message", if the profile
+//          can't be used.
+//
+int CreateGCodeContext(GCodeContext *context, const char *profile, char *message)
+{
+    char error[DIALECT_ERROR_MAX];
+
+    InitializeSettings(&context->settings);
+    if (CompileDialect(&context->settings.dialect, profile, error) != EXIT_SUCCESS)
+    {
+        if (message != NULL)
+        {
+            snprintf(message, GCODE_MESSAGE_MAX, MESSAGE_ERROR MESSAGE_PROFILE_ERROR,
+                     profile, error);
+        }
+        return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: FreeGCodeContext()
+// Purpose: Releases what CreateGCodeContext() compiled.
+//
+void FreeGCodeContext(GCodeContext *context)
+{
+    FreeDialect(&context->settings.dialect);
+}
+
+
+// Function name: LendVectors()
+// Purpose: Points every vector of the job at the caller's array. Returns
+//          EXIT_FAILURE if one of the arrays is missing or empty.
+//
+static int LendVectors(Job *job, const GCodeInput *input)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    // Nothing the job points at now is its own to free
+    job->borrowed = 1;
+
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                if (input->value[thisSide][thisHalf][thisDimension] == NULL ||
+                    input->totalValues[thisSide][thisHalf][thisDimension] <= 0)
+                {
+                    ReportMessage(job, MESSAGE_ERROR, MESSAGE_LIBRARY_INPUTERROR,
+                                  SideToString[thisSide], HalfToString[thisHalf],
+                                  DimensionToString[thisDimension]);
+                    return(EXIT_FAILURE);
+                }
+                // Never written through: DetachVectors() copies them first
+                job->thisVector[thisSide][thisHalf][thisDimension].value =
+                  (float *)input->value[thisSide][thisHalf][thisDimension];
+                job->thisVector[thisSide][thisHalf][thisDimension].totalValues =
+                  input->totalValues[thisSide][thisHalf][thisDimension];
+            }
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: RenderGCode()
+// Purpose: Renders the G-code for one job's vectors, handing it to "sink"
+//          a block at a time. Returns EXIT_FAILURE, with the problem in
+//          "message", if the input can't be used, memory runs out or the
+//          sink refuses the output.
+//
+int RenderGCode(const GCodeContext *context, const GCodeInput *input, GCodeSink sink,
+                void *sinkData, char *message)
+{
+    return(RenderGCodeInArena(context, input, NULL, sink, sinkData, message));
+}
+
+
+// Function name: RenderGCodeInArena()
+// Purpose: Like RenderGCode(), but every buffer the job needs comes from
+//          "arena" (see arena.c), which the caller resets once the call
+//          returns. A caller rendering job after job on one thread then
+//          allocates nothing after the first few.
+//
+int RenderGCodeInArena(const GCodeContext *context, const GCodeInput *input, Arena *arena,
+                       GCodeSink sink, void *sinkData, char *message)
+{
+    OutputBuffer output;
+    Job job;
+    char *storage = NULL;
+    int result;
+
+    InitializeJob(&job, input->directory, &context->settings);
+    job.message = message;
+    job.arena = arena;
+    if (message != NULL)
+    {
+        message[0] = '\0';
+    }
+
+    // Read the vectors from the job's folder, or use the caller's arrays
+    if (input->directory != NULL)
+    {
+        result = LoadVectorData(&job);
+    }
+    else
+    {
+        result = LendVectors(&job, input);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        result = BuildToolPaths(&job);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        if (arena != NULL)
+        {
+            storage = (char *)AllocateFromArena(arena, OUTPUT_BUFFER_SIZE);
+        }
+        if (OpenOutputSink(&output, sink, sinkData, &context->settings.dialect,
+                           storage) != EXIT_SUCCESS)
+        {
+            ReportMessage(&job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+            result = EXIT_FAILURE;
+        }
+        else
+        {
+            result = EmitGCode(&job, &output);
+            if (CloseOutputBuffer(&output) != EXIT_SUCCESS && result == EXIT_SUCCESS)
+            {
+                ReportMessage(&job, MESSAGE_ERROR, MESSAGE_LIBRARY_SINKERROR);
+                result = EXIT_FAILURE;
+            }
+        }
+    }
+    if (result == EXIT_SUCCESS && job.planner.maxSpeed > 0.0)
+    {
+        ReportMessage(&job, "", MESSAGE_FEED_SUMMARY, job.planner.constantTime,
+                      context->settings.dialect.feedWord, job.planner.plannedTime);
+    }
+
+    FreeMemory(&job);
+    CloseDataFiles(&job);
+
+    return(result);
+}
+
+
+// Function name: TakeBlock()
+// Purpose: The sink of RenderGCodeToBuffer(). Output past the end of the
+//          buffer is only counted, so the caller learns how much room it
+//          needs.
+//
+static int TakeBlock(void *sinkData, const char *text, size_t length)
+{
+    BufferSink *buffer = (BufferSink *)sinkData;
+
+    if (buffer->length < buffer->capacity)
+    {
+        memcpy(buffer->buffer + buffer->length, text,
+               (length < buffer->capacity - buffer->length) ?
+                 length : buffer->capacity - buffer->length);
+    }
+    buffer->length += length;
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: RenderGCodeToBuffer()
+// Purpose: Renders the G-code for one job's vectors into "buffer", which
+//          holds "capacity" bytes, and sets "length" to the bytes of
+//          output. The text is followed by a zero if there is room for one.
+//          Returns EXIT_FAILURE, like RenderGCode(), and also if the
+//          output doesn't fit, in which case "length" is the room needed.
+//
+int RenderGCodeToBuffer(const GCodeContext *context, const GCodeInput *input, char *buffer,
+                        size_t capacity, size_t *length, char *message)
+{
+    BufferSink sink;
+    size_t used;
+    int result;
+
+    sink.buffer = buffer;
+    sink.capacity = capacity;
+    sink.length = 0;
+
+    result = RenderGCode(context, input, TakeBlock, &sink, message);
+    *length = sink.length;
+    if (result == EXIT_SUCCESS && sink.length > capacity)
+    {
+        if (message != NULL)
+        {
+            used = strlen(message);
+            snprintf(message + used, GCODE_MESSAGE_MAX - used,
+                     MESSAGE_ERROR MESSAGE_LIBRARY_BUFFERERROR, (unsigned long)sink.length);
+        }
+        return(EXIT_FAILURE);
+    }
+    if (sink.length < capacity)
+    {
+        buffer[sink.length] = '\0';
+    }
+
+    return(result);
+}
+
+
+// --- End of libgcode.c
@@ -0,0 +1,72 @@
+// libgcode.h
+//
+// The GCode project as a library: G-code from airfoil coordinates that are
+// already in memory, with no files involved (see libgcode.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef LIBGCODE_H      // Don't define everything more than once
+#define LIBGCODE_H      //
+
+#include "gcode.h"
+#include "emit.h"
+
+
+// How to render: the options (as the command line would set them) and
+// the compiled machine profile. A context is only read while rendering, so
+// any number of threads may render with the same one at once.
+typedef struct
+{
+    Settings settings;
+} GCodeContext;
+
+// The eight vectors of one job, indexed like Job.thisVector. The arrays
+// belong to the caller, who must keep them unchanged until the call
+// returns; they are never written or freed. If "directory" is given, the
+// vectors are read from the input files (or section file) in that folder
+// instead, as the gcode command would.
+typedef struct
+{
+    const char *directory;
+    const float *value[TOTAL_SIDES][TOTAL_HALVES][TOTAL_DIMENSIONS_PER_HALF];
+    int totalValues[TOTAL_SIDES][TOTAL_HALVES][TOTAL_DIMENSIONS_PER_HALF];
+} GCodeInput;
+
+// Takes the output a block at a time, in order. Returns EXIT_FAILURE to
+// stop rendering.
+typedef OutputSink GCodeSink;
+
+
+// Function prototypes
+int CreateGCodeContext(GCodeContext *context, const char *profile, char *message);
+void FreeGCodeContext(GCodeContext *context);
+int RenderGCode(const GCodeContext *context, const GCodeInput *input, GCodeSink sink,
+                void *sinkData, char *message);
+int RenderGCodeInArena(const GCodeContext *context, const GCodeInput *input, Arena *arena,
+                       GCodeSink sink, void *sinkData, char *message);
+int RenderGCodeToBuffer(const GCodeContext *context, const GCodeInput *input, char *buffer,
+                        size_t capacity, size_t *length, char *message);
+
+
+#endif
+// --- End of libgcode.h
@@ -0,0 +1,641 @@
+// loft.c
+//
+// Lofting: a wing of several spanwise stations, cut as one bay between
+// each pair of neighbouring stations (see loft.h)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// A loft folder holds a STATIONS file naming the wing's stations from
+// root to tip, one per line, each with an optional placement in the form
+// "--root-transform" takes:
+//
+//   ROOT
+//   KINK  twist=-1,sweep=0.8
+//   interpolate 2
+//   TIP   scale=0.6,twist=-3,sweep=2.5,pivot=0.25:0
+//
+// and, for every station, the four files of its section, named like the
+// root's: KINKUPPERX, KINKUPPERY, KINKLOWERX and KINKLOWERY (possibly
+// compressed; see compress.c). Each pair of neighbouring stations is a
+// bay, cut with the inner station on X/Y and the outer one on U/V, each
+// placed as its line says. "interpolate N" between two stations cuts
+// their bay as N + 1 shorter bays instead, through stations that lie on
+// the straight lines the wire would have followed across the whole bay.
+//
+// Every station is read once, by one thread each, and lent to the bays on
+// both sides of it. The bays are then rendered at the same time, each as
+// its own job, into memory, and written as OUTPUT.1.txt, OUTPUT.2.txt and
+// so on from the root, or with --combine as one OUTPUT.txt that runs from
+// bay to bay through the profile's [next_bay] block.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "loft.h"
+#include "emit.h"
+#include "pool.h"
+#include "verify.h"
+
+
+// Pieces of a bay's output: upper half, transition, lower half, and then
+// the next bay block or the footer
+#define PIECES_PER_BAY 4
+
+
+// One spanwise station of the wing
+typedef struct
+{
+    char name[LOFT_NAME_MAX];   // Start of its input filenames
+    SideTransform transform;    // Its placement
+    int totalSteps;         // Stations interpolated between it and the next
+    Job job;                // Holds its vectors, loaded as the root side
+    int result;             // EXIT_SUCCESS once it has been loaded
+} Station;
+
+// One bay: the part of the wing cut between two (perhaps interpolated)
+// stations
+typedef struct
+{
+    int inner;              // Station at the root end of the whole bay
+    double start;           // How far towards the next station the bay's
+    double end;             //   root and tip ends are (0 to 1)
+    Settings settings;      // The run's settings, with both stations' placements
+    char outputName[LOFT_OUTPUT_MAX];       // Its own output file
+    Job job;                // Renders it
+    TextBuffer half[TOTAL_HALVES];          // Its rendered halves
+    int result;             // EXIT_SUCCESS once it has been rendered
+} Bay;
+
+// What every pool task needs
+typedef struct
+{
+    const char *directory;
+    const Settings *settings;
+    int combined;           // Nonzero to write one program for all bays
+    Station *station;
+    int totalStations;
+    Bay *bay;
+    int totalBays;
+} Loft;
+
+
+
+// Function name: ParseStation()
+// Purpose: Reads one line of a STATIONS file into a new station, or into
+//          the previous station's count of stations to interpolate.
+//          Returns EXIT_FAILURE if it is neither.
+//
+static int ParseStation(char *line, Station *station, int *totalStations)
+{
+    Station *thisStation = &station[*totalStations];
+    char *value;
+    char *end;
+    long totalSteps;
+
+    // The name, then whatever follows it
+    value = line + strcspn(line, " \t");
+    if (*value != '\0')
+    {
+        *value++ = '\0';
+        value += strspn(value, " \t");
+    }
+
+    if (strcmp(line, STATIONS_INTERPOLATE) == 0)
+    {
+        totalSteps = strtol(value, &end, 10);
+        if (*totalStations == 0 || end == value || *end != '\0' || totalSteps < 1 ||
+            totalSteps > 1000)
+        {
+            return(EXIT_FAILURE);
+        }
+        station[*totalStations - 1].totalSteps = (int)totalSteps;
+        return(EXIT_SUCCESS);
+    }
+
+    if (strlen(line) >= LOFT_NAME_MAX || strchr(line, PATH_SEPARATOR[0]) != NULL)
+    {
+        return(EXIT_FAILURE);
+    }
+    memset(thisStation, 0, sizeof(Station));
+    strcpy(thisStation->name, line);
+    InitializeTransform(&thisStation->transform);
+    if (*value != '\0' && ParseTransform(value, &thisStation->transform) != EXIT_SUCCESS)
+    {
+        return(EXIT_FAILURE);
+    }
+    (*totalStations)++;
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ReadStations()
+// Purpose: Reads the loft's STATIONS file. Blank lines and lines starting
+//          with STATIONS_COMMENT are skipped. Returns EXIT_FAILURE, having
+//          reported why, if it can't be read or makes no sense.
+//
+static int ReadStations(Loft *loft, const Job *noJob)
+{
+    char filename[MAX_PATH_LENGTH];
+    char line[MAX_PATH_LENGTH];
+    char words[MAX_PATH_LENGTH];    // The line, split up while it's parsed
+    Station *grown;
+    FILE *file;
+    int capacity = 0;
+    int lineNumber = 0;
+    int result = EXIT_SUCCESS;
+    char *start;
+    char *end;
+
+    BuildFilename(noJob, STATIONS_FILENAME, filename);
+    file = fopen(filename, READONLY);
+    if (file == NULL)
+    {
+        ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_LOFT_OPENERROR, filename);
+        return(EXIT_FAILURE);
+    }
+
+    while (result == EXIT_SUCCESS && fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+
+        // Trim leading and trailing whitespace, including CR/LF
+        start = line;
+        while (*start == ' ' || *start == '\t')
+        {
+            start++;
+        }
+        end = start + strlen(start);
+        while (end > start && (end[-1] == '\n' || end[-1] == '\r' ||
+                               end[-1] == ' ' || end[-1] == '\t'))
+        {
+            *--end = '\0';
+        }
+        if (*start == '\0' || *start == STATIONS_COMMENT)
+        {
+            continue;
+        }
+
+        if (loft->totalStations == capacity)
+        {
+            capacity = (capacity == 0) ? 8 : capacity * 2;
+            grown = (Station *)realloc(loft->station, capacity * sizeof(Station));
+            if (grown == NULL)
+            {
+                ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+                result = EXIT_FAILURE;
+                break;
+            }
+            loft->station = grown;
+        }
+        strcpy(words, start);
+        if (ParseStation(words, loft->station, &loft->totalStations) != EXIT_SUCCESS)
+        {
+            ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_LOFT_LINEERROR, lineNumber, filename,
+                          start);
+            result = EXIT_FAILURE;
+        }
+    }
+    fclose(file);
+
+    // Interpolating after the last station would have nothing to reach
+    if (result == EXIT_SUCCESS &&
+        (loft->totalStations < 2 || loft->station[loft->totalStations - 1].totalSteps > 0))
+    {
+        ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_LOFT_STATIONSERROR, filename);
+        result = EXIT_FAILURE;
+    }
+
+    return(result);
+}
+
+
+// Function name: LoadStationTask()
+// Purpose: Pool task that reads the four files of one station, once, for
+//          all the bays it belongs to.
+//
+static void LoadStationTask(void *context, int index)
+{
+    Loft *loft = (Loft *)context;
+    Station *station = &loft->station[index];
+
+    InitializeJob(&station->job, loft->directory, loft->settings);
+    station->job.sideName[Root] = station->name;
+    station->job.skipSide[Tip] = 1;
+
+    station->result = LoadVectorData(&station->job);
+    CloseDataFiles(&station->job);
+}
+
+
+// Function name: LendStations()
+// Purpose: Points a bay's root side at its inner station's vectors and its
+//          tip side at the outer station's. Nothing is copied unless the
+//          bay has to change the values (see DetachVectors()).
+//
+static void LendStations(Bay *bay, const Station *inner, const Station *outer)
+{
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    bay->job.borrowed = 1;
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        for (thisDimension = X; thisDimension <= Y; thisDimension++)
+        {
+            bay->job.thisVector[Root][thisHalf][thisDimension] =
+              inner->job.thisVector[Root][thisHalf][thisDimension];
+            bay->job.thisVector[Tip][thisHalf][thisDimension] =
+              outer->job.thisVector[Root][thisHalf][thisDimension];
+            // The readers stay with the stations
+            memset(&bay->job.thisVector[Root][thisHalf][thisDimension].reader, 0,
+                   sizeof(NumberReader));
+            memset(&bay->job.thisVector[Tip][thisHalf][thisDimension].reader, 0,
+                   sizeof(NumberReader));
+            bay->job.thisVector[Root][thisHalf][thisDimension].inputFile = NULL;
+            bay->job.thisVector[Tip][thisHalf][thisDimension].inputFile = NULL;
+        }
+    }
+}
+
+
+// Function name: InterpolateStations()
+// Purpose: Moves a bay's root and tip to "start" and "end" of the way from
+//          the inner station to the outer one, point by point. The wire
+//          joins the same points of the two stations, so the shorter bay
+//          cuts exactly the surface the whole bay would have. Every vector
+//          of a half has the same number of values by now (see
+//          ResampleVectors()).
+//
+static int InterpolateStations(Bay *bay)
+{
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    float *root;
+    float *tip;
+    float inner;
+    float outer;
+    int thisValue;
+    int result;
+
+    result = DetachVectors(&bay->job);
+    if (result != EXIT_SUCCESS)
+    {
+        return(result);
+    }
+
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        for (thisDimension = X; thisDimension <= Y; thisDimension++)
+        {
+            root = bay->job.thisVector[Root][thisHalf][thisDimension].value;
+            tip = bay->job.thisVector[Tip][thisHalf][thisDimension].value;
+            for (thisValue = 0;
+                 thisValue < bay->job.thisVector[Tip][thisHalf][thisDimension].totalValues;
+                 thisValue++)
+            {
+                inner = root[thisValue];
+                outer = tip[thisValue];
+                root[thisValue] = (float)(inner + (outer - inner) * bay->start);
+                tip[thisValue] = (float)(inner + (outer - inner) * bay->end);
+            }
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: RenderBayTask()
+// Purpose: Pool task that renders one bay: resampled, placed, moved to its
+//          part of the whole bay, reduced, checked against the cutter's
+//          limits and written into memory. Unless the loft is written as
+//          one program, the bay's own output file is written too, and its
+//          text let go.
+//
+static void RenderBayTask(void *context, int index)
+{
+    Loft *loft = (Loft *)context;
+    Bay *bay = &loft->bay[index];
+    const Station *inner = &loft->station[bay->inner];
+    const Station *outer = &loft->station[bay->inner + 1];
+    const Dialect *dialect = &loft->settings->dialect;
+    enum Half thisHalf;
+
+    OutputBuffer output;
+    struct iovec piece[PIECES_PER_BAY + 1];
+    int result;
+
+    InitializeJob(&bay->job, loft->directory, &bay->settings);
+    bay->job.outputName = bay->outputName;
+    LendStations(bay, inner, outer);
+
+    // Placed first, so the stations in between lie on the placed wing
+    result = ResampleVectors(&bay->job);
+    if (result == EXIT_SUCCESS)
+    {
+        result = ApplyTransforms(&bay->job);
+    }
+    if (result == EXIT_SUCCESS && (bay->start > 0.0 || bay->end < 1.0))
+    {
+        result = InterpolateStations(bay);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        result = ReduceToolPaths(&bay->job);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        result = CheckEnvelope(&bay->job);
+    }
+
+    for (thisHalf = Upper; thisHalf <= Lower && result == EXIT_SUCCESS; thisHalf++)
+    {
+        if (OpenOutputSink(&output, TakeText, &bay->half[thisHalf], dialect, NULL) !=
+            EXIT_SUCCESS)
+        {
+            ReportMessage(&bay->job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+            result = EXIT_FAILURE;
+            break;
+        }
+        result = EmitHalf(&bay->job, &output, thisHalf);
+        if (CloseOutputBuffer(&output) != EXIT_SUCCESS && result == EXIT_SUCCESS)
+        {
+            ReportMessage(&bay->job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+            result = EXIT_FAILURE;
+        }
+    }
+    FreeMemory(&bay->job);
+
+    if (result == EXIT_SUCCESS && !loft->combined)
+    {
+        piece[0].iov_base = dialect->block[Header];
+        piece[0].iov_len = dialect->blockLength[Header];
+        piece[1].iov_base = bay->half[Upper].text;
+        piece[1].iov_len = bay->half[Upper].length;
+        piece[2].iov_base = dialect->block[Transition];
+        piece[2].iov_len = dialect->blockLength[Transition];
+        piece[3].iov_base = bay->half[Lower].text;
+        piece[3].iov_len = bay->half[Lower].length;
+        piece[4].iov_base = dialect->block[Footer];
+        piece[4].iov_len = dialect->blockLength[Footer];
+        result = WriteOutputPieces(&bay->job, piece, PIECES_PER_BAY + 1);
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            free(bay->half[thisHalf].text);
+            memset(&bay->half[thisHalf], 0, sizeof(TextBuffer));
+        }
+    }
+
+    bay->result = result;
+}
+
+
+// Function name: PlanBays()
+// Purpose: Lists the bays between each pair of stations, with their own
+//          settings and output names. Returns EXIT_FAILURE if memory runs
+//          out.
+//
+static int PlanBays(Loft *loft)
+{
+    Bay *bay;
+    int thisStation;
+    int thisStep;
+    int totalSteps;
+
+    loft->totalBays = 0;
+    for (thisStation = 0; thisStation + 1 < loft->totalStations; thisStation++)
+    {
+        loft->totalBays += loft->station[thisStation].totalSteps + 1;
+    }
+    loft->bay = (Bay *)calloc(loft->totalBays, sizeof(Bay));
+    if (loft->bay == NULL)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    bay = loft->bay;
+    for (thisStation = 0; thisStation + 1 < loft->totalStations; thisStation++)
+    {
+        totalSteps = loft->station[thisStation].totalSteps + 1;
+        for (thisStep = 0; thisStep < totalSteps; thisStep++, bay++)
+        {
+            bay->inner = thisStation;
+            bay->start = (double)thisStep / totalSteps;
+            bay->end = (double)(thisStep + 1) / totalSteps;
+            bay->settings = *loft->settings;
+            bay->settings.transform[Root] = loft->station[thisStation].transform;
+            bay->settings.transform[Tip] = loft->station[thisStation + 1].transform;
+            snprintf(bay->outputName, sizeof(bay->outputName), "OUTPUT.%d.txt",
+                     (int)(bay - loft->bay) + 1);
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: WriteCombined()
+// Purpose: Writes every bay, root to tip, as one program: the header, each
+//          bay's halves with the transition between them, the next bay
+//          block between bays, and the footer.
+//
+static int WriteCombined(const Loft *loft, const Job *noJob)
+{
+    const Dialect *dialect = &loft->settings->dialect;
+    struct iovec *piece;
+    struct iovec *thisPiece;
+    int thisBay;
+    int result;
+
+    piece = (struct iovec *)malloc((loft->totalBays * PIECES_PER_BAY + 1) *
+                                   sizeof(struct iovec));
+    if (piece == NULL)
+    {
+        ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+        return(EXIT_FAILURE);
+    }
+
+    thisPiece = piece;
+    thisPiece->iov_base = dialect->block[Header];
+    thisPiece->iov_len = dialect->blockLength[Header];
+    thisPiece++;
+    for (thisBay = 0; thisBay < loft->totalBays; thisBay++)
+    {
+        thisPiece->iov_base = loft->bay[thisBay].half[Upper].text;
+        thisPiece->iov_len = loft->bay[thisBay].half[Upper].length;
+        thisPiece++;
+        thisPiece->iov_base = dialect->block[Transition];
+        thisPiece->iov_len = dialect->blockLength[Transition];
+        thisPiece++;
+        thisPiece->iov_base = loft->bay[thisBay].half[Lower].text;
+        thisPiece->iov_len = loft->bay[thisBay].half[Lower].length;
+        thisPiece++;
+        if (thisBay + 1 < loft->totalBays)
+        {
+            thisPiece->iov_base = dialect->block[NextBay];
+            thisPiece->iov_len = dialect->blockLength[NextBay];
+        }
+        else
+        {
+            thisPiece->iov_base = dialect->block[Footer];
+            thisPiece->iov_len = dialect->blockLength[Footer];
+        }
+        thisPiece++;
+    }
+
+    result = WriteOutputPieces(noJob, piece, loft->totalBays * PIECES_PER_BAY + 1);
+    free(piece);
+
+    return(result);
+}
+
+
+// Function name: ReportLoftFeeds()
+// Purpose: Prints the estimated cut time at the profile's feed and with
+//          the planned feeds, once a loft has been planned with
+//          --max-wire-speed: in total for one combined program, or for
+//          each bay's own file, root to tip.
+//
+static void ReportLoftFeeds(const Loft *loft, const Job *noJob, int completed)
+{
+    const Bay *bay;
+    double constantTime = 0.0;
+    double plannedTime = 0.0;
+    int thisBay;
+
+    if (loft->settings->maxWireSpeed <= 0.0)
+    {
+        return;
+    }
+    for (thisBay = 0; thisBay < loft->totalBays; thisBay++)
+    {
+        bay = &loft->bay[thisBay];
+        if (bay->result != EXIT_SUCCESS)
+        {
+            continue;
+        }
+        if (!loft->combined)
+        {
+            ReportMessage(noJob, "", MESSAGE_LOFT_FEED_SUMMARY, bay->outputName,
+                          bay->job.planner.constantTime, loft->settings->dialect.feedWord,
+                          bay->job.planner.plannedTime);
+        }
+        constantTime += bay->job.planner.constantTime;
+        plannedTime += bay->job.planner.plannedTime;
+    }
+    if (loft->combined && completed == loft->totalBays)
+    {
+        ReportMessage(noJob, "", MESSAGE_FEED_SUMMARY, constantTime,
+                      loft->settings->dialect.feedWord, plannedTime);
+    }
+}
+
+
+// Function name: RunLoft()
+// Purpose: Cuts the wing whose stations are listed in the folder's
+//          STATIONS file, every bay at once on settings->totalThreads
+//          threads (0 = one per processor). With "combined" set, all bays
+//          go into one OUTPUT.txt, which is only written if every bay
+//          rendered. Returns EXIT_FAILURE if any station or bay failed.
+//
+int RunLoft(const char *directory, const Settings *settings, int combined)
+{
+    Loft loft;
+    Job noJob;
+    int thisStation;
+    int thisBay;
+    int completed = 0;
+    int result;
+
+    memset(&loft, 0, sizeof(Loft));
+    loft.directory = directory;
+    loft.settings = settings;
+    loft.combined = combined;
+    InitializeJob(&noJob, directory, settings);
+
+    // Every station is read once, all at the same time
+    result = ReadStations(&loft, &noJob);
+    if (result == EXIT_SUCCESS)
+    {
+        PoolRun(LoadStationTask, &loft, loft.totalStations, settings->totalThreads);
+        for (thisStation = 0; thisStation < loft.totalStations; thisStation++)
+        {
+            if (loft.station[thisStation].result != EXIT_SUCCESS)
+            {
+                result = EXIT_FAILURE;
+            }
+        }
+    }
+    if (result == EXIT_SUCCESS && PlanBays(&loft) != EXIT_SUCCESS)
+    {
+        ReportMessage(&noJob, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+        result = EXIT_FAILURE;
+    }
+
+    // Then every bay, borrowing the stations on either side of it
+    if (result == EXIT_SUCCESS)
+    {
+        PoolRun(RenderBayTask, &loft, loft.totalBays, settings->totalThreads);
+        for (thisBay = 0; thisBay < loft.totalBays; thisBay++)
+        {
+            if (loft.bay[thisBay].result == EXIT_SUCCESS)
+            {
+                completed++;
+            }
+        }
+        if (completed == loft.totalBays && combined)
+        {
+            if (WriteCombined(&loft, &noJob) != EXIT_SUCCESS)
+            {
+                completed = 0;
+            }
+        }
+        ReportLoftFeeds(&loft, &noJob, completed);
+        printf(MESSAGE_LOFT_SUMMARY, completed, loft.totalBays);
+        if (completed != loft.totalBays)
+        {
+            result = EXIT_FAILURE;
+        }
+    }
+
+    for (thisBay = 0; thisBay < loft.totalBays; thisBay++)
+    {
+        free(loft.bay[thisBay].half[Upper].text);
+        free(loft.bay[thisBay].half[Lower].text);
+    }
+    for (thisStation = 0; thisStation < loft.totalStations; thisStation++)
+    {
+        FreeMemory(&loft.station[thisStation].job);
+    }
+    free(loft.bay);
+    free(loft.station);
+
+    return(result);
+}
+
+
+// --- End of loft.c
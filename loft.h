@@ -0,0 +1,46 @@
+// loft.h
+//
+// Lofting: a wing of several spanwise stations, cut as one bay between
+// each pair of neighbouring stations (see loft.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef LOFT_H          // Don't define everything more than once
+#define LOFT_H          //
+
+#include "gcode.h"
+
+
+#define STATIONS_FILENAME "STATIONS"    // Lists a loft's stations, root to tip
+#define STATIONS_COMMENT '#'            // Lines starting with this are comments
+#define STATIONS_INTERPOLATE "interpolate" // Adds stations between two others
+#define LOFT_NAME_MAX 64                // Longest station name, plus one
+#define LOFT_OUTPUT_MAX 32              // Longest bay output filename, plus one
+
+
+// Function prototypes
+int RunLoft(const char *directory, const Settings *settings, int combined);
+
+
+#endif
+// --- End of loft.h
@@ -0,0 +1,301 @@
+// main.c
+//
+// The gcode command: parses the command line and runs the jobs it asks
+// for through the library (see gcode.c and libgcode.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// (See gcode.c for project revision history)
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcode.h"
+#include "batch.h"
+#include "cache.h"
+#include "compress.h"
+#include "loft.h"
+#include "watch.h"
+#include "section.h"
+#include "server.h"
+#include "verify.h"
+#include "pool.h"
+
+
+////////// MAIN PROGRAM BLOCK //////////
+int main (int argc, const char *argv[])
+{
+    Settings settings;              // Options that apply to every job
+    Job job;                        // The single job run when not in batch mode
+    const char *batchPath = NULL;   // Manifest or directory given by --batch
+    const char *profilePath = NULL; // Machine profile given by --profile
+    const char *serverPath = NULL;  // Socket given by --serve
+    int maxInFlight = 0;            // Limit given by --max-in-flight
+    int cacheStats = 0;             // Nonzero for --cache-stats
+    int watching = 0;               // Nonzero for --watch
+    const char *loftPath = NULL;    // Wing folder given by --loft
+    int combine = 0;                // Nonzero for --combine
+    const char *verifyPath = NULL;  // Program given by --verify
+    int compactDecimals = -1;       // Decimals given by --compact, if any
+    char error[DIALECT_ERROR_MAX];  // What was wrong with the profile
+    int result;
+    int pack = 0;                   // Nonzero for --pack
+    int unpack = 0;                 // Nonzero for --unpack
+    int option;
+    int thisArgument;
+
+    // Parse the command line
+    InitializeSettings(&settings);
+    for (thisArgument = 1; thisArgument < argc; thisArgument++)
+    {
+        // Options that change how each job is made are shared with the
+        // server (see ParseJobOption())
+        option = ParseJobOption(&settings, argc, argv, &thisArgument);
+        if (option < 0)
+        {
+            fprintf(stderr, MESSAGE_ERROR);
+            fprintf(stderr, MESSAGE_TRANSFORM_ERROR, argv[thisArgument]);
+            return(EXIT_FAILURE);
+        }
+        else if (option > 0)
+        {
+            continue;
+        }
+
+        if (strcmp(argv[thisArgument], "--batch") == 0 && thisArgument + 1 < argc)
+        {
+            batchPath = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--jobs") == 0 && thisArgument + 1 < argc)
+        {
+            settings.totalThreads = atoi(argv[++thisArgument]);
+        }
+        else if (strcmp(argv[thisArgument], "--serve") == 0 && thisArgument + 1 < argc)
+        {
+            serverPath = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--max-in-flight") == 0 && thisArgument + 1 < argc &&
+                 atoi(argv[thisArgument + 1]) > 0)
+        {
+            maxInFlight = atoi(argv[++thisArgument]);
+        }
+        else if (strcmp(argv[thisArgument], "--cache") == 0 && thisArgument + 1 < argc)
+        {
+            settings.cacheDirectory = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--cache-limit") == 0 && thisArgument + 1 < argc &&
+                 atoi(argv[thisArgument + 1]) > 0)
+        {
+            settings.cacheLimit = atoi(argv[++thisArgument]) * 1024LL * 1024LL;
+        }
+        else if (strcmp(argv[thisArgument], "--cache-stats") == 0)
+        {
+            cacheStats = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--compress") == 0 && thisArgument + 1 < argc)
+        {
+            thisArgument++;
+            if (ParseCompression(argv[thisArgument], &settings.compression,
+                                 &settings.compressionLevel) != EXIT_SUCCESS ||
+                !IsCompressionAvailable(settings.compression))
+            {
+                fprintf(stderr, MESSAGE_ERROR);
+                fprintf(stderr, MESSAGE_COMPRESS_ERROR, argv[thisArgument]);
+                return(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[thisArgument], "--watch") == 0)
+        {
+            watching = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--loft") == 0 && thisArgument + 1 < argc)
+        {
+            loftPath = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--combine") == 0)
+        {
+            combine = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--verify") == 0 && thisArgument + 1 < argc)
+        {
+            verifyPath = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--compact") == 0 && thisArgument + 1 < argc &&
+                 atoi(argv[thisArgument + 1]) >= 0 &&
+                 atoi(argv[thisArgument + 1]) <= DIALECT_DECIMALS_MAX)
+        {
+            compactDecimals = atoi(argv[++thisArgument]);
+        }
+        else if (strcmp(argv[thisArgument], "--stream") == 0)
+        {
+            settings.streaming = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--profile") == 0 && thisArgument + 1 < argc)
+        {
+            profilePath = argv[++thisArgument];
+        }
+        else if (strcmp(argv[thisArgument], "--stats") == 0)
+        {
+            settings.statsFormat = StatsTable;
+        }
+        else if (strcmp(argv[thisArgument], "--stats-json") == 0)
+        {
+            settings.statsFormat = StatsJson;
+        }
+        else if (strcmp(argv[thisArgument], "--pack") == 0)
+        {
+            pack = 1;
+        }
+        else if (strcmp(argv[thisArgument], "--unpack") == 0)
+        {
+            unpack = 1;
+        }
+        else
+        {
+            // Unknown option...
+            fprintf(stderr, MESSAGE_USAGE, argv[0]);
+            // Exit
+            return(EXIT_FAILURE);
+        }
+    }
+
+    // Arcs are part of reducing, and reducing and resampling need every
+    // point at once
+    if (settings.fitArcs && !settings.reducing)
+    {
+        fprintf(stderr, MESSAGE_USAGE, argv[0]);
+        return(EXIT_FAILURE);
+    }
+    if (settings.reducing && settings.streaming)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_REDUCE_STREAMERROR);
+        return(EXIT_FAILURE);
+    }
+    if (settings.resampleTotal > 0 && settings.streaming)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_RESAMPLE_STREAMERROR);
+        return(EXIT_FAILURE);
+    }
+    if (watching && settings.streaming)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_WATCH_STREAMERROR);
+        return(EXIT_FAILURE);
+    }
+    if (loftPath != NULL && settings.streaming)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_LOFT_STREAMERROR);
+        return(EXIT_FAILURE);
+    }
+    if (combine && loftPath == NULL)
+    {
+        fprintf(stderr, MESSAGE_USAGE, argv[0]);
+        return(EXIT_FAILURE);
+    }
+
+    // The cache can report on itself without running a job
+    if (cacheStats)
+    {
+        if (settings.cacheDirectory == NULL)
+        {
+            fprintf(stderr, MESSAGE_USAGE, argv[0]);
+            return(EXIT_FAILURE);
+        }
+        return(ReportCache(settings.cacheDirectory, settings.cacheLimit));
+    }
+    if (settings.cacheDirectory != NULL && PrepareCache(settings.cacheDirectory) != EXIT_SUCCESS)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    // The machine profile is compiled once and shared by every job
+    if (CompileDialect(&settings.dialect, profilePath, error) != EXIT_SUCCESS)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_PROFILE_ERROR, profilePath, error);
+        FreeDialect(&settings.dialect);
+        return(EXIT_FAILURE);
+    }
+    // --compact overrides the profile's "compact" setting
+    if (compactDecimals >= 0)
+    {
+        settings.dialect.compactDecimals = compactDecimals;
+    }
+
+    // Verifying reads a finished program back instead of making one
+    if (verifyPath != NULL)
+    {
+        result = RunVerify(verifyPath, &settings);
+    }
+    // Server mode runs jobs sent over a socket until it is stopped
+    else if (serverPath != NULL)
+    {
+        result = RunServer(serverPath, &settings, maxInFlight);
+    }
+    // Batch mode runs many jobs, each in its own folder
+    else if (batchPath != NULL)
+    {
+        result = RunBatch(batchPath, &settings);
+    }
+    // Loft mode cuts a wing of several stations, one bay at a time
+    else if (loftPath != NULL)
+    {
+        result = RunLoft(loftPath, &settings, combine);
+    }
+    // Watch mode keeps the job in the current working directory up to date
+    else if (watching)
+    {
+        result = RunWatch(NULL, &settings);
+    }
+    else
+    {
+        // Otherwise work on a single job in the current working directory
+        InitializeJob(&job, NULL, &settings);
+        if (pack)
+        {
+            result = PackSection(&job);
+        }
+        else if (unpack)
+        {
+            result = UnpackSection(&job);
+        }
+        else
+        {
+            job.threads = (settings.totalThreads > 0) ? settings.totalThreads :
+                                                             PoolDefaultThreads();
+            result = RunJob(&job);
+        }
+    }
+
+    FreeDialect(&settings.dialect);
+    return(result);
+}
+////////////////////////////////////////
+
+
+// --- End of main.c
@@ -0,0 +1,521 @@
+// parse.c
+//
+// Reads the integers and floats of the vector input files without going
+// through fscanf()
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// The file is read in large blocks and each number is converted straight
+// out of the block, its digits eight at a time where there are eight in a
+// row. Ordinary decimal numbers (up to 19 significant digits and a power of
+// ten within 10^22) are converted with one double multiply, by the power of
+// ten or its reciprocal. The mantissa (if it is longer than 2^53), the
+// reciprocal and the product are each rounded once, so the double is within
+// a few units in its last place of the exact value: far closer than a float
+// can tell apart, unless it is that close to halfway between two floats.
+// That rare case, and anything unusual (hex floats, "inf", "nan", very long
+// numbers), is handed to strtof() so the results always match what
+// fscanf("%f") used to give.
+// A compressed file is recognised from its first block and decompressed
+// into the buffer a block at a time (see compress.c).
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <float.h>
+
+#include "parse.h"
+
+
+// Powers of ten, exact in a double
+static const double PowerOfTen[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define POWER_OF_TEN_MAX 22
+
+// Their reciprocals, each as close as a double can be
+static const double InversePowerOfTen[] =
+{
+    1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9, 1e-10, 1e-11,
+    1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18, 1e-19, 1e-20, 1e-21, 1e-22
+};
+
+#define MANTISSA_DIGITS_MAX 19              // Digits that fit in 64 bits
+#define MIDPOINT_MARGIN 4                   // Units in the last place a converted
+                                            //   double is trusted to
+#define EXPONENT_MAX 100000                 // Exponents are clamped to this
+
+#define IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+#define IS_LETTER(c) (((c) | 0x20) >= 'a' && ((c) | 0x20) <= 'z')
+
+
+// Function name: OpenNumberReader()
+// Purpose: Prepares a reader for a file that has just been opened, using
+//          "buffer" (PARSE_BUFFER_SIZE bytes) as its block buffer, or
+//          allocating one if it is NULL. Returns EXIT_FAILURE if the block
+//          buffer can't be allocated.
+//
+int OpenNumberReader(NumberReader *reader, FILE *file, char *buffer)
+{
+    memset(reader, 0, sizeof(NumberReader));
+    reader->file = file;
+    reader->line = 1;
+    reader->column = 1;
+    reader->buffer = buffer;
+    if (buffer == NULL)
+    {
+        reader->buffer = (char *)malloc(PARSE_BUFFER_SIZE);
+        reader->ownsBuffer = 1;
+    }
+
+    return((reader->buffer == NULL) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+// Function name: CloseNumberReader()
+// Purpose: Releases the block buffer, if it was allocated by
+//          OpenNumberReader(). The file itself is left open.
+//
+void CloseNumberReader(NumberReader *reader)
+{
+    CloseDecompressor(reader->decompressor);
+    reader->decompressor = NULL;
+    if (reader->ownsBuffer)
+    {
+        free(reader->buffer);
+    }
+    reader->buffer = NULL;
+}
+
+
+// Function name: RefillNumberReader()
+// Purpose: Moves the unparsed bytes to the front of the buffer and fills the
+//          rest of it from the file, decompressing it if it turns out to
+//          be compressed.
+//
+static void RefillNumberReader(NumberReader *reader)
+{
+    size_t remaining;
+    size_t result;
+    int firstBlock = (reader->totalRead == 0 && reader->length == 0);
+
+    if (reader->endOfFile || reader->buffer == NULL)
+    {
+        return;
+    }
+
+    remaining = reader->length - reader->position;
+    memmove(reader->buffer, reader->buffer + reader->position, remaining);
+    reader->position = 0;
+    reader->length = remaining;
+
+    if (reader->decompressor != NULL)
+    {
+        result = Decompress(reader->decompressor, reader->buffer + reader->length,
+                            PARSE_BUFFER_SIZE - reader->length);
+        reader->length += result;
+        reader->totalRead = reader->decompressor->totalRead;
+        reader->damaged = reader->decompressor->damaged;
+    }
+    else
+    {
+        result = fread(reader->buffer + reader->length, 1,
+                       PARSE_BUFFER_SIZE - reader->length, reader->file);
+        reader->length += result;
+        reader->totalRead += result;
+    }
+
+    if (firstBlock)
+    {
+        reader->compression = DetectCompression(reader->buffer, reader->length);
+        if (reader->compression != CompressionNone)
+        {
+            // Start over, with what was read as the first compressed block
+            reader->decompressor = OpenDecompressor(reader->file, reader->compression,
+                                                    reader->buffer, reader->length);
+            reader->length = 0;
+            if (reader->decompressor == NULL)
+            {
+                reader->damaged = 1;
+                reader->endOfFile = 1;
+                return;
+            }
+            RefillNumberReader(reader);
+            return;
+        }
+    }
+
+    // fread() only comes up short at the end of the file (or on an error)
+    if (reader->length < PARSE_BUFFER_SIZE)
+    {
+        reader->endOfFile = 1;
+    }
+}
+
+
+// Function name: SkipWhitespace()
+// Purpose: Steps over whitespace, keeping track of the line and column, and
+//          makes sure a whole number (up to PARSE_TOKEN_MAX characters) is
+//          in the buffer. Returns 0 if the end of the file was reached.
+//
+static int SkipWhitespace(NumberReader *reader)
+{
+    char thisCharacter;
+
+    for (;;)
+    {
+        if (reader->length - reader->position < PARSE_TOKEN_MAX)
+        {
+            RefillNumberReader(reader);
+            if (reader->position == reader->length)
+            {
+                return(0);
+            }
+        }
+
+        thisCharacter = reader->buffer[reader->position];
+        if (thisCharacter == '\n')
+        {
+            reader->line++;
+            reader->column = 1;
+        }
+        else if (thisCharacter == ' ' || thisCharacter == '\t' || thisCharacter == '\r' ||
+                 thisCharacter == '\v' || thisCharacter == '\f')
+        {
+            reader->column++;
+        }
+        else
+        {
+            return(1);
+        }
+        reader->position++;
+    }
+}
+
+
+// Function name: Advance()
+// Purpose: Steps over a number that has just been converted.
+//
+static void Advance(NumberReader *reader, size_t length)
+{
+    reader->position += length;
+    reader->column += (long)length;
+}
+
+
+// Function name: ReadEightDigits()
+// Purpose: If the eight characters at "cursor" are all digits, puts the
+//          number they make in "value" and returns 1. The eight are checked
+//          and converted together, in three multiplies, rather than one at a
+//          time.
+//
+static int ReadEightDigits(const char *cursor, unsigned long long *value)
+{
+    unsigned long long chunk;
+
+    memcpy(&chunk, cursor, sizeof(chunk));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    chunk = __builtin_bswap64(chunk);
+#endif
+
+    // Every byte from '0' (0x30) to '9' (0x39): its high half is 3, and
+    // still is with 6 added
+    if (((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+         (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) !=
+        0x3333333333333333ULL)
+    {
+        return(0);
+    }
+
+    // Pairs of digits, then fours, then all eight
+    chunk = ((chunk & 0x0F0F0F0F0F0F0F0FULL) * 2561) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+    *value = ((chunk & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+
+    return(1);
+}
+
+
+// Function name: ReadInteger()
+// Purpose: Reads the next number as an int, like fscanf("%d"). Returns
+//          PARSE_OK, PARSE_BAD (the reader is left at the bad input) or
+//          PARSE_EOF.
+//
+int ReadInteger(NumberReader *reader, int *value)
+{
+    const char *start;
+    const char *cursor;
+    const char *end;
+    long long result = 0;
+    int negative = 0;
+
+    if (!SkipWhitespace(reader))
+    {
+        return(PARSE_EOF);
+    }
+
+    start = cursor = reader->buffer + reader->position;
+    end = reader->buffer + reader->length;
+
+    if (*cursor == '+' || *cursor == '-')
+    {
+        negative = (*cursor == '-');
+        cursor++;
+    }
+    if (cursor == end || !IS_DIGIT(*cursor))
+    {
+        return(PARSE_BAD);
+    }
+    while (cursor < end && IS_DIGIT(*cursor))
+    {
+        result = result * 10 + (*cursor - '0');
+        if (result > (long long)INT_MAX + 1)
+        {
+            return(PARSE_BAD);
+        }
+        cursor++;
+    }
+    if (negative)
+    {
+        result = -result;
+    }
+    if (result > INT_MAX || result < INT_MIN)
+    {
+        return(PARSE_BAD);
+    }
+
+    *value = (int)result;
+    Advance(reader, cursor - start);
+
+    return(PARSE_OK);
+}
+
+
+// Function name: ReadFloatSlowly()
+// Purpose: Converts the next number with strtof(), for the inputs the fast
+//          path in ReadFloat() can't handle exactly.
+//
+static int ReadFloatSlowly(NumberReader *reader, float *value)
+{
+    char token[PARSE_TOKEN_MAX + 1];
+    char *tokenEnd;
+    size_t available;
+
+    available = reader->length - reader->position;
+    if (available > PARSE_TOKEN_MAX)
+    {
+        available = PARSE_TOKEN_MAX;
+    }
+    memcpy(token, reader->buffer + reader->position, available);
+    token[available] = '\0';
+
+    *value = strtof(token, &tokenEnd);
+    // Nothing converted, or a number too long to be sure we saw all of it
+    if (tokenEnd == token || (size_t)(tokenEnd - token) == PARSE_TOKEN_MAX)
+    {
+        return(PARSE_BAD);
+    }
+
+    Advance(reader, tokenEnd - token);
+
+    return(PARSE_OK);
+}
+
+
+// Function name: IsFloatMidpoint()
+// Purpose: True if a double lies within "margin" units in its last place of
+//          halfway between two floats, where rounding it to a float might
+//          not give the correctly rounded float of the original decimal
+//          number.
+//
+static int IsFloatMidpoint(double number, unsigned long long margin)
+{
+    unsigned long long bits;
+
+    memcpy(&bits, &number, sizeof(bits));
+
+    // A double has 29 more fraction bits than a float
+    bits &= 0x1FFFFFFFULL;
+    return(bits + margin >= 0x10000000ULL && bits <= 0x10000000ULL + margin);
+}
+
+
+// Function name: ReadFloat()
+// Purpose: Reads the next number as a float, like fscanf("%f"). Returns
+//          PARSE_OK, PARSE_BAD (the reader is left at the bad input) or
+//          PARSE_EOF.
+//
+int ReadFloat(NumberReader *reader, float *value)
+{
+    const char *start;
+    const char *cursor;
+    const char *end;
+    const char *exponentCursor;
+    unsigned long long mantissa = 0;
+    unsigned long long chunk;
+    int mantissaDigits = 0;     // Significant digits held in the mantissa
+    int totalDigits = 0;        // All digits seen before the exponent
+    int exponent = 0;
+    int exponentValue = 0;
+    int exponentNegative = 0;
+    int negative = 0;
+    double result;
+
+    if (!SkipWhitespace(reader))
+    {
+        return(PARSE_EOF);
+    }
+
+    start = cursor = reader->buffer + reader->position;
+    end = reader->buffer + reader->length;
+
+    // Sign
+    if (*cursor == '+' || *cursor == '-')
+    {
+        negative = (*cursor == '-');
+        cursor++;
+    }
+
+    // Integer part. Leading zeros aren't significant digits.
+    while (cursor < end && *cursor == '0')
+    {
+        totalDigits++;
+        cursor++;
+    }
+    while (end - cursor >= 8 && ReadEightDigits(cursor, &chunk))
+    {
+        mantissa = mantissa * 100000000 + chunk;
+        mantissaDigits += 8;
+        cursor += 8;
+    }
+    while (cursor < end && IS_DIGIT(*cursor))
+    {
+        mantissa = mantissa * 10 + (*cursor - '0');
+        mantissaDigits++;
+        cursor++;
+    }
+
+    // Fractional part
+    if (cursor < end && *cursor == '.')
+    {
+        cursor++;
+        if (mantissaDigits == 0)
+        {
+            while (cursor < end && *cursor == '0')
+            {
+                totalDigits++;
+                exponent--;
+                cursor++;
+            }
+        }
+        while (end - cursor >= 8 && ReadEightDigits(cursor, &chunk))
+        {
+            mantissa = mantissa * 100000000 + chunk;
+            mantissaDigits += 8;
+            exponent -= 8;
+            cursor += 8;
+        }
+        while (cursor < end && IS_DIGIT(*cursor))
+        {
+            mantissa = mantissa * 10 + (*cursor - '0');
+            mantissaDigits++;
+            exponent--;
+            cursor++;
+        }
+    }
+    totalDigits += mantissaDigits;
+
+    // More digits than 64 bits can hold (the mantissa has wrapped around)
+    if (mantissaDigits > MANTISSA_DIGITS_MAX)
+    {
+        return(ReadFloatSlowly(reader, value));
+    }
+
+    // A lone sign or point, or something like "inf", "nan" or "0x1p3"
+    if (totalDigits == 0 || (cursor < end && (IS_LETTER(*cursor) && *cursor != 'e' &&
+                                              *cursor != 'E')))
+    {
+        return(ReadFloatSlowly(reader, value));
+    }
+
+    // Exponent, only taken if at least one digit follows the 'e'
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+    {
+        exponentCursor = cursor + 1;
+        if (exponentCursor < end && (*exponentCursor == '+' || *exponentCursor == '-'))
+        {
+            exponentNegative = (*exponentCursor == '-');
+            exponentCursor++;
+        }
+        if (exponentCursor < end && IS_DIGIT(*exponentCursor))
+        {
+            while (exponentCursor < end && IS_DIGIT(*exponentCursor))
+            {
+                if (exponentValue < EXPONENT_MAX)
+                {
+                    exponentValue = exponentValue * 10 + (*exponentCursor - '0');
+                }
+                exponentCursor++;
+            }
+            cursor = exponentCursor;
+            exponent += exponentNegative ? -exponentValue : exponentValue;
+        }
+    }
+
+    // A number running into the end of the buffer is longer than we allow
+    if (cursor == end && !reader->endOfFile)
+    {
+        return(PARSE_BAD);
+    }
+
+    // Convert with a single double operation (see the top of the file)
+    if (mantissa == 0)
+    {
+        result = 0.0;
+    }
+    else if (exponent >= -POWER_OF_TEN_MAX && exponent <= POWER_OF_TEN_MAX)
+    {
+        result = (exponent < 0) ? (double)mantissa * InversePowerOfTen[-exponent] :
+                                  (double)mantissa * PowerOfTen[exponent];
+        if (IsFloatMidpoint(result, MIDPOINT_MARGIN) || result > FLT_MAX)
+        {
+            return(ReadFloatSlowly(reader, value));
+        }
+    }
+    else
+    {
+        return(ReadFloatSlowly(reader, value));
+    }
+
+    *value = (float)(negative ? -result : result);
+    Advance(reader, cursor - start);
+
+    return(PARSE_OK);
+}
+
+
+// --- End of parse.c
@@ -0,0 +1,75 @@
+// parse.h
+//
+// Buffered number parser for the vector input files (see parse.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef PARSE_H         // Don't define everything more than once
+#define PARSE_H         //
+
+#include <stdio.h>
+
+#include "compress.h"
+
+
+// Size of the block read from the input file at a time
+#define PARSE_BUFFER_SIZE (256 * 1024)
+
+// Longest number the parser will accept, in characters
+#define PARSE_TOKEN_MAX 128
+
+// Results of ReadInteger() and ReadFloat(). These are the values fscanf()
+// returns for a single conversion.
+#define PARSE_OK 1                  // A number was read
+#define PARSE_BAD 0                 // The next input is not a number
+#define PARSE_EOF EOF               // There is no more input
+
+
+// Reads whitespace-separated numbers from a file, a large block at a time
+typedef struct
+{
+    FILE *file;             // File being parsed
+    char *buffer;           // Block of the file currently in memory
+    int ownsBuffer;         // Nonzero if the buffer was allocated here
+    size_t position;        // Next unparsed byte in the buffer
+    size_t length;          // Bytes of the file currently in the buffer
+    int endOfFile;          // Nonzero once the whole file has been read
+    long line;              // Line of the next unparsed byte (from 1)
+    long column;            // Column of the next unparsed byte (from 1)
+    long long totalRead;    // Bytes read from the file so far
+    enum Compression compression;   // How the file is compressed, if it is
+    Decompressor *decompressor;     // Decompresses it, if this build can
+    int damaged;            // Nonzero if the file can't be decompressed
+                            //   (the reader then acts as if it had ended)
+} NumberReader;
+
+
+// Function prototypes
+int OpenNumberReader(NumberReader *reader, FILE *file, char *buffer);
+void CloseNumberReader(NumberReader *reader);
+int ReadInteger(NumberReader *reader, int *value);
+int ReadFloat(NumberReader *reader, float *value);
+
+
+#endif
+// --- End of parse.h
@@ -0,0 +1,238 @@
+// pool.c
+//
+// Runs a fixed set of independent tasks on a work-stealing pool of threads
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// Each worker starts with an even share of the task indices. A worker runs
+// its own share from the front; once it runs dry it steals the back half of
+// another worker's remaining share. Tasks of very different sizes (small and
+// large wing sections, say) therefore still keep every core busy.
+//
+
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "pool.h"
+
+
+// The share of task indices currently owned by one worker
+typedef struct
+{
+    pthread_mutex_t lock;   // Guards next and end
+    int next;               // Next index the owner will run
+    int end;                // One past the last index in this share
+} PoolShare;
+
+// State shared by every worker of one PoolRun() call
+typedef struct
+{
+    PoolTask task;
+    void *context;
+    int totalWorkers;
+    PoolShare *share;
+} Pool;
+
+// What each worker thread is started with
+typedef struct
+{
+    Pool *pool;
+    int worker;
+} PoolWorker;
+
+
+// Function name: PoolDefaultThreads()
+// Purpose: Returns the number of processors currently online, which is the
+//          default size of a pool.
+//
+int PoolDefaultThreads()
+{
+    long processors;
+
+    processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return((processors > 0) ? (int)processors : 1);
+}
+
+
+// Function name: PoolTakeTask()
+// Purpose: Finds the next task index for a worker, stealing from another
+//          worker if its own share is empty. Returns 0 when no work is left.
+//
+static int PoolTakeTask(Pool *pool, int worker, int *index)
+{
+    PoolShare *own = &pool->share[worker];
+    PoolShare *victim;
+    int thisVictim;
+    int remaining;
+    int stolen;
+
+    // Try our own share first
+    pthread_mutex_lock(&own->lock);
+    if (own->next < own->end)
+    {
+        *index = own->next++;
+        pthread_mutex_unlock(&own->lock);
+        return(1);
+    }
+    pthread_mutex_unlock(&own->lock);
+
+    // Otherwise steal the back half of the first non-empty share we find
+    for (thisVictim = 1; thisVictim < pool->totalWorkers; thisVictim++)
+    {
+        victim = &pool->share[(worker + thisVictim) % pool->totalWorkers];
+
+        pthread_mutex_lock(&victim->lock);
+        remaining = victim->end - victim->next;
+        if (remaining <= 0)
+        {
+            pthread_mutex_unlock(&victim->lock);
+            continue;
+        }
+        stolen = (remaining + 1) / 2;
+        victim->end -= stolen;
+        *index = victim->end;
+        pthread_mutex_unlock(&victim->lock);
+
+        // Keep the first stolen index and make the rest our new share
+        pthread_mutex_lock(&own->lock);
+        own->next = *index + 1;
+        own->end = *index + stolen;
+        pthread_mutex_unlock(&own->lock);
+        return(1);
+    }
+
+    // Every share is empty. Tasks never create new tasks, so we're done.
+    return(0);
+}
+
+
+// Function name: PoolWork()
+// Purpose: The body of every worker: run tasks until none are left.
+//
+static void *PoolWork(void *argument)
+{
+    PoolWorker *thisWorker = (PoolWorker *)argument;
+    int index;
+
+    while (PoolTakeTask(thisWorker->pool, thisWorker->worker, &index))
+    {
+        thisWorker->pool->task(thisWorker->pool->context, index);
+    }
+
+    return(NULL);
+}
+
+
+// Function name: PoolRun()
+// Purpose: Calls task(context, index) for every index in [0, totalTasks) on
+//          up to totalThreads threads (0 = one per processor), and returns
+//          once all of them have finished. The calling thread takes part in
+//          the work. If a thread can't be started its share is simply
+//          stolen by the others, so every task still runs.
+//
+void PoolRun(PoolTask task, void *context, int totalTasks, int totalThreads)
+{
+    Pool pool;
+    PoolWorker *worker;
+    pthread_t *thread;
+    int *started;
+    int thisWorker;
+
+    if (totalTasks <= 0)
+    {
+        return;
+    }
+    if (totalThreads <= 0)
+    {
+        totalThreads = PoolDefaultThreads();
+    }
+    if (totalThreads > totalTasks)
+    {
+        totalThreads = totalTasks;
+    }
+
+    pool.task = task;
+    pool.context = context;
+    pool.totalWorkers = totalThreads;
+    pool.share = (PoolShare *)malloc(totalThreads * sizeof(PoolShare));
+    worker = (PoolWorker *)malloc(totalThreads * sizeof(PoolWorker));
+    thread = (pthread_t *)malloc(totalThreads * sizeof(pthread_t));
+    started = (int *)calloc(totalThreads, sizeof(int));
+
+    // Without memory for the bookkeeping, just run everything right here
+    if (pool.share == NULL || worker == NULL || thread == NULL || started == NULL)
+    {
+        free(pool.share);
+        free(worker);
+        free(thread);
+        free(started);
+        for (thisWorker = 0; thisWorker < totalTasks; thisWorker++)
+        {
+            task(context, thisWorker);
+        }
+        return;
+    }
+
+    // Hand every worker an even share of the indices
+    for (thisWorker = 0; thisWorker < totalThreads; thisWorker++)
+    {
+        pthread_mutex_init(&pool.share[thisWorker].lock, NULL);
+        pool.share[thisWorker].next =
+          (int)((long long)totalTasks * thisWorker / totalThreads);
+        pool.share[thisWorker].end =
+          (int)((long long)totalTasks * (thisWorker + 1) / totalThreads);
+        worker[thisWorker].pool = &pool;
+        worker[thisWorker].worker = thisWorker;
+    }
+
+    // Start the helpers, then work alongside them as worker 0
+    for (thisWorker = 1; thisWorker < totalThreads; thisWorker++)
+    {
+        started[thisWorker] =
+          (pthread_create(&thread[thisWorker], NULL, PoolWork, &worker[thisWorker]) == 0);
+    }
+    PoolWork(&worker[0]);
+
+    // Wait for the helpers to finish
+    for (thisWorker = 1; thisWorker < totalThreads; thisWorker++)
+    {
+        if (started[thisWorker])
+        {
+            pthread_join(thread[thisWorker], NULL);
+        }
+    }
+
+    for (thisWorker = 0; thisWorker < totalThreads; thisWorker++)
+    {
+        pthread_mutex_destroy(&pool.share[thisWorker].lock);
+    }
+    free(pool.share);
+    free(worker);
+    free(thread);
+    free(started);
+}
+
+
+// --- End of pool.c
@@ -0,0 +1,43 @@
+// pool.h
+//
+// Work-stealing thread pool used to run many independent tasks at once
+// (see pool.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef POOL_H          // Don't define everything more than once
+#define POOL_H          //
+
+
+// A task is called once for every index from 0 to totalTasks - 1. The
+// context pointer is passed through unchanged.
+typedef void (*PoolTask)(void *context, int index);
+
+
+// Function prototypes
+int PoolDefaultThreads();
+void PoolRun(PoolTask task, void *context, int totalTasks, int totalThreads);
+
+
+#endif
+// --- End of pool.h
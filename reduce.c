@@ -0,0 +1,668 @@
+// reduce.c
+//
+// Reduces the tool path of an airfoil half to fewer, longer moves:
+// collinear runs are merged, the rest is simplified to within a tolerance,
+// and arcs can be fitted where they save more
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// Each data point of a half is treated as one 4-axis point (X, Y, U, V),
+// and distances are measured in those four dimensions. A point within the
+// tolerance of a move is then within the tolerance at the root and at the
+// tip at the same moment of the move, so the wire is never skewed by more
+// than the tolerance either.
+//
+// The stages, in order:
+//
+//   1. Points that lie on the straight line between their neighbours are
+//      dropped (one pass).
+//   2. Optionally, runs of points that the root follows around an arc are
+//      replaced by G2/G3 moves. The controller moves U and V in a straight
+//      line during an arc, so a run only qualifies if the tip stays within
+//      the tolerance of that line as well. Each arc is grown by doubling
+//      and then binary search, so fitting costs O(n log n).
+//   3. The remaining points are simplified with Douglas-Peucker. A range is
+//      split at its furthest point only if that point is in the middle half
+//      of the range, and at the middle otherwise, so the recursion is never
+//      more than O(log n) deep and the whole stage is O(n log n).
+//
+// Finally every data point is measured against the move that replaced it,
+// which gives the maximum deviation that is reported.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "reduce.h"
+
+
+// Points are collinear if they are this close to the line, relative to
+// its length
+#define COLLINEAR_TOLERANCE 1e-6
+
+// Arcs must replace at least this many data points (start and end included)
+#define ARC_MIN_POINTS 5
+
+// Arcs may not turn through more than half a circle
+#define ARC_MAX_SWEEP 3.14159265358979323846
+
+// Largest angle (radians) allowed between an arc and the data on either
+// side of it, so that arcs join the rest of the path without a kink
+#define ARC_TANGENT_LIMIT 0.05
+
+#define TWO_PI (2.0 * 3.14159265358979323846)
+
+// Simplification ranges waiting to be checked. Balanced splits keep the
+// recursion far shallower than this (about 2 * log4/3(n) entries).
+#define SIMPLIFY_STACK_DEPTH 256
+
+// What becomes of each data point
+#define POINT_DROPPED 0     // Replaced by a longer move
+#define POINT_KEPT 1        // A move ends here (so far)
+#define POINT_ANCHORED 2    // A move must end here (ends of the half and arcs)
+
+
+// An arc fitted to the root (X/Y) points "start" to "end"
+typedef struct
+{
+    int start;              // Data points at either end of the arc
+    int end;                //
+    enum MoveType type;     // ClockwiseArc or CounterclockwiseArc
+    double centerX;         // Center and radius
+    double centerY;         //
+    double radius;          //
+    double startAngle;      // Angle of the start point from the center
+    double sweep;           // Angle turned through, always positive
+} Arc;
+
+
+// Function name: LineDeviation()
+// Purpose: Returns how far point "k" is from the straight 4-axis move
+//          between points "a" and "b".
+//
+static double LineDeviation(const float *const point[4], int a, int b, int k)
+{
+    double direction[4];
+    double offset[4];
+    double length = 0.0;
+    double along = 0.0;
+    double distance = 0.0;
+    double error;
+    int thisAxis;
+
+    for (thisAxis = 0; thisAxis < 4; thisAxis++)
+    {
+        direction[thisAxis] = (double)point[thisAxis][b] - point[thisAxis][a];
+        offset[thisAxis] = (double)point[thisAxis][k] - point[thisAxis][a];
+        length += direction[thisAxis] * direction[thisAxis];
+        along += offset[thisAxis] * direction[thisAxis];
+    }
+
+    // Nearest point of the move, as a fraction of the way along it
+    along = (length > 0.0) ? along / length : 0.0;
+    if (along < 0.0)
+    {
+        along = 0.0;
+    }
+    else if (along > 1.0)
+    {
+        along = 1.0;
+    }
+
+    for (thisAxis = 0; thisAxis < 4; thisAxis++)
+    {
+        error = offset[thisAxis] - along * direction[thisAxis];
+        distance += error * error;
+    }
+
+    return(sqrt(distance));
+}
+
+
+// Function name: LineLength()
+// Purpose: Returns the 4-axis distance between points "a" and "b".
+//
+static double LineLength(const float *const point[4], int a, int b)
+{
+    double difference;
+    double length = 0.0;
+    int thisAxis;
+
+    for (thisAxis = 0; thisAxis < 4; thisAxis++)
+    {
+        difference = (double)point[thisAxis][b] - point[thisAxis][a];
+        length += difference * difference;
+    }
+
+    return(sqrt(length));
+}
+
+
+// Function name: ArcAngle()
+// Purpose: Returns how far around an arc (in radians, from 0 to 2 pi) the
+//          root of point "k" is, in the arc's direction.
+//
+static double ArcAngle(const float *const point[4], const Arc *arc, int k)
+{
+    double angle;
+
+    angle = atan2(point[1][k] - arc->centerY, point[0][k] - arc->centerX) - arc->startAngle;
+    if (arc->type == ClockwiseArc)
+    {
+        angle = -angle;
+    }
+    angle = fmod(angle, TWO_PI);
+
+    return((angle < 0.0) ? angle + TWO_PI : angle);
+}
+
+
+// Function name: ArcDeviation()
+// Purpose: Returns how far point "k" is from where the wire is when the
+//          root has turned through "angle" of the arc: on the arc at the
+//          root, and on the straight line between the arc's end points at
+//          the tip.
+//
+static double ArcDeviation(const float *const point[4], const Arc *arc, int k, double angle)
+{
+    double along = angle / arc->sweep;
+    double rootError;
+    double tipErrorU;
+    double tipErrorV;
+
+    rootError = hypot(point[0][k] - arc->centerX, point[1][k] - arc->centerY) - arc->radius;
+    tipErrorU = point[2][k] -
+      (point[2][arc->start] + along * ((double)point[2][arc->end] - point[2][arc->start]));
+    tipErrorV = point[3][k] -
+      (point[3][arc->start] + along * ((double)point[3][arc->end] - point[3][arc->start]));
+
+    return(sqrt(rootError * rootError + tipErrorU * tipErrorU + tipErrorV * tipErrorV));
+}
+
+
+// Function name: MeetsTangent()
+// Purpose: True if the root line from point "a" to point "b" runs within
+//          ARC_TANGENT_LIMIT of the direction (tangentX, tangentY). A line
+//          of no length has no direction, and always passes.
+//
+static int MeetsTangent(const float *const point[4], int a, int b,
+                        double tangentX, double tangentY)
+{
+    double lineX = (double)point[0][b] - point[0][a];
+    double lineY = (double)point[1][b] - point[1][a];
+
+    if (lineX == 0.0 && lineY == 0.0)
+    {
+        return(1);
+    }
+
+    return(fabs(atan2(tangentX * lineY - tangentY * lineX,
+                      tangentX * lineX + tangentY * lineY)) <= ARC_TANGENT_LIMIT);
+}
+
+
+// Function name: ArcSagitta()
+// Purpose: Returns how far the middle of an arc is from the straight line
+//          between its ends. Within the tolerance, the line does as well.
+//
+static double ArcSagitta(const float *const point[4], const Arc *arc)
+{
+    double chord;
+
+    chord = hypot((double)point[0][arc->end] - point[0][arc->start],
+                  (double)point[1][arc->end] - point[1][arc->start]);
+
+    return(arc->radius - sqrt(fmax(0.0, arc->radius * arc->radius - chord * chord / 4.0)));
+}
+
+
+// Function name: FitArc()
+// Purpose: Tries to replace points "start" to "end" with one arc, through
+//          the root of the start, middle and end points. Returns 1 and fills
+//          in "arc" if every point in between is within the tolerance.
+//
+static int FitArc(const float *const point[4], int totalPoints, int start, int end,
+                  double tolerance, Arc *arc)
+{
+    double middleX, middleY;
+    double endX, endY;
+    double middleLength, endLength;
+    double determinant;
+    double centerX, centerY;
+    double angle;
+    double lastAngle = 0.0;
+    double sign;
+    int thisPoint;
+
+    // Center of the circle through the three points, relative to the start
+    middleX = (double)point[0][(start + end) / 2] - point[0][start];
+    middleY = (double)point[1][(start + end) / 2] - point[1][start];
+    endX = (double)point[0][end] - point[0][start];
+    endY = (double)point[1][end] - point[1][start];
+    determinant = 2.0 * (middleX * endY - middleY * endX);
+    if (determinant == 0.0)
+    {
+        return(0);
+    }
+    middleLength = middleX * middleX + middleY * middleY;
+    endLength = endX * endX + endY * endY;
+    centerX = (endY * middleLength - middleY * endLength) / determinant;
+    centerY = (middleX * endLength - endX * middleLength) / determinant;
+
+    arc->start = start;
+    arc->end = end;
+    arc->type = (determinant > 0.0) ? CounterclockwiseArc : ClockwiseArc;
+    arc->centerX = point[0][start] + centerX;
+    arc->centerY = point[1][start] + centerY;
+    arc->radius = hypot(centerX, centerY);
+    arc->startAngle = atan2(-centerY, -centerX);
+    arc->sweep = ArcAngle(point, arc, end);
+    if (arc->sweep <= 0.0 || arc->sweep > ARC_MAX_SWEEP)
+    {
+        return(0);
+    }
+
+    // The arc must meet the data on either side of it without a kink
+    sign = (arc->type == CounterclockwiseArc) ? 1.0 : -1.0;
+    if (start > 0 &&
+        !MeetsTangent(point, start - 1, start, sign * centerY, -sign * centerX))
+    {
+        return(0);
+    }
+    if (end < totalPoints - 1 &&
+        !MeetsTangent(point, end, end + 1, -sign * (endY - centerY), sign * (endX - centerX)))
+    {
+        return(0);
+    }
+
+    // Every point must come in order around the arc, and be close to it
+    for (thisPoint = start + 1; thisPoint < end; thisPoint++)
+    {
+        angle = ArcAngle(point, arc, thisPoint);
+        if (angle < lastAngle || angle > arc->sweep ||
+            ArcDeviation(point, arc, thisPoint, angle) > tolerance)
+        {
+            return(0);
+        }
+        lastAngle = angle;
+    }
+
+    return(1);
+}
+
+
+// Function name: FitArcs()
+// Purpose: Finds runs of points that can be replaced by arcs, from the
+//          start of the half to the end, and lists them in "arcs" (which
+//          the caller frees). Returns EXIT_FAILURE if memory runs out.
+//
+static int FitArcs(const float *const point[4], int totalPoints, double tolerance,
+                   Arc **arcs, int *totalArcs)
+{
+    Arc fitted;
+    Arc best;
+    Arc *grown;
+    int allocatedArcs = 0;
+    int start = 0;
+    int good;
+    int bad;
+    int step;
+    int trial;
+
+    *arcs = NULL;
+    *totalArcs = 0;
+
+    while (start + ARC_MIN_POINTS - 1 < totalPoints)
+    {
+        // The shortest arc worth having
+        if (!FitArc(point, totalPoints, start, start + ARC_MIN_POINTS - 1, tolerance, &best))
+        {
+            start++;
+            continue;
+        }
+
+        // Keep doubling it until it no longer fits...
+        good = start + ARC_MIN_POINTS - 1;
+        bad = totalPoints;
+        for (step = ARC_MIN_POINTS - 1; good + step < totalPoints; step *= 2)
+        {
+            if (!FitArc(point, totalPoints, start, good + step, tolerance, &fitted))
+            {
+                bad = good + step;
+                break;
+            }
+            good += step;
+            best = fitted;
+        }
+
+        // ...then find where it stops fitting
+        while (bad - good > 1)
+        {
+            trial = good + (bad - good) / 2;
+            if (FitArc(point, totalPoints, start, trial, tolerance, &fitted))
+            {
+                good = trial;
+                best = fitted;
+            }
+            else
+            {
+                bad = trial;
+            }
+        }
+
+        // The next arc may start where this one ends. An arc that a
+        // straight line would follow just as closely isn't worth having.
+        start = good;
+        if (ArcSagitta(point, &best) <= tolerance)
+        {
+            continue;
+        }
+
+        if (*totalArcs == allocatedArcs)
+        {
+            allocatedArcs = allocatedArcs ? allocatedArcs * 2 : 64;
+            grown = (Arc *)realloc(*arcs, allocatedArcs * sizeof(Arc));
+            if (grown == NULL)
+            {
+                return(EXIT_FAILURE);
+            }
+            *arcs = grown;
+        }
+        (*arcs)[(*totalArcs)++] = best;
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: MergeCollinear()
+// Purpose: Drops every point that lies on the straight line from the last
+//          point kept to the point after it.
+//
+static void MergeCollinear(const float *const point[4], int totalPoints, char *status)
+{
+    int anchor = 0;
+    int thisPoint;
+
+    for (thisPoint = 1; thisPoint < totalPoints - 1; thisPoint++)
+    {
+        if (LineDeviation(point, anchor, thisPoint + 1, thisPoint) <=
+            COLLINEAR_TOLERANCE * LineLength(point, anchor, thisPoint + 1))
+        {
+            status[thisPoint] = POINT_DROPPED;
+        }
+        else
+        {
+            anchor = thisPoint;
+        }
+    }
+}
+
+
+// Function name: Simplify()
+// Purpose: Douglas-Peucker simplification of the candidate points
+//          candidate[first] to candidate[last], whose ends are kept.
+//          Points that aren't needed to stay within the tolerance are
+//          dropped.
+//
+static void Simplify(const float *const point[4], const int *candidate, int first, int last,
+                     double tolerance, char *status)
+{
+    int stack[2 * SIMPLIFY_STACK_DEPTH];
+    int depth = 0;
+    int low;
+    int high;
+    int split;
+    int quarter;
+    int thisCandidate;
+    double deviation;
+    double furthest;
+
+    stack[depth++] = first;
+    stack[depth++] = last;
+    while (depth > 0)
+    {
+        high = stack[--depth];
+        low = stack[--depth];
+        if (high - low < 2)
+        {
+            continue;
+        }
+
+        // Find the candidate furthest from the line between the ends
+        furthest = -1.0;
+        split = low + 1;
+        for (thisCandidate = low + 1; thisCandidate < high; thisCandidate++)
+        {
+            deviation = LineDeviation(point, candidate[low], candidate[high],
+                                      candidate[thisCandidate]);
+            if (deviation > furthest)
+            {
+                furthest = deviation;
+                split = thisCandidate;
+            }
+        }
+
+        // Close enough: the line replaces everything in between
+        if (furthest <= tolerance)
+        {
+            for (thisCandidate = low + 1; thisCandidate < high; thisCandidate++)
+            {
+                status[candidate[thisCandidate]] = POINT_DROPPED;
+            }
+            continue;
+        }
+
+        // Otherwise keep a point and look at both sides of it
+        quarter = (high - low) / 4;
+        if (split < low + quarter || split > high - quarter)
+        {
+            split = low + (high - low) / 2;
+        }
+        stack[depth++] = low;
+        stack[depth++] = split;
+        stack[depth++] = split;
+        stack[depth++] = high;
+    }
+}
+
+
+// Function name: BuildMoves()
+// Purpose: Turns the points that are left into the moves of the path, and
+//          measures each data point against the move that replaced it.
+//          Returns EXIT_FAILURE if memory runs out.
+//
+static int BuildMoves(const float *const point[4], int totalPoints, const char *status,
+                      const Arc *arcs, int totalArcs, ToolPath *path)
+{
+    Move *thisMove;
+    int totalMoves = 0;
+    int thisArc = 0;
+    int thisPoint;
+    int previous = 0;
+    int replaced;
+
+    for (thisPoint = 0; thisPoint < totalPoints; thisPoint++)
+    {
+        totalMoves += (status[thisPoint] != POINT_DROPPED);
+    }
+    path->move = (Move *)calloc(totalMoves, sizeof(Move));
+    if (path->move == NULL)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    // The first move goes straight to the first point
+    path->move[path->totalMoves++].type = LineMove;
+
+    for (thisPoint = 1; thisPoint < totalPoints; thisPoint++)
+    {
+        if (status[thisPoint] == POINT_DROPPED)
+        {
+            continue;
+        }
+
+        thisMove = &path->move[path->totalMoves++];
+        thisMove->index = thisPoint;
+        if (thisArc < totalArcs && arcs[thisArc].start == previous &&
+            arcs[thisArc].end == thisPoint)
+        {
+            thisMove->type = arcs[thisArc].type;
+            thisMove->centerI = (float)(arcs[thisArc].centerX - point[0][previous]);
+            thisMove->centerJ = (float)(arcs[thisArc].centerY - point[1][previous]);
+            for (replaced = previous + 1; replaced < thisPoint; replaced++)
+            {
+                path->maxDeviation = fmax(path->maxDeviation,
+                  ArcDeviation(point, &arcs[thisArc], replaced,
+                               ArcAngle(point, &arcs[thisArc], replaced)));
+            }
+            path->totalArcs++;
+            thisArc++;
+        }
+        else
+        {
+            thisMove->type = LineMove;
+            for (replaced = previous + 1; replaced < thisPoint; replaced++)
+            {
+                path->maxDeviation = fmax(path->maxDeviation,
+                  LineDeviation(point, previous, thisPoint, replaced));
+            }
+        }
+        previous = thisPoint;
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ReducePath()
+// Purpose: Reduces the "totalPoints" 4-axis points of one airfoil half
+//          (point[0] to point[3] hold the root X, root Y, tip X and tip Y
+//          values) to a tool path whose moves pass within "tolerance" of
+//          every point. Arcs are only used if "fitArcs" is nonzero.
+//          Returns EXIT_FAILURE if memory runs out.
+//
+int ReducePath(const float *const point[4], int totalPoints, double tolerance,
+               int fitArcs, ToolPath *path)
+{
+    char *status;
+    int *candidate;
+    Arc *arcs = NULL;
+    int totalArcs = 0;
+    int totalCandidates = 0;
+    int thisArc;
+    int thisPoint;
+    int thisCandidate;
+    int anchor;
+    int result;
+
+    memset(path, 0, sizeof(ToolPath));
+    path->totalPoints = totalPoints;
+    if (totalPoints <= 0)
+    {
+        return(EXIT_SUCCESS);
+    }
+
+    status = (char *)malloc(totalPoints);
+    candidate = (int *)malloc(totalPoints * sizeof(int));
+    result = (status == NULL || candidate == NULL) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+    if (result == EXIT_SUCCESS)
+    {
+        memset(status, POINT_KEPT, totalPoints);
+        status[0] = POINT_ANCHORED;
+        status[totalPoints - 1] = POINT_ANCHORED;
+
+        // 1. Collinear runs
+        MergeCollinear(point, totalPoints, status);
+
+        // 2. Arcs, whose ends must stay and whose insides go
+        if (fitArcs)
+        {
+            result = FitArcs(point, totalPoints, tolerance, &arcs, &totalArcs);
+        }
+    }
+
+    if (result == EXIT_SUCCESS)
+    {
+        for (thisArc = 0; thisArc < totalArcs; thisArc++)
+        {
+            status[arcs[thisArc].start] = POINT_ANCHORED;
+            status[arcs[thisArc].end] = POINT_ANCHORED;
+            for (thisPoint = arcs[thisArc].start + 1; thisPoint < arcs[thisArc].end; thisPoint++)
+            {
+                status[thisPoint] = POINT_DROPPED;
+            }
+        }
+
+        // 3. Everything between two anchors that isn't an arc
+        for (thisPoint = 0; thisPoint < totalPoints; thisPoint++)
+        {
+            if (status[thisPoint] != POINT_DROPPED)
+            {
+                candidate[totalCandidates++] = thisPoint;
+            }
+        }
+        thisArc = 0;
+        anchor = 0;
+        for (thisCandidate = 1; thisCandidate < totalCandidates; thisCandidate++)
+        {
+            if (status[candidate[thisCandidate]] != POINT_ANCHORED)
+            {
+                continue;
+            }
+            if (thisArc < totalArcs && arcs[thisArc].start == candidate[anchor])
+            {
+                thisArc++;
+            }
+            else
+            {
+                Simplify(point, candidate, anchor, thisCandidate, tolerance, status);
+            }
+            anchor = thisCandidate;
+        }
+
+        result = BuildMoves(point, totalPoints, status, arcs, totalArcs, path);
+    }
+
+    free(status);
+    free(candidate);
+    free(arcs);
+
+    return(result);
+}
+
+
+// Function name: FreePath()
+// Purpose: Releases the moves of a tool path.
+//
+void FreePath(ToolPath *path)
+{
+    free(path->move);
+    path->move = NULL;
+    path->totalMoves = 0;
+}
+
+
+// --- End of reduce.c
@@ -0,0 +1,67 @@
+// reduce.h
+//
+// Tool path reduction: fewer, longer moves for each airfoil half
+// (see reduce.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef REDUCE_H        // Don't define everything more than once
+#define REDUCE_H        //
+
+
+// The kinds of move a reduced tool path is made of
+enum MoveType
+{
+    LineMove,               // G1: all four axes in a straight line
+    ClockwiseArc,           // G2: X/Y on an arc, U/V in a straight line
+    CounterclockwiseArc     // G3: likewise, the other way around
+};
+
+// One move of a reduced tool path, ending at data point "index"
+typedef struct
+{
+    int index;              // Data point the move ends at
+    enum MoveType type;     // How the wire gets there
+    float centerI;          // Arc center, relative to the root (X/Y)
+    float centerJ;          //   point the arc starts from
+} Move;
+
+// The reduced tool path of one airfoil half
+typedef struct
+{
+    Move *move;             // The moves, in order. The first one goes to
+    int totalMoves;         //   data point 0.
+    int totalPoints;        // Data points the path was reduced from
+    int totalArcs;          // Moves that are arcs
+    double maxDeviation;    // Furthest any data point is from the path
+} ToolPath;
+
+
+// Function prototypes
+int ReducePath(const float *const point[4], int totalPoints, double tolerance,
+               int fitArcs, ToolPath *path);
+void FreePath(ToolPath *path);
+
+
+#endif
+// --- End of reduce.h
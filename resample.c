@@ -0,0 +1,228 @@
+// resample.c
+//
+// Fits a spline through the points of one side of an airfoil half and
+// samples it at evenly spaced (or leading-edge clustered) distances along
+// the curve, so that the root and tip of a half end up with the same
+// number of points
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// The spline is a Catmull-Rom style cubic Hermite spline parameterized by
+// chord length: the tangent at each point is the average of the slopes on
+// either side, weighted by the length of the other side, which keeps
+// unevenly spaced points (such as a dense leading edge) from overshooting.
+// Sample j of a side is placed fraction[j] of the way along that side's
+// curve, measured along the lines between its points, so sample j of the
+// root and sample j of the tip are at the same relative position.
+//
+// The samples are found in order while walking the points once, so a side
+// costs two passes over its points (one to measure it) plus one over the
+// samples, and nothing is allocated.
+//
+
+
+#include <math.h>
+
+#include "resample.h"
+
+
+#define HALF_PI (3.14159265358979323846 / 2.0)
+
+
+// Function name: SampleFractions()
+// Purpose: Fills in how far along the curve each sample goes, from 0 at
+//          the first point to 1 at the last. Without clustering the samples
+//          are evenly spaced; with it they are spaced by a half cosine,
+//          closest together at the leading edge.
+//
+void SampleFractions(double *fraction, int totalSamples, int clustering,
+                     int leadingEdgeFirst)
+{
+    double even;
+    int thisSample;
+
+    for (thisSample = 0; thisSample < totalSamples; thisSample++)
+    {
+        even = (totalSamples > 1) ? (double)thisSample / (totalSamples - 1) : 0.0;
+        if (!clustering)
+        {
+            fraction[thisSample] = even;
+        }
+        else if (leadingEdgeFirst)
+        {
+            fraction[thisSample] = 1.0 - cos(even * HALF_PI);
+        }
+        else
+        {
+            fraction[thisSample] = sin(even * HALF_PI);
+        }
+    }
+
+    // Make sure the ends land exactly on the first and last points
+    fraction[0] = 0.0;
+    fraction[totalSamples - 1] = 1.0;
+}
+
+
+// Function name: Slope()
+// Purpose: Direction of the line from point "a" to point "b" per unit of
+//          length, whose length is "length" (which must not be zero).
+//
+static void Slope(const float *x, const float *y, int a, int b, double length,
+                  double *slopeX, double *slopeY)
+{
+    *slopeX = ((double)x[b] - x[a]) / length;
+    *slopeY = ((double)y[b] - y[a]) / length;
+}
+
+
+// Function name: Tangent()
+// Purpose: Tangent of the spline at point "k", per unit of length. The
+//          slopes either side are weighted by the length of the other side;
+//          the end points just use the slope of their one line.
+//
+static void Tangent(const float *x, const float *y, int totalPoints, int k,
+                    double *tangentX, double *tangentY)
+{
+    double before = 0.0;
+    double after = 0.0;
+    double beforeX = 0.0, beforeY = 0.0;
+    double afterX = 0.0, afterY = 0.0;
+
+    if (k > 0)
+    {
+        before = hypot((double)x[k] - x[k - 1], (double)y[k] - y[k - 1]);
+    }
+    if (k < totalPoints - 1)
+    {
+        after = hypot((double)x[k + 1] - x[k], (double)y[k + 1] - y[k]);
+    }
+    if (before > 0.0)
+    {
+        Slope(x, y, k - 1, k, before, &beforeX, &beforeY);
+    }
+    if (after > 0.0)
+    {
+        Slope(x, y, k, k + 1, after, &afterX, &afterY);
+    }
+
+    // Repeated points and the ends have only one usable side
+    if (before == 0.0 || after == 0.0)
+    {
+        *tangentX = beforeX + afterX;
+        *tangentY = beforeY + afterY;
+        return;
+    }
+
+    *tangentX = (after * beforeX + before * afterX) / (before + after);
+    *tangentY = (after * beforeY + before * afterY) / (before + after);
+}
+
+
+// Function name: ResampleCurve()
+// Purpose: Samples the spline through the "totalPoints" points (x, y) at
+//          each of the "totalSamples" fractions of its length, in order,
+//          into sampleX and sampleY.
+//
+void ResampleCurve(const float *x, const float *y, int totalPoints,
+                   const double *fraction, int totalSamples, float *sampleX, float *sampleY)
+{
+    double totalLength = 0.0;
+    double lineStart = 0.0;     // Length of the curve up to the current line
+    double lineLength;          // Length of the current line
+    double startTangentX, startTangentY;
+    double endTangentX, endTangentY;
+    double target;
+    double s, s2, s3;
+    int thisLine;
+    int thisPoint;
+    int thisSample;
+
+    // Measure the curve
+    for (thisPoint = 1; thisPoint < totalPoints; thisPoint++)
+    {
+        totalLength += hypot((double)x[thisPoint] - x[thisPoint - 1],
+                             (double)y[thisPoint] - y[thisPoint - 1]);
+    }
+
+    // A single point, or all of them in the same place
+    if (totalLength == 0.0)
+    {
+        for (thisSample = 0; thisSample < totalSamples; thisSample++)
+        {
+            sampleX[thisSample] = x[0];
+            sampleY[thisSample] = y[0];
+        }
+        return;
+    }
+
+    thisLine = 0;
+    lineLength = hypot((double)x[1] - x[0], (double)y[1] - y[0]);
+    Tangent(x, y, totalPoints, 0, &startTangentX, &startTangentY);
+    Tangent(x, y, totalPoints, 1, &endTangentX, &endTangentY);
+
+    for (thisSample = 0; thisSample < totalSamples; thisSample++)
+    {
+        target = fraction[thisSample] * totalLength;
+
+        // Move on to the line this sample falls on
+        while ((lineStart + lineLength < target || lineLength == 0.0) &&
+               thisLine < totalPoints - 2)
+        {
+            lineStart += lineLength;
+            thisLine++;
+            lineLength = hypot((double)x[thisLine + 1] - x[thisLine],
+                               (double)y[thisLine + 1] - y[thisLine]);
+            startTangentX = endTangentX;
+            startTangentY = endTangentY;
+            Tangent(x, y, totalPoints, thisLine + 1, &endTangentX, &endTangentY);
+        }
+
+        // How far along the line, from 0 to 1
+        s = (lineLength > 0.0) ? (target - lineStart) / lineLength : 1.0;
+        if (s < 0.0)
+        {
+            s = 0.0;
+        }
+        else if (s > 1.0)
+        {
+            s = 1.0;
+        }
+        s2 = s * s;
+        s3 = s2 * s;
+
+        // Cubic Hermite between the ends of the line
+        sampleX[thisSample] = (float)(
+          (2.0 * s3 - 3.0 * s2 + 1.0) * x[thisLine] +
+          (s3 - 2.0 * s2 + s) * lineLength * startTangentX +
+          (-2.0 * s3 + 3.0 * s2) * x[thisLine + 1] +
+          (s3 - s2) * lineLength * endTangentX);
+        sampleY[thisSample] = (float)(
+          (2.0 * s3 - 3.0 * s2 + 1.0) * y[thisLine] +
+          (s3 - 2.0 * s2 + s) * lineLength * startTangentY +
+          (-2.0 * s3 + 3.0 * s2) * y[thisLine + 1] +
+          (s3 - s2) * lineLength * endTangentY);
+    }
+}
+
+
+// --- End of resample.c
@@ -0,0 +1,40 @@
+// resample.h
+//
+// Spline resampling of each side's curve to a common number of points
+// (see resample.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef RESAMPLE_H      // Don't define everything more than once
+#define RESAMPLE_H      //
+
+
+// Function prototypes
+void SampleFractions(double *fraction, int totalSamples, int clustering,
+                     int leadingEdgeFirst);
+void ResampleCurve(const float *x, const float *y, int totalPoints,
+                   const double *fraction, int totalSamples, float *sampleX, float *sampleY);
+
+
+#endif
+// --- End of resample.h
@@ -0,0 +1,440 @@
+// section.c
+//
+// Loads binary section files by mapping them into memory, and converts
+// between them and the eight vector input files
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// A loaded section is never copied: each Vector.value points straight into
+// the read-only mapping, so nothing may write through it. The mapping is
+// released by FreeMemory() (through UnloadSection()).
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "gcode.h"
+#include "section.h"
+
+
+// Function name: AlignOffset()
+// Purpose: Rounds a file offset up to the next SECTION_ALIGNMENT boundary.
+//
+static size_t AlignOffset(size_t offset)
+{
+    return((offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT);
+}
+
+
+// Function name: HasSection()
+// Purpose: True if the job's folder holds a binary section file.
+//
+int HasSection(const Job *job)
+{
+    char filename[MAX_PATH_LENGTH];
+    struct stat status;
+
+    BuildFilename(job, SECTION_FILENAME, filename);
+
+    return(stat(filename, &status) == 0 && S_ISREG(status.st_mode));
+}
+
+
+// Function name: IsSectionCurrent()
+// Purpose: True unless one of the vector files beside the job's section
+//          file was modified after the section was packed. Designers edit
+//          the vector files, so a section older than any of them is stale
+//          and they are read instead. The first newer file is named in
+//          "newer" (MAX_PATH_LENGTH characters) if it isn't NULL.
+//
+int IsSectionCurrent(const Job *job, char *newer)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    char filename[MAX_PATH_LENGTH];
+    struct stat section;
+    struct stat status;
+
+    BuildFilename(job, SECTION_FILENAME, filename);
+    if (stat(filename, &section) != 0)
+    {
+        return(0);
+    }
+
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                FindVectorFile(job, thisSide, thisHalf, thisDimension, filename);
+                if (stat(filename, &status) != 0)
+                {
+                    continue;
+                }
+                if (status.st_mtim.tv_sec > section.st_mtim.tv_sec ||
+                    (status.st_mtim.tv_sec == section.st_mtim.tv_sec &&
+                     status.st_mtim.tv_nsec > section.st_mtim.tv_nsec))
+                {
+                    if (newer != NULL)
+                    {
+                        strcpy(newer, filename);
+                    }
+                    return(0);
+                }
+            }
+        }
+    }
+
+    return(1);
+}
+
+
+// Function name: LoadSection()
+// Purpose: Maps the job's section file into memory and points every vector
+//          at its values. Nothing is parsed or copied.
+//
+int LoadSection(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    SectionHeader header;
+    struct stat status;
+    char *mapping;
+    size_t offset;
+    size_t length;
+    int file;
+
+    char filename[MAX_PATH_LENGTH];
+
+
+    // Open and map the file
+    BuildFilename(job, SECTION_FILENAME, filename);
+    file = open(filename, O_RDONLY);
+    if (file < 0)
+    {
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_OPENERROR, filename);
+        return(EXIT_FAILURE);
+    }
+    if (fstat(file, &status) != 0 || (size_t)status.st_size < sizeof(SectionHeader))
+    {
+        close(file);
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_SECTION_FORMATERROR, filename, SECTION_VERSION);
+        return(EXIT_FAILURE);
+    }
+    length = (size_t)status.st_size;
+    mapping = (char *)mmap(NULL, length, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED)
+    {
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_SECTION_MAPERROR, filename);
+        return(EXIT_FAILURE);
+    }
+    job->section = mapping;
+    job->sectionLength = length;
+
+    // We're about to walk the whole thing, so ask for it to be read ahead
+    posix_madvise(mapping, length, POSIX_MADV_WILLNEED);
+
+    // Check that this is a section file we understand
+    memcpy(&header, mapping, sizeof(SectionHeader));
+    if (memcmp(header.magic, SECTION_MAGIC, sizeof(header.magic)) != 0 ||
+        header.byteOrder != SECTION_BYTE_ORDER ||
+        header.version != SECTION_VERSION ||
+        header.valueSize != sizeof(float))
+    {
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_SECTION_FORMATERROR, filename, SECTION_VERSION);
+        return(EXIT_FAILURE);
+    }
+
+    // Point every vector at its array
+    offset = AlignOffset(sizeof(SectionHeader));
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                // Every vector needs at least one value, and must fit
+                // inside the file
+                if (header.totalValues[thisSide][thisHalf][thisDimension] == 0 ||
+                    header.totalValues[thisSide][thisHalf][thisDimension] > INT_MAX ||
+                    offset + (size_t)header.totalValues[thisSide][thisHalf][thisDimension] *
+                             sizeof(float) > length)
+                {
+                    ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_READERROR, filename);
+                    return(EXIT_FAILURE);
+                }
+
+                job->thisVector[thisSide][thisHalf][thisDimension].totalValues =
+                  (int)header.totalValues[thisSide][thisHalf][thisDimension];
+                job->thisVector[thisSide][thisHalf][thisDimension].value =
+                  (float *)(mapping + offset);
+
+                offset = AlignOffset(offset +
+                  (size_t)header.totalValues[thisSide][thisHalf][thisDimension] * sizeof(float));
+            }
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: UnmapSection()
+// Purpose: Releases the mapping made by LoadSection(), leaving the vectors
+//          alone (DetachVectors() has already pointed them elsewhere).
+//
+void UnmapSection(Job *job)
+{
+    if (job->section == NULL)
+    {
+        return;
+    }
+
+    munmap(job->section, job->sectionLength);
+    job->section = NULL;
+    job->sectionLength = 0;
+}
+
+
+// Function name: UnloadSection()
+// Purpose: Releases the mapping made by LoadSection(). The vectors no
+//          longer have any values afterwards.
+//
+void UnloadSection(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    if (job->section == NULL)
+    {
+        return;
+    }
+
+    UnmapSection(job);
+
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                job->thisVector[thisSide][thisHalf][thisDimension].value = NULL;
+            }
+        }
+    }
+}
+
+
+// Function name: WriteSection()
+// Purpose: Writes the job's vectors, as they are in memory, to its section
+//          file.
+//
+static int WriteSection(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    static const char zeros[SECTION_ALIGNMENT] = { 0 };
+
+    SectionHeader header;
+    FILE *sectionFile;
+    size_t offset;
+    size_t bytes;
+    int result = 0;
+
+    char filename[MAX_PATH_LENGTH];
+
+
+    // Fill in the header
+    memset(&header, 0, sizeof(SectionHeader));
+    memcpy(header.magic, SECTION_MAGIC, sizeof(header.magic));
+    header.byteOrder = SECTION_BYTE_ORDER;
+    header.version = SECTION_VERSION;
+    header.valueSize = sizeof(float);
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                header.totalValues[thisSide][thisHalf][thisDimension] =
+                  (uint32_t)job->thisVector[thisSide][thisHalf][thisDimension].totalValues;
+            }
+        }
+    }
+
+    BuildFilename(job, SECTION_FILENAME, filename);
+    sectionFile = fopen(filename, WRITEBINARY);
+    if (sectionFile == NULL)
+    {
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_WRITEERROR, filename);
+        return(EXIT_FAILURE);
+    }
+
+    // Header, then every array padded out to the next boundary
+    result |= (fwrite(&header, sizeof(SectionHeader), 1, sectionFile) != 1);
+    offset = sizeof(SectionHeader);
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                result |= (fwrite(zeros, 1, AlignOffset(offset) - offset, sectionFile) !=
+                           AlignOffset(offset) - offset);
+                offset = AlignOffset(offset);
+
+                bytes = (size_t)job->thisVector[thisSide][thisHalf][thisDimension].totalValues *
+                        sizeof(float);
+                result |= (fwrite(job->thisVector[thisSide][thisHalf][thisDimension].value, 1,
+                                  bytes, sectionFile) != bytes);
+                offset += bytes;
+            }
+        }
+    }
+
+    result |= (fclose(sectionFile) != 0);
+    if (result)
+    {
+        ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_WRITEERROR, filename);
+        return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: PackSection()
+// Purpose: Reads the job's eight vector input files and writes them all
+//          into one section file.
+//
+int PackSection(Job *job)
+{
+    int result;
+
+    result = OpenDataFiles(job);
+    if (result == EXIT_SUCCESS)
+    {
+        CheckVectorConsistency(job);
+        result = AllocateMemory(job);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        result = ReadVectorData(job);
+    }
+    if (result == EXIT_SUCCESS)
+    {
+        result = WriteSection(job);
+    }
+
+    FreeMemory(job);
+    CloseDataFiles(job);
+
+    return(result);
+}
+
+
+// Function name: UnpackSection()
+// Purpose: Writes the vectors of the job's section file back out as eight
+//          vector input files. "%.9g" gives back exactly the same floats.
+//
+int UnpackSection(Job *job)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    const Vector *thisOutput;
+    FILE *vectorFile;
+    int thisValue;
+    int result;
+
+    char filename[MAX_PATH_LENGTH];
+
+
+    result = LoadSection(job);
+    for (thisSide = Root; thisSide <= Tip && result == EXIT_SUCCESS; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower && result == EXIT_SUCCESS; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y && result == EXIT_SUCCESS; thisDimension++)
+            {
+                thisOutput = &job->thisVector[thisSide][thisHalf][thisDimension];
+
+                BuildVectorFilename(job, thisSide, thisHalf, thisDimension, filename);
+                vectorFile = fopen(filename, WRITEONLY);
+                if (vectorFile == NULL)
+                {
+                    ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_WRITEERROR, filename);
+                    result = EXIT_FAILURE;
+                    continue;
+                }
+
+                fprintf(vectorFile, "%d\n", thisOutput->totalValues);
+                for (thisValue = 0; thisValue < thisOutput->totalValues; thisValue++)
+                {
+                    fprintf(vectorFile, "%.9g\n", thisOutput->value[thisValue]);
+                }
+
+                result = ferror(vectorFile) ? EXIT_FAILURE : EXIT_SUCCESS;
+                if (fclose(vectorFile) != 0)
+                {
+                    result = EXIT_FAILURE;
+                }
+                if (result != EXIT_SUCCESS)
+                {
+                    ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_WRITEERROR, filename);
+                }
+            }
+        }
+    }
+
+    UnloadSection(job);
+
+    // The vector files were just written from the section, so it isn't
+    // stale (see IsSectionCurrent())
+    if (result == EXIT_SUCCESS)
+    {
+        BuildFilename(job, SECTION_FILENAME, filename);
+        utimensat(AT_FDCWD, filename, NULL, 0);
+    }
+
+    return(result);
+}
+
+
+// --- End of section.c
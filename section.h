@@ -0,0 +1,71 @@
+// section.h
+//
+// Binary section files: all eight vectors in one memory-mapped file
+// (see section.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef SECTION_H       // Don't define everything more than once
+#define SECTION_H       //
+
+#include <stdint.h>
+
+#include "gcode.h"
+
+
+#define SECTION_MAGIC "GCODESEC"        // First eight bytes of every file
+#define SECTION_BYTE_ORDER 0x01020304   // Reads back differently if swapped
+#define SECTION_VERSION 1               // Bumped on incompatible changes
+#define SECTION_ALIGNMENT 64            // Each array starts on this boundary
+
+#define WRITEBINARY "wb"                // File access constant
+
+
+// The file starts with this header. The eight float arrays follow, in
+// Side, Half, Dimension order (ROOTUPPERX first, TIPLOWERY last), each
+// starting at the next multiple of SECTION_ALIGNMENT bytes. Values are
+// stored unscaled, exactly as they appear in the text files.
+typedef struct
+{
+    char magic[8];          // SECTION_MAGIC, without a terminating zero
+    uint32_t byteOrder;     // SECTION_BYTE_ORDER, in the writer's byte order
+    uint32_t version;       // SECTION_VERSION
+    uint32_t valueSize;     // Bytes per value; only sizeof(float) for now
+    uint32_t reserved;      // Zero
+    uint32_t totalValues[TOTAL_SIDES][TOTAL_HALVES][TOTAL_DIMENSIONS_PER_HALF];
+    uint64_t padding;       // Zero; rounds the header up to 64 bytes
+} SectionHeader;
+
+
+// Function prototypes
+int HasSection(const Job *job);
+int IsSectionCurrent(const Job *job, char *newer);
+int LoadSection(Job *job);
+void UnmapSection(Job *job);
+void UnloadSection(Job *job);
+int PackSection(Job *job);
+int UnpackSection(Job *job);
+
+
+#endif
+// --- End of section.h
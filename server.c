@@ -0,0 +1,859 @@
+// server.c
+//
+// Server mode: a warm process that renders jobs sent over a Unix domain
+// socket (see server.h for the protocol)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// The listener thread owns the socket and every connection that isn't
+// busy. It polls them, and hands a connection with a request waiting to
+// the workers through a queue. A worker reads the whole request, renders
+// it with every buffer taken from its own arena (see arena.c), writes the
+// reply as it is made and hands the connection back.
+//
+// At most maxInFlight requests are queued or running at once. Beyond that
+// the listener stops reading requests, so clients that keep sending fill
+// their socket buffers and block: the kernel does the backpressure. A
+// client that reads its replies slowly likewise holds up only the worker
+// writing to it. Connections beyond SERVER_CONNECTIONS_MAX wait in the
+// listen backlog.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "server.h"
+#include "libgcode.h"
+#include "pool.h"
+
+
+// State shared by the listener and the workers
+typedef struct
+{
+    GCodeContext context;   // Settings every request starts from (read-only)
+    int maxInFlight;        // Most requests queued or running at once
+    pthread_mutex_t lock;   // Guards everything below
+    pthread_cond_t ready;   // Signalled when a request is queued
+    Connection *queue[SERVER_CONNECTIONS_MAX];    // Connections with a request
+    int queueStart;                               //   waiting, oldest first
+    int queueLength;                              //
+    Connection *returned[SERVER_CONNECTIONS_MAX]; // Connections done with by
+    int totalReturned;                            //   a worker, to poll again
+    int totalConnections;   // Connections open
+    int inFlight;           // Requests queued or being run
+    int stopping;           // Nonzero once the workers should finish up
+    int wake[2];            // Workers write a byte here to wake the listener
+} Server;
+
+// What each worker keeps from one request to the next
+typedef struct
+{
+    Server *server;
+    Arena arena;            // Where every buffer of a request comes from
+    char message[GCODE_MESSAGE_MAX]; // Messages sent back with the reply
+} Worker;
+
+
+// Set by SIGINT and SIGTERM to stop the server
+static volatile sig_atomic_t stopRequested = 0;
+
+
+
+// Function name: OpenConnection()
+// Purpose: Prepares one end of a connection that has just been accepted
+//          or connected. Returns EXIT_FAILURE if the read buffer can't be
+//          allocated.
+//
+int OpenConnection(Connection *connection, int socket)
+{
+    connection->socket = socket;
+    connection->position = 0;
+    connection->length = 0;
+    connection->capacity = SERVER_READ_SIZE;
+    connection->buffer = (char *)malloc(SERVER_READ_SIZE);
+
+    return((connection->buffer == NULL) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+
+// Function name: CloseConnection()
+// Purpose: Closes the socket and releases the read buffer.
+//
+void CloseConnection(Connection *connection)
+{
+    close(connection->socket);
+    free(connection->buffer);
+    connection->buffer = NULL;
+}
+
+
+// Function name: FillConnection()
+// Purpose: Reads whatever has arrived on the socket (waiting for some if
+//          nothing has), keeping the bytes not used yet. Returns
+//          EXIT_FAILURE at the end of the connection, on an error or
+//          timeout, or once SERVER_REQUEST_MAX bytes are held.
+//
+static int FillConnection(Connection *connection)
+{
+    ssize_t received;
+    char *grown;
+
+    // Move the bytes not used yet to the front
+    if (connection->position > 0)
+    {
+        memmove(connection->buffer, connection->buffer + connection->position,
+                connection->length - connection->position);
+        connection->length -= connection->position;
+        connection->position = 0;
+    }
+
+    // Make room for a good-sized read
+    if (connection->capacity - connection->length < SERVER_READ_SIZE)
+    {
+        if (connection->length >= SERVER_REQUEST_MAX)
+        {
+            return(EXIT_FAILURE);
+        }
+        grown = (char *)realloc(connection->buffer, connection->capacity * 2);
+        if (grown == NULL)
+        {
+            return(EXIT_FAILURE);
+        }
+        connection->buffer = grown;
+        connection->capacity *= 2;
+    }
+
+    do
+    {
+        received = recv(connection->socket, connection->buffer + connection->length,
+                        connection->capacity - connection->length, 0);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0)
+    {
+        return(EXIT_FAILURE);
+    }
+    connection->length += received;
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ReadConnectionLine()
+// Purpose: Returns the next line from the connection, without its line
+//          ending, or NULL if the connection ends first (see
+//          FillConnection()). The line is only good until the next read.
+//
+char *ReadConnectionLine(Connection *connection)
+{
+    size_t searched = 0;
+    char *line;
+    char *end;
+
+    while ((end = (char *)memchr(connection->buffer + connection->position + searched, '\n',
+                                 connection->length - connection->position - searched)) == NULL)
+    {
+        searched = connection->length - connection->position;
+        if (FillConnection(connection) != EXIT_SUCCESS)
+        {
+            return(NULL);
+        }
+    }
+
+    line = connection->buffer + connection->position;
+    connection->position = end + 1 - connection->buffer;
+    if (end > line && end[-1] == '\r')
+    {
+        end--;
+    }
+    *end = '\0';
+
+    return(line);
+}
+
+
+// Function name: ReadConnectionBytes()
+// Purpose: Returns the next "length" bytes from the connection, or NULL if
+//          the connection ends first. The bytes are only good until the
+//          next read.
+//
+const char *ReadConnectionBytes(Connection *connection, size_t length)
+{
+    const char *bytes;
+
+    while (connection->length - connection->position < length)
+    {
+        if (FillConnection(connection) != EXIT_SUCCESS)
+        {
+            return(NULL);
+        }
+    }
+
+    bytes = connection->buffer + connection->position;
+    connection->position += length;
+
+    return(bytes);
+}
+
+
+// Function name: SendToConnection()
+// Purpose: Sends a header and a body (either may be empty) with as few
+//          calls as the socket allows. Returns EXIT_FAILURE if the other
+//          end has gone away.
+//
+int SendToConnection(Connection *connection, const char *header, size_t headerLength,
+                     const char *body, size_t bodyLength)
+{
+    struct iovec part[2];
+    struct msghdr message;
+    ssize_t sent;
+
+    part[0].iov_base = (void *)header;
+    part[0].iov_len = headerLength;
+    part[1].iov_base = (void *)body;
+    part[1].iov_len = bodyLength;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = part;
+    message.msg_iovlen = 2;
+
+    while (message.msg_iovlen > 0)
+    {
+        // MSG_NOSIGNAL: a client that hangs up mustn't stop the server
+        sent = sendmsg(connection->socket, &message, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return(EXIT_FAILURE);
+        }
+        // Skip over what was sent
+        while (message.msg_iovlen > 0 && (size_t)sent >= message.msg_iov->iov_len)
+        {
+            sent -= message.msg_iov->iov_len;
+            message.msg_iov++;
+            message.msg_iovlen--;
+        }
+        if (message.msg_iovlen > 0)
+        {
+            message.msg_iov->iov_base = (char *)message.msg_iov->iov_base + sent;
+            message.msg_iov->iov_len -= sent;
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: SendChunk()
+// Purpose: The sink requests are rendered to: sends each block of G-code
+//          as a "data" chunk as soon as it is ready.
+//
+static int SendChunk(void *sinkData, const char *text, size_t length)
+{
+    char header[32];
+
+    snprintf(header, sizeof(header), "data %lu\n", (unsigned long)length);
+
+    return(SendToConnection((Connection *)sinkData, header, strlen(header), text, length));
+}
+
+
+// Function name: ReadRequestVector()
+// Purpose: Reads a "vector" line of a request into the worker's arena.
+//          Returns EXIT_FAILURE, with the problem in the worker's message,
+//          if the line can't be used.
+//
+static int ReadRequestVector(Worker *worker, GCodeInput *input, const char *line)
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    char name[3][8];
+    int totalValues;
+    int used;
+    int thisValue;
+    float *value;
+    const char *cursor;
+    char *end;
+
+    // Each value takes at least a space and a digit, so a count the line
+    // can't hold is refused before anything is allocated for it
+    if (sscanf(line, "vector %7s %7s %7s %d%n", name[0], name[1], name[2],
+               &totalValues, &used) != 4 || totalValues <= 0 ||
+        (size_t)totalValues > strlen(line + used) / 2)
+    {
+        snprintf(worker->message, GCODE_MESSAGE_MAX, MESSAGE_ERROR MESSAGE_REQUEST_VECTORERROR,
+                 line);
+        return(EXIT_FAILURE);
+    }
+    for (thisSide = Root; thisSide <= Tip && strcmp(name[0], SideToString[thisSide]) != 0;
+         thisSide++);
+    for (thisHalf = Upper; thisHalf <= Lower && strcmp(name[1], HalfToString[thisHalf]) != 0;
+         thisHalf++);
+    for (thisDimension = X; thisDimension <= Y &&
+         strcmp(name[2], DimensionToString[thisDimension]) != 0; thisDimension++);
+    if (thisSide > Tip || thisHalf > Lower || thisDimension > Y)
+    {
+        snprintf(worker->message, GCODE_MESSAGE_MAX, MESSAGE_ERROR MESSAGE_REQUEST_VECTORERROR,
+                 line);
+        return(EXIT_FAILURE);
+    }
+
+    value = (float *)AllocateFromArena(&worker->arena, (size_t)totalValues * sizeof(float));
+    if (value == NULL)
+    {
+        snprintf(worker->message, GCODE_MESSAGE_MAX, MESSAGE_ERROR MESSAGE_MEMORY_ALLOCERROR);
+        return(EXIT_FAILURE);
+    }
+
+    // Exactly the number of values listed
+    cursor = line + used;
+    for (thisValue = 0; thisValue < totalValues; thisValue++)
+    {
+        value[thisValue] = strtof(cursor, &end);
+        if (end == cursor)
+        {
+            break;
+        }
+        cursor = end;
+    }
+    while (*cursor == ' ' || *cursor == '\t')
+    {
+        cursor++;
+    }
+    if (thisValue < totalValues || *cursor != '\0')
+    {
+        snprintf(worker->message, GCODE_MESSAGE_MAX, MESSAGE_ERROR MESSAGE_REQUEST_VECTORERROR,
+                 line);
+        return(EXIT_FAILURE);
+    }
+
+    input->value[thisSide][thisHalf][thisDimension] = value;
+    input->totalValues[thisSide][thisHalf][thisDimension] = totalValues;
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ReadRequestLine()
+// Purpose: Applies one line of a request to the job's settings and input.
+//          Returns EXIT_FAILURE, with the problem in the worker's message,
+//          if the line can't be used.
+//
+static int ReadRequestLine(Worker *worker, Settings *settings, GCodeInput *input,
+                           char *directory, char *line)
+{
+    char *word[SERVER_OPTIONS_MAX];
+    char *position;
+    int totalWords = 0;
+    int option;
+    int thisWord;
+
+    if (strncmp(line, "option ", 7) == 0)
+    {
+        // The same options as on the command line
+        for (word[0] = strtok_r(line + 7, " \t", &position); word[totalWords] != NULL;
+             word[totalWords] = strtok_r(NULL, " \t", &position))
+        {
+            if (++totalWords == SERVER_OPTIONS_MAX)
+            {
+                snprintf(worker->message, GCODE_MESSAGE_MAX,
+                         MESSAGE_ERROR MESSAGE_REQUEST_OPTIONERROR, word[totalWords - 1]);
+                return(EXIT_FAILURE);
+            }
+        }
+        for (thisWord = 0; thisWord < totalWords; thisWord++)
+        {
+            option = ParseJobOption(settings, totalWords, (const char **)word, &thisWord);
+            if (option < 0)
+            {
+                snprintf(worker->message, GCODE_MESSAGE_MAX,
+                         MESSAGE_ERROR MESSAGE_TRANSFORM_ERROR, word[thisWord]);
+                return(EXIT_FAILURE);
+            }
+            if (option == 0)
+            {
+                snprintf(worker->message, GCODE_MESSAGE_MAX,
+                         MESSAGE_ERROR MESSAGE_REQUEST_OPTIONERROR, word[thisWord]);
+                return(EXIT_FAILURE);
+            }
+        }
+    }
+    else if (strncmp(line, "directory ", 10) == 0 && strlen(line + 10) < MAX_PATH_LENGTH)
+    {
+        strcpy(directory, line + 10);
+        input->directory = directory;
+    }
+    else if (strncmp(line, "vector ", 7) == 0)
+    {
+        return(ReadRequestVector(worker, input, line));
+    }
+    else if (line[0] != '\0')
+    {
+        snprintf(worker->message, GCODE_MESSAGE_MAX, MESSAGE_ERROR MESSAGE_REQUEST_LINEERROR,
+                 line);
+        return(EXIT_FAILURE);
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ServeRequest()
+// Purpose: Reads one request from the connection, renders it and sends
+//          the reply. Returns nonzero if the connection can take another
+//          request, and zero if it should be closed.
+//
+static int ServeRequest(Worker *worker, Connection *connection)
+{
+    GCodeContext context = worker->server->context;
+    GCodeInput input;
+    char directory[MAX_PATH_LENGTH];
+    char header[32];
+    char *line;
+    int result = EXIT_SUCCESS;
+    int sent;
+
+    memset(&input, 0, sizeof(GCodeInput));
+    worker->message[0] = '\0';
+
+    // After a bad line the rest of the request is only skipped
+    while ((line = ReadConnectionLine(connection)) != NULL && strcmp(line, "run") != 0)
+    {
+        if (result == EXIT_SUCCESS)
+        {
+            result = ReadRequestLine(worker, &context.settings, &input, directory, line);
+        }
+    }
+    if (line == NULL)
+    {
+        // The client hung up, or sent too much to be a request
+        ResetArena(&worker->arena);
+        return(0);
+    }
+    if (result == EXIT_SUCCESS && context.settings.fitArcs && !context.settings.reducing)
+    {
+        snprintf(worker->message, GCODE_MESSAGE_MAX, MESSAGE_ERROR MESSAGE_REQUEST_OPTIONERROR,
+                 "--arcs");
+        result = EXIT_FAILURE;
+    }
+
+    if (result == EXIT_SUCCESS)
+    {
+        result = RenderGCodeInArena(&context, &input, &worker->arena, SendChunk, connection,
+                                    worker->message);
+    }
+    snprintf(header, sizeof(header), "%s %lu\n", (result == EXIT_SUCCESS) ? "ok" : "error",
+             (unsigned long)strlen(worker->message));
+    sent = SendToConnection(connection, header, strlen(header), worker->message,
+                            strlen(worker->message));
+
+    ResetArena(&worker->arena);
+
+    return(sent == EXIT_SUCCESS);
+}
+
+
+// Function name: QueueConnection()
+// Purpose: Hands a connection with a request waiting to the workers. The
+//          caller holds the lock.
+//
+static void QueueConnection(Server *server, Connection *connection)
+{
+    server->queue[(server->queueStart + server->queueLength) % SERVER_CONNECTIONS_MAX] =
+      connection;
+    server->queueLength++;
+    server->inFlight++;
+    pthread_cond_signal(&server->ready);
+}
+
+
+// Function name: ServeConnections()
+// Purpose: The body of every worker: serve queued requests until the
+//          server stops and the queue is empty.
+//
+static void *ServeConnections(void *argument)
+{
+    Worker *worker = (Worker *)argument;
+    Server *server = worker->server;
+    Connection *connection;
+    int keep;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&server->lock);
+        while (server->queueLength == 0 && !server->stopping)
+        {
+            pthread_cond_wait(&server->ready, &server->lock);
+        }
+        if (server->queueLength == 0)
+        {
+            pthread_mutex_unlock(&server->lock);
+            break;
+        }
+        connection = server->queue[server->queueStart];
+        server->queueStart = (server->queueStart + 1) % SERVER_CONNECTIONS_MAX;
+        server->queueLength--;
+        pthread_mutex_unlock(&server->lock);
+
+        keep = ServeRequest(worker, connection);
+
+        pthread_mutex_lock(&server->lock);
+        server->inFlight--;
+        if (!keep)
+        {
+            CloseConnection(connection);
+            free(connection);
+            server->totalConnections--;
+        }
+        else if (connection->position < connection->length)
+        {
+            // The next request has already started arriving
+            QueueConnection(server, connection);
+        }
+        else
+        {
+            server->returned[server->totalReturned++] = connection;
+        }
+        pthread_mutex_unlock(&server->lock);
+
+        // Have the listener poll the connection again, or take more work.
+        // If the pipe is full the listener is awake already.
+        if (write(server->wake[1], "", 1) < 0 && errno != EAGAIN)
+        {
+            break;
+        }
+    }
+
+    return(NULL);
+}
+
+
+// Function name: AcceptConnection()
+// Purpose: Accepts a new client and adds it to the listener's idle
+//          connections.
+//
+static void AcceptConnection(Server *server, int listener, Connection **idle, int *totalIdle)
+{
+    struct timeval timeout;
+    Connection *connection;
+    int client;
+
+    client = accept(listener, NULL, NULL);
+    if (client < 0)
+    {
+        return;
+    }
+
+    // A worker waits this long for the rest of a request
+    timeout.tv_sec = SERVER_READ_TIMEOUT;
+    timeout.tv_usec = 0;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    connection = (Connection *)malloc(sizeof(Connection));
+    if (connection == NULL || OpenConnection(connection, client) != EXIT_SUCCESS)
+    {
+        free(connection);
+        close(client);
+        return;
+    }
+    idle[(*totalIdle)++] = connection;
+
+    pthread_mutex_lock(&server->lock);
+    server->totalConnections++;
+    pthread_mutex_unlock(&server->lock);
+}
+
+
+// Function name: StopServer()
+// Purpose: The SIGINT and SIGTERM handler.
+//
+static void StopServer(int signalNumber)
+{
+    (void)signalNumber;
+    stopRequested = 1;
+}
+
+
+// Function name: OpenListener()
+// Purpose: Creates the listening socket at "path", replacing a socket
+//          left there by an earlier server that has stopped. A server
+//          still listening there is left alone. Returns the socket, or -1
+//          with the problem reported.
+//
+static int OpenListener(const char *path)
+{
+    struct sockaddr_un address;
+    struct stat status;
+    int listener;
+    int probe;
+    int connectError;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_SERVER_LISTENERROR, path, strerror(ENAMETOOLONG));
+        return(-1);
+    }
+    strcpy(address.sun_path, path);
+
+    // Only a socket nobody answers on is left over
+    if (stat(path, &status) == 0 && S_ISSOCK(status.st_mode))
+    {
+        probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe < 0)
+        {
+            fprintf(stderr, MESSAGE_ERROR);
+            fprintf(stderr, MESSAGE_SERVER_LISTENERROR, path, strerror(errno));
+            return(-1);
+        }
+        // A server whose backlog is full still answers, with EAGAIN
+        connectError = (connect(probe, (struct sockaddr *)&address, sizeof(address)) == 0) ?
+                       0 : errno;
+        close(probe);
+        if (connectError != ECONNREFUSED)
+        {
+            fprintf(stderr, MESSAGE_ERROR);
+            if (connectError == 0 || connectError == EAGAIN)
+            {
+                fprintf(stderr, MESSAGE_SERVER_INUSEERROR, path);
+            }
+            else
+            {
+                fprintf(stderr, MESSAGE_SERVER_LISTENERROR, path, strerror(connectError));
+            }
+            return(-1);
+        }
+        unlink(path);
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 ||
+        bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_SERVER_LISTENERROR, path, strerror(errno));
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+        return(-1);
+    }
+
+    return(listener);
+}
+
+
+// Function name: RunServer()
+// Purpose: Serves requests on the Unix socket "path" until SIGINT or
+//          SIGTERM, with settings->totalThreads workers (0 = one per
+//          processor) and at most "maxInFlight" requests queued or running
+//          (0 = SERVER_DEFAULT_IN_FLIGHT per worker). Requests start from
+//          "settings" and may add options of their own. Returns
+//          EXIT_FAILURE if the socket can't be set up.
+//
+int RunServer(const char *path, const Settings *settings, int maxInFlight)
+{
+    Server server;
+    Connection *idle[SERVER_CONNECTIONS_MAX];
+    struct pollfd polled[SERVER_CONNECTIONS_MAX + 2];
+    struct sigaction action;
+    sigset_t signals;
+    sigset_t previous;
+    Worker *worker;
+    pthread_t *thread;
+    int *started;
+    char drain[256];
+    int totalWorkers;
+    int totalIdle = 0;
+    int totalPolled;
+    int kept;
+    int listener;
+    int thisWorker;
+    int thisConnection;
+
+    totalWorkers = (settings->totalThreads > 0) ? settings->totalThreads : PoolDefaultThreads();
+    if (maxInFlight <= 0)
+    {
+        maxInFlight = totalWorkers * SERVER_DEFAULT_IN_FLIGHT;
+    }
+
+    listener = OpenListener(path);
+    if (listener < 0)
+    {
+        return(EXIT_FAILURE);
+    }
+
+    memset(&server, 0, sizeof(Server));
+    worker = (Worker *)malloc(totalWorkers * sizeof(Worker));
+    thread = (pthread_t *)malloc(totalWorkers * sizeof(pthread_t));
+    started = (int *)calloc(totalWorkers, sizeof(int));
+    if (worker == NULL || thread == NULL || started == NULL || pipe(server.wake) != 0)
+    {
+        fprintf(stderr, MESSAGE_ERROR);
+        fprintf(stderr, MESSAGE_SERVER_LISTENERROR, path, strerror(errno));
+        free(worker);
+        free(thread);
+        free(started);
+        close(listener);
+        unlink(path);
+        return(EXIT_FAILURE);
+    }
+    fcntl(server.wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(server.wake[1], F_SETFL, O_NONBLOCK);
+    server.context.settings = *settings;
+    server.maxInFlight = maxInFlight;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.ready, NULL);
+
+    // Only the listener takes SIGINT and SIGTERM, so that they interrupt
+    // its poll()
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous);
+    for (thisWorker = 0; thisWorker < totalWorkers; thisWorker++)
+    {
+        worker[thisWorker].server = &server;
+        InitializeArena(&worker[thisWorker].arena);
+        started[thisWorker] = (pthread_create(&thread[thisWorker], NULL, ServeConnections,
+                                              &worker[thisWorker]) == 0);
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = StopServer;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    printf(MESSAGE_SERVER_LISTENING, path, totalWorkers, maxInFlight);
+    fflush(stdout);
+
+    while (!stopRequested)
+    {
+        // Take back the connections the workers are done with
+        pthread_mutex_lock(&server.lock);
+        for (thisConnection = 0; thisConnection < server.totalReturned; thisConnection++)
+        {
+            idle[totalIdle++] = server.returned[thisConnection];
+        }
+        server.totalReturned = 0;
+        polled[1].fd = (server.totalConnections < SERVER_CONNECTIONS_MAX) ? listener : -1;
+        totalPolled = (server.inFlight < maxInFlight) ? totalIdle : 0;
+        pthread_mutex_unlock(&server.lock);
+
+        // Wait for a worker, a new client or a request
+        polled[0].fd = server.wake[0];
+        polled[0].events = POLLIN;
+        polled[1].events = POLLIN;
+        for (thisConnection = 0; thisConnection < totalPolled; thisConnection++)
+        {
+            polled[2 + thisConnection].fd = idle[thisConnection]->socket;
+            polled[2 + thisConnection].events = POLLIN;
+        }
+        if (poll(polled, 2 + totalPolled, -1) < 0)
+        {
+            continue;
+        }
+        if (polled[0].revents != 0)
+        {
+            while (read(server.wake[0], drain, sizeof(drain)) > 0);
+        }
+
+        // Queue every connection with a request waiting, while there is room
+        kept = 0;
+        pthread_mutex_lock(&server.lock);
+        for (thisConnection = 0; thisConnection < totalIdle; thisConnection++)
+        {
+            if (thisConnection < totalPolled && polled[2 + thisConnection].revents != 0 &&
+                server.inFlight < maxInFlight)
+            {
+                QueueConnection(&server, idle[thisConnection]);
+            }
+            else
+            {
+                idle[kept++] = idle[thisConnection];
+            }
+        }
+        totalIdle = kept;
+        pthread_mutex_unlock(&server.lock);
+
+        if (polled[1].revents & POLLIN)
+        {
+            AcceptConnection(&server, listener, idle, &totalIdle);
+        }
+    }
+
+    // Let the workers finish what is queued, then close everything
+    pthread_mutex_lock(&server.lock);
+    server.stopping = 1;
+    pthread_cond_broadcast(&server.ready);
+    pthread_mutex_unlock(&server.lock);
+    for (thisWorker = 0; thisWorker < totalWorkers; thisWorker++)
+    {
+        if (started[thisWorker])
+        {
+            pthread_join(thread[thisWorker], NULL);
+        }
+        FreeArena(&worker[thisWorker].arena);
+    }
+    for (thisConnection = 0; thisConnection < server.totalReturned; thisConnection++)
+    {
+        idle[totalIdle++] = server.returned[thisConnection];
+    }
+    for (thisConnection = 0; thisConnection < totalIdle; thisConnection++)
+    {
+        CloseConnection(idle[thisConnection]);
+        free(idle[thisConnection]);
+    }
+    close(listener);
+    unlink(path);
+    close(server.wake[0]);
+    close(server.wake[1]);
+    pthread_mutex_destroy(&server.lock);
+    pthread_cond_destroy(&server.ready);
+    free(worker);
+    free(thread);
+    free(started);
+
+    return(EXIT_SUCCESS);
+}
+
+
+// --- End of server.c
@@ -0,0 +1,83 @@
+// server.h
+//
+// Server mode: renders jobs sent over a Unix domain socket by a pool of
+// warm workers (see server.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// The protocol is plain text. A request is a series of lines:
+//
+//   option <options>           Command line options for this job only:
+//                              placement, resampling, reduction, wire speed
+//   directory <path>           Read the vectors from this job folder, or
+//   vector <side> <half> <dimension> <total values> <values>
+//                              give one vector inline, e.g.
+//                              "vector ROOT UPPER X 3 1.0 0.5 0.0"
+//   run                        End of the request
+//
+// Either a directory or all eight vectors must be given. The reply is the
+// G-code in chunks of "data <length>\n" followed by that many bytes, then
+// "ok <length>\n" or "error <length>\n" followed by that many bytes of
+// messages. A connection may send any number of requests, one after
+// another.
+//
+
+
+#ifndef SERVER_H        // Don't define everything more than once
+#define SERVER_H        //
+
+#include <stddef.h>
+
+#include "gcode.h"
+
+
+#define SERVER_CONNECTIONS_MAX 1024     // Open connections at once
+#define SERVER_REQUEST_MAX (256 * 1024 * 1024) // Longest request line or reply chunk
+#define SERVER_READ_SIZE (64 * 1024)    // Least read from a connection at a time
+#define SERVER_READ_TIMEOUT 10          // Seconds to wait for the rest of a request
+#define SERVER_OPTIONS_MAX 64           // Words on one "option" line
+#define SERVER_DEFAULT_IN_FLIGHT 4      // Jobs in flight per worker, by default
+
+
+// One end of a connection, with the bytes read from it but not yet used
+typedef struct
+{
+    int socket;
+    char *buffer;           // Bytes read from the socket
+    size_t position;        // First byte not yet used
+    size_t length;          // Bytes in the buffer
+    size_t capacity;        // Size of the buffer
+} Connection;
+
+
+// Function prototypes
+int RunServer(const char *path, const Settings *settings, int maxInFlight);
+int OpenConnection(Connection *connection, int socket);
+void CloseConnection(Connection *connection);
+char *ReadConnectionLine(Connection *connection);
+const char *ReadConnectionBytes(Connection *connection, size_t length);
+int SendToConnection(Connection *connection, const char *header, size_t headerLength,
+                     const char *body, size_t bodyLength);
+
+
+#endif
+// --- End of server.h
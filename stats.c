@@ -0,0 +1,219 @@
+// stats.c
+//
+// Per-job instrumentation: monotonic timers around each stage of a job and
+// the counters kept alongside them, printed as a table or as JSON
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// A stage is timed by a pair of clock readings, so a job costs about
+// twenty of them whatever its size. With statistics off the clock is
+// never read. The counters are added up per file or per output block, not
+// per value (see NumberReader and OutputBuffer). The memory counted is
+// the job's own buffers: vectors, parse and output buffers, resampling
+// and reduction working space.
+//
+// Each job's report is written with a single call, so reports from jobs
+// running at the same time in batch mode are not interleaved.
+//
+
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "stats.h"
+
+
+// Longest report, including the longest job folder name
+#define STATS_REPORT_MAX 8192
+
+// Names of the stages, in StatsStage order
+static const char *StageName[] = { "open", "allocate", "read", "check", "resample",
+                                   "transform", "reduce", "envelope", "emit", "cache", "total" };
+static const char *CacheName[] = { "none", "miss", "hit" };
+
+
+// Function name: BeginStage()
+// Purpose: Reads the monotonic clock if statistics are on, for EndStage().
+//
+double BeginStage(const JobStats *stats)
+{
+    struct timespec now;
+
+    if (!stats->enabled)
+    {
+        return(0.0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return(now.tv_sec + now.tv_nsec * 1e-9);
+}
+
+
+// Function name: EndStage()
+// Purpose: Adds the time since BeginStage() to a stage.
+//
+void EndStage(JobStats *stats, enum StatsStage stage, double start)
+{
+    struct timespec now;
+
+    if (!stats->enabled)
+    {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    stats->seconds[stage] += now.tv_sec + now.tv_nsec * 1e-9 - start;
+}
+
+
+// Function name: CountAllocation()
+// Purpose: Notes that the job acquired (or, if "bytes" is negative,
+//          released) a buffer, keeping track of the most it ever held.
+//
+void CountAllocation(JobStats *stats, long long bytes)
+{
+    stats->allocated += bytes;
+    if (stats->allocated > stats->peakAllocated)
+    {
+        stats->peakAllocated = stats->allocated;
+    }
+}
+
+
+// Function name: Rate()
+// Purpose: "amount" per second of "seconds", or 0 if no time was measured.
+//
+static double Rate(double amount, double seconds)
+{
+    return((seconds > 0.0) ? amount / seconds : 0.0);
+}
+
+
+// Function name: QuoteJson()
+// Purpose: Writes "text" as a JSON string (quotes and backslashes escaped,
+//          control characters dropped) at "cursor", within "room" bytes.
+//          Returns the number of bytes written.
+//
+static size_t QuoteJson(char *cursor, size_t room, const char *text)
+{
+    size_t length = 0;
+
+    if (room < 3)
+    {
+        return(0);
+    }
+    cursor[length++] = '"';
+    for (; *text != '\0' && length + 3 < room; text++)
+    {
+        if (*text == '"' || *text == '\\')
+        {
+            cursor[length++] = '\\';
+            cursor[length++] = *text;
+        }
+        else if ((unsigned char)*text >= ' ')
+        {
+            cursor[length++] = *text;
+        }
+    }
+    cursor[length++] = '"';
+    cursor[length] = '\0';
+
+    return(length);
+}
+
+
+// Function name: ReportStats()
+// Purpose: Prints one job's statistics to stdout in the given format.
+//          "directory" is the job's folder, or NULL for the current one.
+//
+void ReportStats(const JobStats *stats, const char *directory, enum StatsFormat format,
+                 int succeeded)
+{
+    char report[STATS_REPORT_MAX];
+    size_t length = 0;
+    double points = (double)stats->points[0] + stats->points[1];
+    double total = stats->seconds[StageTotal];
+    int thisStage;
+
+    if (format == NoStats)
+    {
+        return;
+    }
+
+    if (format == StatsJson)
+    {
+        length += snprintf(report + length, sizeof(report) - length, "{\"job\":");
+        length += QuoteJson(report + length, sizeof(report) - length,
+                            (directory != NULL) ? directory : ".");
+        length += snprintf(report + length, sizeof(report) - length,
+          ",\"succeeded\":%s,\"seconds\":{", succeeded ? "true" : "false");
+        for (thisStage = 0; thisStage < TOTAL_STATS_STAGES && length < sizeof(report); thisStage++)
+        {
+            length += snprintf(report + length, sizeof(report) - length, "%s\"%s\":%.9f",
+                               (thisStage > 0) ? "," : "", StageName[thisStage],
+                               stats->seconds[thisStage]);
+        }
+        if (length < sizeof(report))
+        {
+            snprintf(report + length, sizeof(report) - length,
+              "},\"bytes_read\":%lld,\"bytes_written\":%lld,\"lines_written\":%lld,"
+              "\"points\":{\"upper\":%d,\"lower\":%d},\"peak_allocated\":%lld,"
+              "\"parse_errors\":%d,\"cache\":\"%s\",\"points_per_second\":%.0f,\"read_mb_per_second\":%.3f,"
+              "\"write_mb_per_second\":%.3f}\n",
+              stats->bytesRead, stats->bytesWritten, stats->linesWritten,
+              stats->points[0], stats->points[1], stats->peakAllocated, stats->parseErrors,
+              CacheName[stats->cache], Rate(points, total), Rate(stats->bytesRead / 1e6, total),
+              Rate(stats->bytesWritten / 1e6, total));
+        }
+        fputs(report, stdout);
+        return;
+    }
+
+    length += snprintf(report + length, sizeof(report) - length, "Statistics for %s%s\n",
+                       (directory != NULL) ? directory : "the current folder",
+                       succeeded ? "" : " (failed)");
+    for (thisStage = 0; thisStage < TOTAL_STATS_STAGES && length < sizeof(report); thisStage++)
+    {
+        length += snprintf(report + length, sizeof(report) - length, "  %-10s %12.6f s %6.1f%%\n",
+                           StageName[thisStage], stats->seconds[thisStage],
+                           Rate(100.0 * stats->seconds[thisStage], total));
+    }
+    if (length < sizeof(report))
+    {
+        snprintf(report + length, sizeof(report) - length,
+          "  bytes read     %lld (%.1f MB/s)\n"
+          "  bytes written  %lld (%.1f MB/s)\n"
+          "  lines written  %lld\n"
+          "  points         %d upper, %d lower (%.0f points/s)\n"
+          "  peak memory    %lld bytes\n"
+          "  parse errors   %d\n"
+          "  cache          %s\n",
+          stats->bytesRead, Rate(stats->bytesRead / 1e6, total),
+          stats->bytesWritten, Rate(stats->bytesWritten / 1e6, total),
+          stats->linesWritten, stats->points[0], stats->points[1], Rate(points, total),
+          stats->peakAllocated, stats->parseErrors, CacheName[stats->cache]);
+    }
+    fputs(report, stdout);
+}
+
+
+// --- End of stats.c
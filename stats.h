@@ -0,0 +1,94 @@
+// stats.h
+//
+// Per-job stage timers and counters, printed with "--stats" (see stats.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef STATS_H         // Don't define everything more than once
+#define STATS_H         //
+
+
+// The stages of a job that are timed, in the order they run
+enum StatsStage
+{
+    StageOpen,              // Opening the input files and reading their
+                            //   headers, or mapping the section file
+    StageAllocate,          // Allocating the vectors
+    StageRead,              // Parsing the values
+    StageCheck,             // Checking the vectors agree
+    StageResample,          // ResampleVectors()
+    StageTransform,         // ApplyTransforms()
+    StageReduce,            // ReduceToolPaths()
+    StageEnvelope,          // CheckEnvelope() (see verify.c)
+    StageEmit,              // OutputGCode() (and, when streaming, reading)
+    StageCache,             // Looking the job up in the output cache and
+                            //   storing its output there (see cache.c)
+    StageTotal              // The whole job
+};
+#define TOTAL_STATS_STAGES 11
+
+// How the statistics are printed
+enum StatsFormat
+{
+    NoStats,                // Not at all: the timers are never read
+    StatsTable,             // As a table for people
+    StatsJson               // As one line of JSON per job
+};
+
+
+// What became of a job in the output cache
+enum CacheOutcome
+{
+    NotCached,              // There is no cache
+    CacheMiss,              // The output was made and stored
+    CacheHit                // The stored output was used
+};
+
+
+// What one job measured. The counters are always kept (they cost a few
+// additions per file or per block); the clock is only read if "enabled".
+typedef struct
+{
+    int enabled;            // Nonzero to time the stages
+    double seconds[TOTAL_STATS_STAGES];   // Time spent in each stage
+    long long bytesRead;    // Input bytes read (or mapped)
+    long long bytesWritten; // Output bytes written
+    long long linesWritten; // Output lines written
+    int points[2];          // Data points written for the Upper and Lower halves
+    long long allocated;    // Bytes of buffers the job holds right now,
+    long long peakAllocated;//   and the most it ever held at once
+    int parseErrors;        // Values that weren't numbers
+    enum CacheOutcome cache;
+} JobStats;
+
+
+// Function prototypes
+double BeginStage(const JobStats *stats);
+void EndStage(JobStats *stats, enum StatsStage stage, double start);
+void CountAllocation(JobStats *stats, long long bytes);
+void ReportStats(const JobStats *stats, const char *directory, enum StatsFormat format,
+                 int succeeded);
+
+
+#endif
+// --- End of stats.h
@@ -0,0 +1,131 @@
+// stream.c
+//
+// Streaming mode: reads the four input files of an airfoil half in
+// lockstep and writes each point as soon as it has been read
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// Every line of a half only needs point i of ROOT<half>X, ROOT<half>Y,
+// TIP<half>X and TIP<half>Y, so nothing has to be kept once it is written.
+// Memory use is the eight parse blocks plus the output block, whatever the
+// point count in the file headers says. Output is the same as when the
+// vectors are loaded first, as long as the four files of a half hold the
+// points they list; loading would resample a half whose files disagree,
+// which takes every point at once.
+//
+
+
+#include <stdlib.h>
+
+#include "gcode.h"
+#include "emit.h"
+#include "feed.h"
+#include "stream.h"
+
+
+// Function name: StreamHalf()
+// Purpose: Reads and writes every data point of one airfoil half. Only
+//          whole points are written: the half ends with the vector that
+//          lists the fewest points, or as soon as any of the four files
+//          runs out, so a header that overstates its count can't make up
+//          moves. Each side's placement is applied to every point, and its
+//          feed planned.
+//
+int StreamHalf(Job *job, OutputBuffer *output, enum Half thisHalf)
+{
+    // The four vectors of a line, in the order they are written
+    static const enum Side LineSide[] = { Root, Root, Tip, Tip };
+    static const enum Dimension LineDimension[] = { X, Y, X, Y };
+
+    Vector *thisInput[4];
+    float point[4];
+    double scale = job->settings->dialect.scale;
+    int totalValues;
+    int thisValue;
+    int thisAxis;
+    int result;
+
+    char filename[MAX_PATH_LENGTH];
+
+    for (thisAxis = 0; thisAxis < 4; thisAxis++)
+    {
+        thisInput[thisAxis] =
+          &job->thisVector[LineSide[thisAxis]][thisHalf][LineDimension[thisAxis]];
+    }
+    totalValues = thisInput[0]->totalValues;
+    for (thisAxis = 1; thisAxis < 4; thisAxis++)
+    {
+        if (thisInput[thisAxis]->totalValues < totalValues)
+        {
+            totalValues = thisInput[thisAxis]->totalValues;
+        }
+    }
+
+    for (thisValue = 0; thisValue < totalValues; thisValue++)
+    {
+        for (thisAxis = 0; thisAxis < 4; thisAxis++)
+        {
+            result = ReadFloat(&thisInput[thisAxis]->reader, &point[thisAxis]);
+            // See if a compressed file turned out to be damaged or cut short
+            if (thisInput[thisAxis]->reader.damaged)
+            {
+                FindVectorFile(job, LineSide[thisAxis], thisHalf, LineDimension[thisAxis],
+                               filename);
+                ReportMessage(job, MESSAGE_ERROR, MESSAGE_FILE_DAMAGEDERROR, filename);
+                return(EXIT_FAILURE);
+            }
+            // See if End-of-File was reached unexpectedly
+            if (result == PARSE_EOF)
+            {
+                // If it was, the half ends with the last whole point
+                ReportMessage(job, MESSAGE_WARNING, MESSAGE_VECTOR_EOF);
+                return(EXIT_SUCCESS);
+            }
+            // See if the value wasn't a number
+            else if (result == PARSE_BAD)
+            {
+                // If it wasn't...
+                ReportParseError(job, LineSide[thisAxis], thisHalf, LineDimension[thisAxis]);
+                return(EXIT_FAILURE);
+            }
+        }
+
+        // Place each side, as ApplyTransforms() does for loaded vectors
+        if (job->transformed[Root])
+        {
+            TransformPoint(&job->transform[Root], &point[0], &point[1]);
+        }
+        if (job->transformed[Tip])
+        {
+            TransformPoint(&job->transform[Tip], &point[2], &point[3]);
+        }
+
+        PlanPoint(&job->planner, output,
+                  SCALE_COORDINATE(point[0], scale), SCALE_COORDINATE(point[1], scale),
+                  SCALE_COORDINATE(point[2], scale), SCALE_COORDINATE(point[3], scale));
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// --- End of stream.c
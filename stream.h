@@ -0,0 +1,39 @@
+// stream.h
+//
+// Streaming mode: writes points while they are read (see stream.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef STREAM_H        // Don't define everything more than once
+#define STREAM_H        //
+
+#include "gcode.h"
+#include "emit.h"
+
+
+// Function prototypes
+int StreamHalf(Job *job, OutputBuffer *output, enum Half thisHalf);
+
+
+#endif
+// --- End of stream.h
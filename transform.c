@@ -0,0 +1,303 @@
+// transform.c
+//
+// Places each side of the wing: chord scale, twist (washout) about a
+// pivot, sweep and dihedral offsets, and mirroring, composed into a single
+// affine transform that is applied to whole arrays at once
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// On x86 the arrays are transformed eight points at a time with AVX when
+// the processor has it (chosen at run time), otherwise four at a time with
+// SSE. Every path does the same float operations in the same order, so the
+// results don't depend on which one ran.
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "transform.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define HAVE_SSE_PATH
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX_PATH
+#endif
+
+
+#define DEGREES_TO_RADIANS (3.14159265358979323846 / 180.0)
+
+
+// Function name: InitializeTransform()
+// Purpose: Sets a side transform to one that leaves the side unchanged.
+//
+void InitializeTransform(SideTransform *transform)
+{
+    memset(transform, 0, sizeof(SideTransform));
+    transform->scale = 1.0;
+}
+
+
+// Function name: IsIdentityTransform()
+// Purpose: True if the transform leaves every point where it is, so the
+//          transform stage can be skipped altogether.
+//
+int IsIdentityTransform(const SideTransform *transform)
+{
+    return(transform->scale == 1.0 && transform->twist == 0.0 &&
+           transform->sweep == 0.0 && transform->dihedral == 0.0 &&
+           !transform->mirror);
+}
+
+
+// Function name: ParseNumber()
+// Purpose: Reads one number of a transform description and steps past it.
+//          Returns 0 if there is no number there.
+//
+static int ParseNumber(const char **cursor, double *value)
+{
+    char *end;
+
+    *value = strtod(*cursor, &end);
+    if (end == *cursor)
+    {
+        return(0);
+    }
+    *cursor = end;
+
+    return(1);
+}
+
+
+// Function name: ParseTransform()
+// Purpose: Fills in a side transform from a comma-separated description
+//          such as "scale=0.6,twist=-2,pivot=0.25:0,sweep=0.4,dihedral=0.1"
+//          or "mirror". Settings that aren't mentioned are left as they
+//          are. Returns EXIT_FAILURE if the description can't be understood.
+//
+int ParseTransform(const char *text, SideTransform *transform)
+{
+    const char *cursor = text;
+    int parsed;
+
+    while (*cursor != '\0')
+    {
+        if (strncmp(cursor, "scale=", 6) == 0)
+        {
+            cursor += 6;
+            parsed = ParseNumber(&cursor, &transform->scale);
+        }
+        else if (strncmp(cursor, "twist=", 6) == 0)
+        {
+            cursor += 6;
+            parsed = ParseNumber(&cursor, &transform->twist);
+        }
+        else if (strncmp(cursor, "pivot=", 6) == 0)
+        {
+            cursor += 6;
+            parsed = ParseNumber(&cursor, &transform->pivotX) && *cursor++ == ':' &&
+                     ParseNumber(&cursor, &transform->pivotY);
+        }
+        else if (strncmp(cursor, "sweep=", 6) == 0)
+        {
+            cursor += 6;
+            parsed = ParseNumber(&cursor, &transform->sweep);
+        }
+        else if (strncmp(cursor, "dihedral=", 9) == 0)
+        {
+            cursor += 9;
+            parsed = ParseNumber(&cursor, &transform->dihedral);
+        }
+        else if (strncmp(cursor, "mirror", 6) == 0)
+        {
+            cursor += 6;
+            transform->mirror = 1;
+            parsed = 1;
+        }
+        else
+        {
+            parsed = 0;
+        }
+
+        // Every setting must be followed by a comma or the end
+        if (!parsed || (*cursor != ',' && *cursor != '\0'))
+        {
+            return(EXIT_FAILURE);
+        }
+        if (*cursor == ',')
+        {
+            cursor++;
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ComposeTransform()
+// Purpose: Works out the single affine transform that does everything a
+//          side transform asks for.
+//
+void ComposeTransform(const SideTransform *transform, AffineTransform *affine)
+{
+    double angle;
+    double cosine;
+    double sine;
+    double mirror;
+    double pivotX;
+    double pivotY;
+    double offsetX;
+    double offsetY;
+
+    // Leading edge up is a clockwise rotation with X running aft
+    angle = -transform->twist * DEGREES_TO_RADIANS;
+    cosine = cos(angle);
+    sine = sin(angle);
+    mirror = transform->mirror ? -1.0 : 1.0;
+
+    // The pivot is given before scaling, so it moves with the chord
+    pivotX = transform->scale * transform->pivotX;
+    pivotY = transform->scale * transform->pivotY;
+
+    // p' = M (R (s p - c) + c + o), with c the scaled pivot and o the offsets
+    offsetX = pivotX - (cosine * pivotX - sine * pivotY) + transform->sweep;
+    offsetY = pivotY - (sine * pivotX + cosine * pivotY) + transform->dihedral;
+
+    affine->xx = (float)(mirror * transform->scale * cosine);
+    affine->xy = (float)(-mirror * transform->scale * sine);
+    affine->x0 = (float)(mirror * offsetX);
+    affine->yx = (float)(transform->scale * sine);
+    affine->yy = (float)(transform->scale * cosine);
+    affine->y0 = (float)offsetY;
+}
+
+
+// Function name: TransformPoint()
+// Purpose: Transforms a single point in place.
+//
+void TransformPoint(const AffineTransform *affine, float *x, float *y)
+{
+    float pointX = *x;
+    float pointY = *y;
+
+    *x = affine->xx * pointX + affine->xy * pointY + affine->x0;
+    *y = affine->yx * pointX + affine->yy * pointY + affine->y0;
+}
+
+
+#ifdef HAVE_AVX_PATH
+// Function name: TransformAVX()
+// Purpose: Transforms points eight at a time. Returns how many points it
+//          did; the caller finishes off the rest.
+//
+__attribute__((target("avx")))
+static int TransformAVX(const AffineTransform *affine, float *x, float *y, int totalValues)
+{
+    __m256 xx = _mm256_set1_ps(affine->xx);
+    __m256 xy = _mm256_set1_ps(affine->xy);
+    __m256 x0 = _mm256_set1_ps(affine->x0);
+    __m256 yx = _mm256_set1_ps(affine->yx);
+    __m256 yy = _mm256_set1_ps(affine->yy);
+    __m256 y0 = _mm256_set1_ps(affine->y0);
+    __m256 pointX;
+    __m256 pointY;
+    int thisValue;
+
+    for (thisValue = 0; thisValue + 8 <= totalValues; thisValue += 8)
+    {
+        pointX = _mm256_loadu_ps(x + thisValue);
+        pointY = _mm256_loadu_ps(y + thisValue);
+        _mm256_storeu_ps(x + thisValue,
+          _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xx, pointX), _mm256_mul_ps(xy, pointY)), x0));
+        _mm256_storeu_ps(y + thisValue,
+          _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(yx, pointX), _mm256_mul_ps(yy, pointY)), y0));
+    }
+
+    return(thisValue);
+}
+#endif
+
+
+#ifdef HAVE_SSE_PATH
+// Function name: TransformSSE()
+// Purpose: Transforms points four at a time. Returns how many points it
+//          did; the caller finishes off the rest.
+//
+static int TransformSSE(const AffineTransform *affine, float *x, float *y, int totalValues)
+{
+    __m128 xx = _mm_set1_ps(affine->xx);
+    __m128 xy = _mm_set1_ps(affine->xy);
+    __m128 x0 = _mm_set1_ps(affine->x0);
+    __m128 yx = _mm_set1_ps(affine->yx);
+    __m128 yy = _mm_set1_ps(affine->yy);
+    __m128 y0 = _mm_set1_ps(affine->y0);
+    __m128 pointX;
+    __m128 pointY;
+    int thisValue;
+
+    for (thisValue = 0; thisValue + 4 <= totalValues; thisValue += 4)
+    {
+        pointX = _mm_loadu_ps(x + thisValue);
+        pointY = _mm_loadu_ps(y + thisValue);
+        _mm_storeu_ps(x + thisValue,
+          _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, pointX), _mm_mul_ps(xy, pointY)), x0));
+        _mm_storeu_ps(y + thisValue,
+          _mm_add_ps(_mm_add_ps(_mm_mul_ps(yx, pointX), _mm_mul_ps(yy, pointY)), y0));
+    }
+
+    return(thisValue);
+}
+#endif
+
+
+// Function name: TransformArrays()
+// Purpose: Transforms every point of a pair of X and Y arrays in place,
+//          using the widest vector instructions the processor has.
+//
+void TransformArrays(const AffineTransform *affine, float *x, float *y, int totalValues)
+{
+    int thisValue = 0;
+
+#ifdef HAVE_AVX_PATH
+    if (__builtin_cpu_supports("avx"))
+    {
+        thisValue = TransformAVX(affine, x, y, totalValues);
+    }
+#endif
+#ifdef HAVE_SSE_PATH
+    thisValue += TransformSSE(affine, x + thisValue, y + thisValue, totalValues - thisValue);
+#endif
+
+    // Whatever is left over, or everything on other processors
+    for (; thisValue < totalValues; thisValue++)
+    {
+        TransformPoint(affine, &x[thisValue], &y[thisValue]);
+    }
+}
+
+
+// --- End of transform.c
@@ -0,0 +1,64 @@
+// transform.h
+//
+// Geometry transforms applied to each side of the wing (see transform.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef TRANSFORM_H     // Don't define everything more than once
+#define TRANSFORM_H     //
+
+
+// How one side (Root or Tip) of the wing is placed, in the units of the
+// input files (before the profile's coordinate scale). The steps are
+// applied in this order: scale, twist, offsets, mirror.
+typedef struct
+{
+    double scale;           // Chord scale, about the origin
+    double twist;           // Degrees, positive = leading edge up (so washout
+                            //   is a negative tip twist), about the pivot
+    double pivotX;          // Twist pivot, before scaling (e.g. 0.25 for the
+    double pivotY;          //   quarter chord of a unit-chord section)
+    double sweep;           // Added to X after the twist
+    double dihedral;        // Added to Y after the twist
+    int mirror;             // Nonzero to flip X (the opposite-hand panel)
+} SideTransform;
+
+// The composed transform: x' = xx*x + xy*y + x0, y' = yx*x + yy*y + y0
+typedef struct
+{
+    float xx, xy, x0;
+    float yx, yy, y0;
+} AffineTransform;
+
+
+// Function prototypes
+void InitializeTransform(SideTransform *transform);
+int ParseTransform(const char *text, SideTransform *transform);
+int IsIdentityTransform(const SideTransform *transform);
+void ComposeTransform(const SideTransform *transform, AffineTransform *affine);
+void TransformArrays(const AffineTransform *affine, float *x, float *y, int totalValues);
+void TransformPoint(const AffineTransform *affine, float *x, float *y);
+
+
+#endif
+// --- End of transform.h
@@ -0,0 +1,978 @@
+// verify.c
+//
+// Verification: the envelope check run before a job is written, and the
+// G-code reader that simulates a finished program (see verify.h)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// Before a job is written, CheckEnvelope() finds the range of each of the
+// four axes over the placed, reduced values in memory and refuses the job
+// if the profile's scale takes any of them past the cutter's limits, or if
+// a fitted arc reaches past them between its points. On
+// x86 each range is found eight values at a time with AVX when the
+// processor has it, otherwise four at a time with SSE (as transform.c
+// does), so the check costs a fraction of reading the values.
+//
+// VerifyGCode() reads a finished program (this program's or anyone's,
+// gzip-compressed or not) back in one pass, a large block at a time, and
+// follows the wire through it: where each end goes, how far apart they
+// get, and how long the cutting moves take at their feeds. The controller
+// runs a move at F along the combined X, Y, U, V path (see feed.c), and
+// the wire is taken to start at 0 on every axis.
+//
+// Only what the program writes is understood: G0 to G3, G20/G21, G90/G91,
+// F, the profile's four axis letters and I/J. Other words (N, M, S, ...)
+// are stepped over, as are comments in parentheses or after ';'.
+//
+
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcode.h"
+#include "verify.h"
+#include "compress.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define HAVE_SSE_PATH
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_AVX_PATH
+#endif
+
+
+#define TWO_PI (2.0 * 3.14159265358979323846)
+
+// Digits of a number that are kept. Whole-number digits past these only
+// scale it, and fraction digits past them are dropped.
+#define VERIFY_DIGITS_MAX 18
+
+
+// Powers of ten a number's fraction is divided by. Up to 15 digits, both
+// the digits and these are exact, so the quotient is as close as a double
+// can be.
+static const double PowerOfTen[VERIFY_DIGITS_MAX + 1] =
+  { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18 };
+
+
+// Where the wire is, and what the next move will be
+typedef struct
+{
+    const Dialect *dialect;
+    VerifyReport *report;
+    signed char axis[256];  // Axis (0 to 3) of each letter, or -1
+    double position[4];     // X, Y, U, V
+    int motion;             // Modal G0, G1, G2 or G3
+    int incremental;        // Nonzero after G91
+    double feed;            // F in effect (0 = none yet)
+    long long line;         // Line being simulated
+} Simulator;
+
+
+
+#ifdef HAVE_AVX_PATH
+// Function name: RangeAVX()
+// Purpose: Widens "minimum" and "maximum" to take in values eight at a
+//          time. Returns how many values it did; the caller finishes off
+//          the rest.
+//
+__attribute__((target("avx")))
+static int RangeAVX(const float *value, int totalValues, float *minimum, float *maximum)
+{
+    __m256 low = _mm256_set1_ps(*minimum);
+    __m256 high = _mm256_set1_ps(*maximum);
+    __m256 point;
+    float lane[2][8];
+    int thisValue;
+    int thisLane;
+
+    for (thisValue = 0; thisValue + 8 <= totalValues; thisValue += 8)
+    {
+        point = _mm256_loadu_ps(value + thisValue);
+        low = _mm256_min_ps(low, point);
+        high = _mm256_max_ps(high, point);
+    }
+
+    _mm256_storeu_ps(lane[0], low);
+    _mm256_storeu_ps(lane[1], high);
+    for (thisLane = 0; thisLane < 8; thisLane++)
+    {
+        *minimum = (lane[0][thisLane] < *minimum) ? lane[0][thisLane] : *minimum;
+        *maximum = (lane[1][thisLane] > *maximum) ? lane[1][thisLane] : *maximum;
+    }
+
+    return(thisValue);
+}
+#endif
+
+
+#ifdef HAVE_SSE_PATH
+// Function name: RangeSSE()
+// Purpose: Widens "minimum" and "maximum" to take in values four at a time.
+//          Returns how many values it did; the caller finishes off the
+//          rest.
+//
+static int RangeSSE(const float *value, int totalValues, float *minimum, float *maximum)
+{
+    __m128 low = _mm_set1_ps(*minimum);
+    __m128 high = _mm_set1_ps(*maximum);
+    __m128 point;
+    float lane[2][4];
+    int thisValue;
+    int thisLane;
+
+    for (thisValue = 0; thisValue + 4 <= totalValues; thisValue += 4)
+    {
+        point = _mm_loadu_ps(value + thisValue);
+        low = _mm_min_ps(low, point);
+        high = _mm_max_ps(high, point);
+    }
+
+    _mm_storeu_ps(lane[0], low);
+    _mm_storeu_ps(lane[1], high);
+    for (thisLane = 0; thisLane < 4; thisLane++)
+    {
+        *minimum = (lane[0][thisLane] < *minimum) ? lane[0][thisLane] : *minimum;
+        *maximum = (lane[1][thisLane] > *maximum) ? lane[1][thisLane] : *maximum;
+    }
+
+    return(thisValue);
+}
+#endif
+
+
+// Function name: FindRange()
+// Purpose: Finds the least and greatest of "totalValues" (at least one)
+//          values, using the widest vector instructions the processor has.
+//
+void FindRange(const float *value, int totalValues, float *minimum, float *maximum)
+{
+    int thisValue = 0;
+
+    *minimum = value[0];
+    *maximum = value[0];
+
+#ifdef HAVE_AVX_PATH
+    if (__builtin_cpu_supports("avx"))
+    {
+        thisValue = RangeAVX(value, totalValues, minimum, maximum);
+    }
+#endif
+#ifdef HAVE_SSE_PATH
+    thisValue += RangeSSE(value + thisValue, totalValues - thisValue, minimum, maximum);
+#endif
+
+    // Whatever is left over, or everything on other processors
+    for (; thisValue < totalValues; thisValue++)
+    {
+        *minimum = (value[thisValue] < *minimum) ? value[thisValue] : *minimum;
+        *maximum = (value[thisValue] > *maximum) ? value[thisValue] : *maximum;
+    }
+}
+
+
+// Function name: ArcSweep()
+// Purpose: Returns the angle, in radians, an arc in the X/Y plane turns
+//          through from "start" to "end" around "center", in its direction.
+//          An arc that ends where it starts is a full circle.
+//
+static double ArcSweep(const double *start, const double *end, const double *center,
+                       int clockwise)
+{
+    double sweep = atan2(end[1] - center[1], end[0] - center[0]) -
+                   atan2(start[1] - center[1], start[0] - center[0]);
+
+    if (clockwise)
+    {
+        sweep = -sweep;
+    }
+    sweep = fmod(sweep, TWO_PI);
+    if (sweep < 0.0)
+    {
+        sweep += TWO_PI;
+    }
+    if (sweep == 0.0)
+    {
+        sweep = TWO_PI;
+    }
+
+    return(sweep);
+}
+
+
+// Function name: ArcQuadrants()
+// Purpose: Returns which sides of its circle an arc reaches on its way
+//          round, as bits: 1 for its greatest X, 2 for its greatest Y, 4
+//          for its least X and 8 for its least Y. The arc starts at (-i, -j)
+//          from its center and turns through "sweep" (see ArcSweep()).
+//
+static int ArcQuadrants(double i, double j, double sweep, int clockwise)
+{
+    double startAngle = atan2(-j, -i);
+    double angle;
+    int quadrant;
+    int reached = 0;
+
+    for (quadrant = 0; quadrant < 4; quadrant++)
+    {
+        angle = (clockwise ? startAngle - quadrant * (TWO_PI / 4.0) :
+                             quadrant * (TWO_PI / 4.0) - startAngle);
+        angle = fmod(angle, TWO_PI);
+        if (angle < 0.0)
+        {
+            angle += TWO_PI;
+        }
+        if (angle < sweep)
+        {
+            reached |= 1 << quadrant;
+        }
+    }
+
+    return(reached);
+}
+
+
+// Function name: WidenForArcs()
+// Purpose: Widens the scaled range of a root axis of a reduced half to
+//          take in the sides of their circles its arcs reach between the
+//          points they join, which the points alone don't show. The arcs
+//          are taken exactly as they are written (see OutputLine()).
+//
+static void WidenForArcs(const Job *job, enum Half thisHalf, enum Dimension thisDimension,
+                         float *minimum, float *maximum)
+{
+    const ToolPath *path = &job->path[thisHalf];
+    const float *rootX = job->thisVector[Root][thisHalf][X].value;
+    const float *rootY = job->thisVector[Root][thisHalf][Y].value;
+    double scale = job->settings->dialect.scale;
+    const Move *thisMove;
+    double start[2];
+    double end[2];
+    double center[2];
+    double i;
+    double j;
+    double radius;
+    int clockwise;
+    int reached;
+    int thisIndex;
+
+    // The first move is always a line to the first point
+    for (thisIndex = 1; thisIndex < path->totalMoves; thisIndex++)
+    {
+        thisMove = &path->move[thisIndex];
+        if (thisMove->type == LineMove)
+        {
+            continue;
+        }
+
+        start[0] = SCALE_COORDINATE(rootX[path->move[thisIndex - 1].index], scale);
+        start[1] = SCALE_COORDINATE(rootY[path->move[thisIndex - 1].index], scale);
+        end[0] = SCALE_COORDINATE(rootX[thisMove->index], scale);
+        end[1] = SCALE_COORDINATE(rootY[thisMove->index], scale);
+        i = SCALE_COORDINATE(thisMove->centerI, scale);
+        j = SCALE_COORDINATE(thisMove->centerJ, scale);
+        center[0] = start[0] + i;
+        center[1] = start[1] + j;
+        radius = sqrt(i * i + j * j);
+        clockwise = (thisMove->type == ClockwiseArc);
+        reached = ArcQuadrants(i, j, ArcSweep(start, end, center, clockwise), clockwise);
+
+        if ((reached & (1 << thisDimension)) && center[thisDimension] + radius > *maximum)
+        {
+            *maximum = (float)(center[thisDimension] + radius);
+        }
+        if ((reached & (4 << thisDimension)) && center[thisDimension] - radius < *minimum)
+        {
+            *minimum = (float)(center[thisDimension] - radius);
+        }
+    }
+}
+
+
+// Function name: CheckEnvelope()
+// Purpose: Makes sure every point the job is about to write, once scaled by
+//          the profile, is inside the cutter's limits: X and U between
+//          x_min and x_max, Y and V between y_min and y_max, and that no
+//          arc bulges past them between its points. Reports the
+//          first axis that isn't and returns EXIT_FAILURE. Halves that
+//          weren't loaded, and streamed jobs, whose points aren't in
+//          memory yet, are let through.
+//
+int CheckEnvelope(Job *job)
+{
+    const Dialect *dialect = &job->settings->dialect;
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+
+    const Vector *thisVector;
+    int totalPoints;
+    float minimum;
+    float maximum;
+    float swap;
+    double limit[2][2];     // Least and greatest X, then Y
+
+    if (job->streaming)
+    {
+        return(EXIT_SUCCESS);
+    }
+
+    limit[X][0] = dialect->xMin - VERIFY_TOLERANCE;
+    limit[X][1] = dialect->xMax + VERIFY_TOLERANCE;
+    limit[Y][0] = dialect->yMin - VERIFY_TOLERANCE;
+    limit[Y][1] = dialect->yMax + VERIFY_TOLERANCE;
+
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        // As many points as OutputHalf() writes
+        totalPoints = job->thisVector[Tip][thisHalf][X].totalValues;
+        for (thisSide = Root; thisSide <= Tip; thisSide++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                thisVector = &job->thisVector[thisSide][thisHalf][thisDimension];
+                if (thisVector->value == NULL || totalPoints <= 0)
+                {
+                    continue;
+                }
+
+                FindRange(thisVector->value, totalPoints, &minimum, &maximum);
+                minimum = SCALE_COORDINATE(minimum, dialect->scale);
+                maximum = SCALE_COORDINATE(maximum, dialect->scale);
+                if (minimum > maximum)
+                {
+                    swap = minimum;
+                    minimum = maximum;
+                    maximum = swap;
+                }
+                if (thisSide == Root && job->reduced && job->path[thisHalf].totalArcs > 0)
+                {
+                    WidenForArcs(job, thisHalf, thisDimension, &minimum, &maximum);
+                }
+
+                if (minimum < limit[thisDimension][0] || maximum > limit[thisDimension][1])
+                {
+                    ReportMessage(job, MESSAGE_ERROR, MESSAGE_ENVELOPE_ERROR,
+                                  HalfToString[thisHalf],
+                                  dialect->axis[thisSide * 2 + thisDimension],
+                                  minimum, maximum,
+                                  (thisDimension == X) ? dialect->xMin : dialect->yMin,
+                                  (thisDimension == X) ? dialect->xMax : dialect->yMax);
+                    return(EXIT_FAILURE);
+                }
+            }
+        }
+    }
+
+    return(EXIT_SUCCESS);
+}
+
+
+// Function name: ParseValue()
+// Purpose: Reads the number a word of G-code starts with, from "cursor" up
+//          to "end". Returns where it ends, or NULL if there isn't one.
+//          G-code numbers have no exponents, so the digits are added up
+//          directly rather than handed to strtod().
+//
+static const char *ParseValue(const char *cursor, const char *end, double *value)
+{
+    const char *start;
+    unsigned long long digits = 0;
+    unsigned int digit;
+    int totalDigits;
+    int fractionDigits = 0;
+    int skippedDigits = 0;  // Whole-number digits past VERIFY_DIGITS_MAX
+    int negative = 0;
+    int sawDigit;
+
+    if (cursor < end && (*cursor == '-' || *cursor == '+'))
+    {
+        negative = (*cursor == '-');
+        cursor++;
+    }
+
+    // The whole number, then the fraction: one compare per digit
+    start = cursor;
+    while (cursor < end && (digit = (unsigned int)(*cursor - '0')) < 10)
+    {
+        if (cursor - start < VERIFY_DIGITS_MAX)
+        {
+            digits = digits * 10 + digit;
+        }
+        else
+        {
+            skippedDigits++;
+        }
+        cursor++;
+    }
+    totalDigits = (int)(cursor - start) - skippedDigits;
+    sawDigit = (cursor > start);
+    if (cursor < end && *cursor == '.')
+    {
+        cursor++;
+        start = cursor;
+        while (cursor < end && (digit = (unsigned int)(*cursor - '0')) < 10)
+        {
+            if (totalDigits + fractionDigits < VERIFY_DIGITS_MAX && skippedDigits == 0)
+            {
+                digits = digits * 10 + digit;
+                fractionDigits++;
+            }
+            cursor++;
+        }
+        sawDigit |= (cursor > start);
+    }
+    if (!sawDigit)
+    {
+        return(NULL);
+    }
+
+    if (skippedDigits > 0)
+    {
+        *value = (double)digits * pow(10.0, skippedDigits);
+    }
+    else
+    {
+        *value = (double)digits / PowerOfTen[fractionDigits];
+    }
+    if (negative)
+    {
+        *value = -*value;
+    }
+
+    return(cursor);
+}
+
+
+// Function name: CheckPosition()
+// Purpose: Widens the report's range of one axis to take in "value", and
+//          counts the move it belongs to if that is past the limits (once
+//          per move).
+//
+static void CheckPosition(Simulator *simulator, int thisAxis, double value, int *violated)
+{
+    VerifyReport *report = simulator->report;
+    const Dialect *dialect = simulator->dialect;
+    double minimum = (thisAxis % 2 == 0) ? dialect->xMin : dialect->yMin;
+    double maximum = (thisAxis % 2 == 0) ? dialect->xMax : dialect->yMax;
+
+    if (value < report->minimum[thisAxis])
+    {
+        report->minimum[thisAxis] = value;
+    }
+    if (value > report->maximum[thisAxis])
+    {
+        report->maximum[thisAxis] = value;
+    }
+
+    if (!*violated && (value < minimum - VERIFY_TOLERANCE || value > maximum + VERIFY_TOLERANCE))
+    {
+        *violated = 1;
+        if (report->violations == 0)
+        {
+            report->firstViolation = simulator->line;
+            report->violationAxis = thisAxis;
+        }
+        report->violations++;
+    }
+}
+
+
+// Function name: SimulateMove()
+// Purpose: Moves the wire to "target" (X, Y, U, V) the way the modal motion
+//          says, adding the move to the report. An arc turns around the
+//          point (i, j) from where it starts, in the X/Y plane, while U/V
+//          move in a straight line.
+//
+static void SimulateMove(Simulator *simulator, const double *target, double i, double j,
+                         int hasCenter)
+{
+    VerifyReport *report = simulator->report;
+    double *position = simulator->position;
+    double center[2];
+    double radius;
+    double sweep;
+    double root;
+    double tip;
+    double length;
+    double skew[2];
+    double distance;
+    int clockwise;
+    int quadrant;
+    int reached;
+    int violated = 0;
+    int thisAxis;
+
+    tip = sqrt((target[2] - position[2]) * (target[2] - position[2]) +
+               (target[3] - position[3]) * (target[3] - position[3]));
+
+    if (simulator->motion >= 2)
+    {
+        if (!hasCenter)
+        {
+            // Without a center there is no arc to follow
+            if (report->badLines == 0)
+            {
+                report->firstBadLine = simulator->line;
+            }
+            report->badLines++;
+            return;
+        }
+
+        // The arc's length, and the sides of its circle it reaches
+        clockwise = (simulator->motion == 2);
+        center[0] = position[0] + i;
+        center[1] = position[1] + j;
+        radius = sqrt(i * i + j * j);
+        sweep = ArcSweep(position, target, center, clockwise);
+        root = radius * sweep;
+
+        reached = ArcQuadrants(i, j, sweep, clockwise);
+        for (quadrant = 0; quadrant < 4; quadrant++)
+        {
+            if (reached & (1 << quadrant))
+            {
+                CheckPosition(simulator, quadrant % 2,
+                              center[quadrant % 2] + ((quadrant < 2) ? radius : -radius),
+                              &violated);
+            }
+        }
+        report->arcMoves++;
+    }
+    else
+    {
+        root = sqrt((target[0] - position[0]) * (target[0] - position[0]) +
+                    (target[1] - position[1]) * (target[1] - position[1]));
+    }
+
+    length = sqrt(root * root + tip * tip);
+    if (simulator->motion == 0)
+    {
+        report->rapidMoves++;
+        report->rapidLength += length;
+    }
+    else
+    {
+        report->cuttingMoves++;
+        report->cutLength += length;
+        if (simulator->feed > 0.0)
+        {
+            report->cutTime += length / simulator->feed;
+        }
+        else
+        {
+            report->unfedMoves++;
+        }
+    }
+
+    for (thisAxis = 0; thisAxis < 4; thisAxis++)
+    {
+        position[thisAxis] = target[thisAxis];
+        CheckPosition(simulator, thisAxis, target[thisAxis], &violated);
+    }
+
+    // How far the tip end of the wire is from the root end
+    skew[0] = position[2] - position[0];
+    skew[1] = position[3] - position[1];
+    for (thisAxis = 0; thisAxis < 2; thisAxis++)
+    {
+        if (skew[thisAxis] < report->minSkew[thisAxis])
+        {
+            report->minSkew[thisAxis] = skew[thisAxis];
+        }
+        if (skew[thisAxis] > report->maxSkew[thisAxis])
+        {
+            report->maxSkew[thisAxis] = skew[thisAxis];
+        }
+    }
+    distance = sqrt(skew[0] * skew[0] + skew[1] * skew[1]);
+    if (distance > report->greatestSkew)
+    {
+        report->greatestSkew = distance;
+        report->greatestSkewLine = simulator->line;
+    }
+}
+
+
+// Function name: SimulateLine()
+// Purpose: Reads the words of one line, from "cursor" up to "end", and
+//          simulates the move it makes, if any. A line with a word that
+//          isn't a letter and a number is counted and otherwise skipped.
+//
+static void SimulateLine(Simulator *simulator, const char *cursor, const char *end)
+{
+    VerifyReport *report = simulator->report;
+    double target[4];
+    double value;
+    double i = 0.0;
+    double j = 0.0;
+    int hasCenter = 0;
+    int moved = 0;
+    int motion = simulator->motion;
+    int incremental = simulator->incremental;
+    int thisAxis;
+    char letter;
+
+    memcpy(target, simulator->position, sizeof(target));
+
+    while (cursor < end)
+    {
+        letter = *cursor++;
+        if (letter == ' ' || letter == '\t' || letter == '\r' || letter == '%')
+        {
+            continue;
+        }
+        if (letter == ';')
+        {
+            break;
+        }
+        if (letter == '(')
+        {
+            cursor = memchr(cursor, ')', end - cursor);
+            if (cursor == NULL)
+            {
+                break;
+            }
+            cursor++;
+            continue;
+        }
+
+        if (letter >= 'a' && letter <= 'z')
+        {
+            letter = letter - 'a' + 'A';
+        }
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+        {
+            cursor++;
+        }
+        if (letter < 'A' || letter > 'Z' ||
+            (cursor = ParseValue(cursor, end, &value)) == NULL)
+        {
+            if (report->badLines == 0)
+            {
+                report->firstBadLine = simulator->line;
+            }
+            report->badLines++;
+            return;
+        }
+
+        thisAxis = simulator->axis[(unsigned char)letter];
+        if (thisAxis >= 0)
+        {
+            target[thisAxis] = incremental ? target[thisAxis] + value : value;
+            moved = 1;
+        }
+        else if (letter == 'G')
+        {
+            if (value == 0.0 || value == 1.0 || value == 2.0 || value == 3.0)
+            {
+                motion = (int)value;
+            }
+            else if (value == 20.0 || value == 21.0)
+            {
+                report->units = (int)value;
+            }
+            else if (value == 90.0 || value == 91.0)
+            {
+                incremental = (value == 91.0);
+            }
+        }
+        else if (letter == 'F')
+        {
+            simulator->feed = value;
+        }
+        else if (letter == 'I')
+        {
+            i = value;
+            hasCenter = 1;
+        }
+        else if (letter == 'J')
+        {
+            j = value;
+            hasCenter = 1;
+        }
+    }
+
+    simulator->motion = motion;
+    simulator->incremental = incremental;
+    if (moved)
+    {
+        SimulateMove(simulator, target, i, j, hasCenter);
+    }
+}
+
+
+// Function name: InitializeReport()
+// Purpose: Empties a report before a program is read into it.
+//
+static void InitializeReport(VerifyReport *report)
+{
+    int thisAxis;
+
+    memset(report, 0, sizeof(VerifyReport));
+    for (thisAxis = 0; thisAxis < 4; thisAxis++)
+    {
+        report->minimum[thisAxis] = HUGE_VAL;
+        report->maximum[thisAxis] = -HUGE_VAL;
+    }
+    report->minSkew[0] = HUGE_VAL;
+    report->minSkew[1] = HUGE_VAL;
+    report->maxSkew[0] = -HUGE_VAL;
+    report->maxSkew[1] = -HUGE_VAL;
+    report->greatestSkew = -1.0;
+}
+
+
+// Function name: VerifyGCode()
+// Purpose: Reads the program in "filename" (which may be compressed) in one
+//          pass and simulates it against the profile's axis letters and
+//          limits, filling in the report. Returns EXIT_FAILURE, having
+//          reported why with "noJob", only if the file can't be read to
+//          its end; what the program does wrong is left in the report.
+//
+int VerifyGCode(const char *filename, const Dialect *dialect, VerifyReport *report,
+                const Job *noJob)
+{
+    Simulator simulator;
+    Decompressor *decompressor = NULL;
+    enum Compression compression;
+    FILE *file;
+    char *buffer;
+    char *lineStart;
+    char *lineEnd;
+    size_t length = 0;
+    size_t fresh;
+    int endOfFile = 0;
+    int skipping = 0;       // Nonzero in the middle of a line too long to read
+    int thisAxis;
+    int result = EXIT_SUCCESS;
+
+    InitializeReport(report);
+    memset(&simulator, 0, sizeof(Simulator));
+    simulator.dialect = dialect;
+    simulator.report = report;
+    simulator.motion = -1;
+    memset(simulator.axis, -1, sizeof(simulator.axis));
+    for (thisAxis = 0; thisAxis < 4; thisAxis++)
+    {
+        simulator.axis[(unsigned char)dialect->axis[thisAxis]] = (signed char)thisAxis;
+    }
+
+    file = fopen(filename, READONLY);
+    if (file == NULL)
+    {
+        ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_VERIFY_OPENERROR, filename);
+        return(EXIT_FAILURE);
+    }
+    buffer = (char *)malloc(VERIFY_BUFFER_SIZE);
+    if (buffer == NULL)
+    {
+        fclose(file);
+        ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+        return(EXIT_FAILURE);
+    }
+    // Blocks are read straight into the buffer
+    setvbuf(file, NULL, _IONBF, 0);
+
+    // A compressed program is recognised by its first bytes
+    length = fread(buffer, 1, DECOMPRESS_BUFFER_SIZE, file);
+    compression = DetectCompression(buffer, length);
+    if (compression != CompressionNone)
+    {
+        decompressor = OpenDecompressor(file, compression, buffer, length);
+        length = 0;
+        if (decompressor == NULL)
+        {
+            ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_FILE_COMPRESSIONERROR, filename,
+                          CompressionName[compression]);
+            result = EXIT_FAILURE;
+            endOfFile = 1;
+        }
+    }
+    else
+    {
+        report->bytesRead = (long long)length;
+        endOfFile = (length < DECOMPRESS_BUFFER_SIZE);
+    }
+
+    for (;;)
+    {
+        // Top the buffer up after whatever is left of the last line
+        if (!endOfFile)
+        {
+            if (decompressor != NULL)
+            {
+                fresh = Decompress(decompressor, buffer + length, VERIFY_BUFFER_SIZE - length);
+            }
+            else
+            {
+                fresh = fread(buffer + length, 1, VERIFY_BUFFER_SIZE - length, file);
+            }
+            length += fresh;
+            report->bytesRead += (long long)fresh;
+            endOfFile = (length < VERIFY_BUFFER_SIZE);
+        }
+
+        // Every whole line, and at the end of the file whatever is left
+        lineStart = buffer;
+        for (;;)
+        {
+            lineEnd = memchr(lineStart, '\n', buffer + length - lineStart);
+            if (lineEnd == NULL)
+            {
+                if (!endOfFile && lineStart == buffer && length > 0)
+                {
+                    // No G-code line is longer than the buffer: it isn't one
+                    if (!skipping)
+                    {
+                        simulator.line = ++report->totalLines;
+                        if (report->badLines == 0)
+                        {
+                            report->firstBadLine = simulator.line;
+                        }
+                        report->badLines++;
+                    }
+                    skipping = 1;
+                    lineStart = buffer + length;
+                    break;
+                }
+                else if (endOfFile && lineStart < buffer + length)
+                {
+                    lineEnd = buffer + length;
+                }
+                else
+                {
+                    break;
+                }
+            }
+            if (skipping)
+            {
+                // The rest of the line that was too long
+                skipping = 0;
+            }
+            else
+            {
+                simulator.line = ++report->totalLines;
+                SimulateLine(&simulator, lineStart, lineEnd);
+            }
+            lineStart = (lineEnd < buffer + length) ? lineEnd + 1 : lineEnd;
+        }
+
+        length -= (size_t)(lineStart - buffer);
+        memmove(buffer, lineStart, length);
+        if (endOfFile)
+        {
+            break;
+        }
+    }
+
+    if (decompressor != NULL)
+    {
+        if (decompressor->damaged)
+        {
+            ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_FILE_DAMAGEDERROR, filename);
+            result = EXIT_FAILURE;
+        }
+        CloseDecompressor(decompressor);
+    }
+    else if (ferror(file))
+    {
+        ReportMessage(noJob, MESSAGE_ERROR, MESSAGE_VERIFY_OPENERROR, filename);
+        result = EXIT_FAILURE;
+    }
+    free(buffer);
+    fclose(file);
+
+    return(result);
+}
+
+
+// Function name: RunVerify()
+// Purpose: Reads back the program in "filename" and prints what it does:
+//          the range of each axis against the profile's limits, the wire
+//          skew, and the cut time. Returns EXIT_FAILURE if it can't be
+//          read, any line couldn't be understood, or the wire leaves the
+//          cutter's limits.
+//
+int RunVerify(const char *filename, const Settings *settings)
+{
+    const Dialect *dialect = &settings->dialect;
+    VerifyReport report;
+    Job noJob;
+    double limit[2];
+    int thisAxis;
+    int result;
+
+    InitializeJob(&noJob, NULL, settings);
+    result = VerifyGCode(filename, dialect, &report, &noJob);
+    if (result != EXIT_SUCCESS)
+    {
+        return(result);
+    }
+
+    printf(MESSAGE_VERIFY_SUMMARY, filename, report.totalLines, report.bytesRead,
+           report.cuttingMoves, report.arcMoves, report.rapidMoves);
+    for (thisAxis = 0; thisAxis < 4 && report.cuttingMoves + report.rapidMoves > 0; thisAxis++)
+    {
+        limit[0] = (thisAxis % 2 == 0) ? dialect->xMin : dialect->yMin;
+        limit[1] = (thisAxis % 2 == 0) ? dialect->xMax : dialect->yMax;
+        printf(MESSAGE_VERIFY_AXIS, dialect->axis[thisAxis], report.minimum[thisAxis],
+               report.maximum[thisAxis], limit[0], limit[1]);
+    }
+    if (report.cuttingMoves + report.rapidMoves > 0)
+    {
+        printf(MESSAGE_VERIFY_SKEW, dialect->axis[2], dialect->axis[0], report.minSkew[0],
+               report.maxSkew[0], dialect->axis[3], dialect->axis[1], report.minSkew[1],
+               report.maxSkew[1], report.greatestSkew, report.greatestSkewLine);
+    }
+    printf(MESSAGE_VERIFY_TIME, report.cutTime, report.cutLength, report.rapidLength);
+    fflush(stdout);
+
+    if (report.unfedMoves > 0)
+    {
+        ReportMessage(&noJob, MESSAGE_WARNING, MESSAGE_VERIFY_FEEDWARNING, report.unfedMoves);
+    }
+    if (report.badLines > 0)
+    {
+        ReportMessage(&noJob, MESSAGE_ERROR, MESSAGE_VERIFY_LINEERROR, report.badLines,
+                      filename, report.firstBadLine);
+        result = EXIT_FAILURE;
+    }
+    if (report.violations > 0)
+    {
+        ReportMessage(&noJob, MESSAGE_ERROR, MESSAGE_VERIFY_LIMITERROR, filename,
+                      report.violations, report.firstViolation,
+                      dialect->axis[report.violationAxis]);
+        result = EXIT_FAILURE;
+    }
+
+    return(result);
+}
+
+
+// --- End of verify.c
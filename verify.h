@@ -0,0 +1,80 @@
+// verify.h
+//
+// Verification: the envelope check run before a job is written, and the
+// G-code reader that simulates a finished program (see verify.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef VERIFY_H        // Don't define everything more than once
+#define VERIFY_H        //
+
+
+#include "gcode.h"
+
+
+// Bytes of the program read at a time
+#define VERIFY_BUFFER_SIZE (1024 * 1024)
+
+// How far past a limit a coordinate may be before it counts: half of the
+// last digit written (see FormatFixed())
+#define VERIFY_TOLERANCE 0.0000005
+
+
+// What reading back a program found. Axes are in X, Y, U, V order (the
+// profile's letters), in the program's units.
+typedef struct
+{
+    long long bytesRead;    // Bytes of the program, decompressed
+    long long totalLines;   // Lines read
+    long long badLines;     // Lines with a word that isn't a letter and
+    long long firstBadLine; //   a number, and the first of them (from 1)
+    long long cuttingMoves; // G1, G2 and G3 moves
+    long long arcMoves;     //   of which arcs
+    long long rapidMoves;   // G0 moves
+    long long unfedMoves;   // Cutting moves before any F word
+    double minimum[4];      // Furthest the wire went along each axis,
+    double maximum[4];      //   arcs included
+    long long violations;   // Moves that leave the cutter's limits,
+    long long firstViolation; //   the line of the first one
+    int violationAxis;      //   and the axis it left them on
+    double minSkew[2];      // Least and greatest U - X and V - Y: how far
+    double maxSkew[2];      //   the tip end is from the root end
+    double greatestSkew;    // Greatest distance between the two ends, in
+    long long greatestSkewLine; //   the X/Y plane, and where it was
+    double cutLength;       // Combined X, Y, U, V length of the cutting
+    double rapidLength;     //   moves, and of the rapid ones
+    double cutTime;         // Minutes the cutting moves take at their feeds
+    int units;              // 20 (inches) or 21 (mm) if the program says
+} VerifyReport;
+
+
+// Function prototypes
+void FindRange(const float *value, int totalValues, float *minimum, float *maximum);
+int CheckEnvelope(Job *job);
+int VerifyGCode(const char *filename, const Dialect *dialect, VerifyReport *report,
+                const Job *noJob);
+int RunVerify(const char *filename, const Settings *settings);
+
+
+#endif
+// --- End of verify.h
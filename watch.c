@@ -0,0 +1,386 @@
+// watch.c
+//
+// Watch mode: regenerates the output whenever an input file changes,
+// re-rendering only the airfoil half that changed (see watch.h)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+//
+// The job folder is watched with inotify. Each half of the output (its
+// moves and the feed line after them) is kept in memory as it was last
+// rendered. When files of one half are written or renamed into place, only
+// that half is read, resampled, placed, reduced and rendered again. While
+// the folder holds a section file, any change redoes both. The output file is then put together
+// from the profile's blocks and the two halves with a single writev() into
+// a temporary file, which is renamed over the output, so a program
+// watching OUTPUT.txt never sees it part way written.
+//
+// A half that can't be rendered (a file half written, a value that isn't
+// a number) is reported and the output is left alone until it can be.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "watch.h"
+#include "emit.h"
+#include "pool.h"
+#include "section.h"
+
+
+// The pieces of the output file, in order
+#define TOTAL_PIECES 5
+
+
+// One half of the output as it was last rendered
+typedef struct
+{
+    TextBuffer rendered;    // Its G-code
+    int valid;              // Nonzero if it rendered without error
+    double constantTime;    // Minutes its moves take at the profile's feed,
+    double plannedTime;     //   and at the planned feeds (see feed.c)
+} HalfText;
+
+
+static volatile sig_atomic_t stopRequested = 0;
+
+
+
+// Function name: StopWatching()
+// Purpose: The SIGINT and SIGTERM handler.
+//
+static void StopWatching(int signalNumber)
+{
+    (void)signalNumber;
+    stopRequested = 1;
+}
+
+
+// Function name: ReadClock()
+// Purpose: Returns a monotonic time in milliseconds.
+//
+static double ReadClock(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return(now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0);
+}
+
+
+// Function name: RenderHalves()
+// Purpose: Loads and renders again the halves marked in "changed", leaving
+//          the others as they are, and notes the time each one's moves
+//          take. "storage" is the OUTPUT_BUFFER_SIZE bytes the text is
+//          collected in on its way to a half.
+//
+static void RenderHalves(const char *directory, const Settings *settings,
+                         const int changed[TOTAL_HALVES], HalfText half[TOTAL_HALVES],
+                         char *storage)
+{
+    enum Half thisHalf;
+
+    Job job;
+    OutputBuffer output;
+    double constantTime;
+    double plannedTime;
+    int result;
+
+    InitializeJob(&job, directory, settings);
+    job.threads = (settings->totalThreads > 0) ? settings->totalThreads :
+                                                     PoolDefaultThreads();
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        job.skipHalf[thisHalf] = !changed[thisHalf];
+    }
+
+    result = LoadVectorData(&job);
+    if (result == EXIT_SUCCESS)
+    {
+        result = BuildToolPaths(&job);
+    }
+
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        if (!changed[thisHalf])
+        {
+            continue;
+        }
+        half[thisHalf].rendered.length = 0;
+        half[thisHalf].valid = 0;
+        if (result != EXIT_SUCCESS)
+        {
+            continue;
+        }
+
+        OpenOutputSink(&output, TakeText, &half[thisHalf].rendered, &settings->dialect,
+                       storage);
+        // The planner's totals start over with the upper half and carry on
+        // into the lower one
+        constantTime = (thisHalf == Lower) ? job.planner.constantTime : 0.0;
+        plannedTime = (thisHalf == Lower) ? job.planner.plannedTime : 0.0;
+        result = EmitHalf(&job, &output, thisHalf);
+        half[thisHalf].constantTime = job.planner.constantTime - constantTime;
+        half[thisHalf].plannedTime = job.planner.plannedTime - plannedTime;
+        if (CloseOutputBuffer(&output) != EXIT_SUCCESS && result == EXIT_SUCCESS)
+        {
+            ReportMessage(&job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+            result = EXIT_FAILURE;
+        }
+        half[thisHalf].valid = (result == EXIT_SUCCESS);
+    }
+
+    FreeMemory(&job);
+    CloseDataFiles(&job);
+}
+
+
+// Function name: ReplaceOutput()
+// Purpose: Puts the output file together from the profile's blocks and the
+//          two halves (see WriteOutputPieces()).
+//
+static int ReplaceOutput(const Job *job, const HalfText half[TOTAL_HALVES])
+{
+    const Dialect *dialect = &job->settings->dialect;
+    struct iovec piece[TOTAL_PIECES];
+
+    piece[0].iov_base = dialect->block[Header];
+    piece[0].iov_len = dialect->blockLength[Header];
+    piece[1].iov_base = half[Upper].rendered.text;
+    piece[1].iov_len = half[Upper].rendered.length;
+    piece[2].iov_base = dialect->block[Transition];
+    piece[2].iov_len = dialect->blockLength[Transition];
+    piece[3].iov_base = half[Lower].rendered.text;
+    piece[3].iov_len = half[Lower].rendered.length;
+    piece[4].iov_base = dialect->block[Footer];
+    piece[4].iov_len = dialect->blockLength[Footer];
+
+    return(WriteOutputPieces(job, piece, TOTAL_PIECES));
+}
+
+
+// Function name: NoteChange()
+// Purpose: Marks the halves that a change to the file "name" affects,
+//          which may be an input file compressed under its own name plus a
+//          suffix (see FindVectorFile()). Files that aren't inputs of the
+//          job are ignored.
+//
+static void NoteChange(const char *name, int changed[TOTAL_HALVES])
+{
+    enum Side thisSide;
+    enum Half thisHalf;
+    enum Dimension thisDimension;
+    enum Compression format;
+
+    Job bare;
+    char filename[MAX_PATH_LENGTH];
+    size_t length;
+
+    if (strcmp(name, SECTION_FILENAME) == 0)
+    {
+        changed[Upper] = 1;
+        changed[Lower] = 1;
+        return;
+    }
+
+    // Names without a folder, to compare with
+    InitializeJob(&bare, NULL, NULL);
+    for (thisSide = Root; thisSide <= Tip; thisSide++)
+    {
+        for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+        {
+            for (thisDimension = X; thisDimension <= Y; thisDimension++)
+            {
+                BuildVectorFilename(&bare, thisSide, thisHalf, thisDimension, filename);
+                length = strlen(filename);
+                if (strncmp(name, filename, length) != 0)
+                {
+                    continue;
+                }
+                for (format = CompressionNone; format < TOTAL_COMPRESSIONS; format++)
+                {
+                    if (strcmp(name + length, CompressionSuffix[format]) == 0)
+                    {
+                        changed[thisHalf] = 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+// Function name: WaitForChanges()
+// Purpose: Waits for input files to change, then takes every event already
+//          queued, so that a burst of writes is handled at once. Returns
+//          nonzero if any half changed, or zero if watching was stopped.
+//
+static int WaitForChanges(int notifier, int changed[TOTAL_HALVES])
+{
+    static char events[WATCH_EVENT_BUFFER]
+      __attribute__((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *event;
+    struct pollfd polled;
+    ssize_t length;
+    ssize_t position;
+    int timeout;
+
+    changed[Upper] = 0;
+    changed[Lower] = 0;
+    polled.fd = notifier;
+    polled.events = POLLIN;
+
+    // Other files in the folder (the output among them) change too
+    while (!stopRequested && !changed[Upper] && !changed[Lower])
+    {
+        timeout = -1;
+        while (poll(&polled, 1, timeout) > 0)
+        {
+            length = read(notifier, events, sizeof(events));
+            if (length <= 0)
+            {
+                break;
+            }
+            for (position = 0; position < length;
+                 position += sizeof(struct inotify_event) + event->len)
+            {
+                event = (const struct inotify_event *)(events + position);
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    // Events were lost, so anything may have changed
+                    changed[Upper] = 1;
+                    changed[Lower] = 1;
+                }
+                else if (event->len > 0)
+                {
+                    NoteChange(event->name, changed);
+                }
+            }
+
+            // Take what is queued already, without waiting for more
+            timeout = 0;
+        }
+    }
+
+    return(changed[Upper] || changed[Lower]);
+}
+
+
+// Function name: RunWatch()
+// Purpose: Writes the job's output, then writes it again every time its
+//          input files change, until SIGINT or SIGTERM. Returns
+//          EXIT_FAILURE if the folder can't be watched.
+//
+int RunWatch(const char *directory, const Settings *settings)
+{
+    enum Half thisHalf;
+
+    HalfText half[TOTAL_HALVES];
+    int changed[TOTAL_HALVES] = { 1, 1 };
+    struct sigaction action;
+    Job job;
+    char *storage;
+    double start;
+    int notifier;
+
+    InitializeJob(&job, directory, settings);
+    notifier = inotify_init1(IN_CLOEXEC);
+    if (notifier < 0 ||
+        inotify_add_watch(notifier, (directory != NULL) ? directory : ".",
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        ReportMessage(&job, MESSAGE_ERROR, MESSAGE_WATCH_ERROR,
+                      (directory != NULL) ? directory : ".", strerror(errno));
+        if (notifier >= 0)
+        {
+            close(notifier);
+        }
+        return(EXIT_FAILURE);
+    }
+    storage = (char *)malloc(OUTPUT_BUFFER_SIZE);
+    if (storage == NULL)
+    {
+        ReportMessage(&job, MESSAGE_ERROR, MESSAGE_MEMORY_ALLOCERROR);
+        close(notifier);
+        return(EXIT_FAILURE);
+    }
+    memset(half, 0, sizeof(half));
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = StopWatching;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    // Both halves to begin with, then whichever changed
+    printf(MESSAGE_WATCH_READY, (directory != NULL) ? directory : ".");
+    fflush(stdout);
+    do
+    {
+        // Whether the section or the vector files are read can change with
+        // any one file (see IsSectionCurrent()), so while there is a section
+        // every change redoes both halves
+        if (HasSection(&job))
+        {
+            changed[Upper] = 1;
+            changed[Lower] = 1;
+        }
+        start = ReadClock();
+        RenderHalves(directory, settings, changed, half, storage);
+        if (half[Upper].valid && half[Lower].valid &&
+            ReplaceOutput(&job, half) == EXIT_SUCCESS)
+        {
+            printf(MESSAGE_WATCH_UPDATED, OUTPUT_FILENAME, CompressionSuffix[settings->compression],
+                   (changed[Upper] && changed[Lower]) ? "both halves" :
+                     changed[Upper] ? "the upper half" : "the lower half",
+                   ReadClock() - start);
+            fflush(stdout);
+            if (settings->maxWireSpeed > 0.0)
+            {
+                ReportMessage(&job, "", MESSAGE_FEED_SUMMARY,
+                              half[Upper].constantTime + half[Lower].constantTime,
+                              settings->dialect.feedWord,
+                              half[Upper].plannedTime + half[Lower].plannedTime);
+            }
+        }
+    }
+    while (!stopRequested && WaitForChanges(notifier, changed));
+
+    for (thisHalf = Upper; thisHalf <= Lower; thisHalf++)
+    {
+        free(half[thisHalf].rendered.text);
+    }
+    free(storage);
+    close(notifier);
+
+    return(EXIT_SUCCESS);
+}
+
+
+// --- End of watch.c
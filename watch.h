@@ -0,0 +1,42 @@
+// watch.h
+//
+// Watch mode: regenerates the output whenever an input file changes,
+// re-rendering only the airfoil half that changed (see watch.c)
+//
+// Copyright (C) 2010, 2012 Andrew Hanes <andrewjhanes@gmail.com>
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301,
+// USA.
+//
+// See LICENSE for the full license text, or view it here:
+// http://www.gnu.org/licenses/gpl-2.0.html
+//
+
+
+#ifndef WATCH_H         // Don't define everything more than once
+#define WATCH_H         //
+
+#include "gcode.h"
+
+
+#define WATCH_EVENT_BUFFER (64 * 1024)  // Bytes of inotify events read at a time
+
+
+// Function prototypes
+int RunWatch(const char *directory, const Settings *settings);
+
+
+#endif
+// --- End of watch.h